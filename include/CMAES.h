@@ -0,0 +1,278 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CMAES.h
+ */
+
+#ifndef CMAES_H_
+#define CMAES_H_
+
+#include <vector>
+#include <algorithm>
+
+#include "Mathema.h"
+#include "util/Eigen/Dense"
+
+namespace RLLib
+{
+
+  /**
+   * CMA-ES (Hansen, The CMA Evolution Strategy: A Tutorial) for the minimization of f(x), with the
+   * same ask-and-tell protocol as util/cma: samplePopulation(), candidate(k) for k < lambda, then
+   * updateDistribution(fitness). The distribution lives in contiguous Eigen storage, and the
+   * eigendecomposition of C (SelfAdjointEigenSolver) is only refreshed every
+   * lambda / ((c1 + cmu) n 10) generations, i.e., O(n / lambda) amortized.
+   *
+   * The separable variant (sep-CMA-ES, Ros and Hansen 2008) only adapts the diagonal of C: sampling
+   * and updating cost O(n) per candidate, which scales to thousands of parameters.
+   */
+  template<typename T>
+  class CMAES
+  {
+    public:
+      typedef Eigen::Matrix<T, Eigen::Dynamic, 1> VectorX;
+      typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> MatrixX;
+
+    protected:
+      Random<T>* random;
+      int n;
+      int lambda;
+      int mu;
+      bool separable;
+      T sigma;
+      T mueff, cc, cs, c1, cmu, damps, chiN;
+      VectorX xmean;
+      VectorX weights;
+      VectorX pc, ps;
+      MatrixX C, B;
+      VectorX diagC, D;
+      MatrixX arz, ary, arx; // Candidates are columns
+      VectorX z_w, y_w;
+      std::vector<int> ranks;
+      int generation;
+      int eigenGeneration;
+      int nbEigenDecompositions;
+
+    public:
+      CMAES(Random<T>* random, const int& n, const T* xstart, const T& sigma, const int& lambda = 0,
+          const bool& separable = false) :
+          random(random), n(n), lambda(lambda > 0 ? lambda : 4 + int(3.0 * std::log(double(n)))), //
+          mu(0), separable(separable), sigma(sigma), mueff(0), cc(0), cs(0), c1(0), cmu(0), //
+          damps(0), chiN(0), generation(0), eigenGeneration(0), nbEigenDecompositions(0)
+      {
+        ASSERT(n > 0 && sigma > T(0));
+        mu = this->lambda / 2;
+        weights.resize(mu);
+        for (int i = 0; i < mu; i++)
+          weights(i) = std::log(T(mu) + T(0.5)) - std::log(T(i + 1));
+        weights /= weights.sum();
+        mueff = T(1) / weights.squaredNorm();
+
+        cc = (T(4) + mueff / n) / (n + T(4) + T(2) * mueff / n);
+        cs = (mueff + T(2)) / (n + mueff + T(5));
+        c1 = T(2) / ((n + T(1.3)) * (n + T(1.3)) + mueff);
+        cmu = std::min(T(1) - c1,
+            T(2) * (mueff - T(2) + T(1) / mueff) / ((n + T(2)) * (n + T(2)) + mueff));
+        if (separable)
+        {
+          // The diagonal model has n degrees of freedom, instead of n(n+1)/2
+          c1 *= (n + T(2)) / T(3);
+          cmu = std::min(T(1) - c1, cmu * (n + T(2)) / T(3));
+        }
+        damps = T(1) + T(2) * std::max(T(0), std::sqrt((mueff - T(1)) / (n + T(1))) - T(1)) + cs;
+        chiN = std::sqrt(T(n)) * (T(1) - T(1) / (T(4) * n) + T(1) / (T(21) * n * n));
+
+        xmean.resize(n);
+        for (int i = 0; i < n; i++)
+          xmean(i) = xstart ? xstart[i] : T(0);
+        pc = VectorX::Zero(n);
+        ps = VectorX::Zero(n);
+        D = VectorX::Ones(n);
+        if (separable)
+          diagC = VectorX::Ones(n);
+        else
+        {
+          C = MatrixX::Identity(n, n);
+          B = MatrixX::Identity(n, n);
+        }
+        arz.resize(n, this->lambda);
+        ary.resize(n, this->lambda);
+        arx.resize(n, this->lambda);
+        z_w.resize(n);
+        y_w.resize(n);
+        ranks.resize(this->lambda);
+      }
+
+      virtual ~CMAES()
+      {
+      }
+
+      // Samples lambda candidates: x_k = m + sigma B D z_k, with z_k ~ N(0, I)
+      void samplePopulation()
+      {
+        for (int k = 0; k < lambda; k++)
+        {
+          for (int i = 0; i < n; i++)
+            arz(i, k) = random->nextNormalGaussian();
+          if (separable)
+            ary.col(k) = D.cwiseProduct(arz.col(k));
+          else
+            ary.col(k).noalias() = B * D.cwiseProduct(arz.col(k));
+          arx.col(k) = xmean + sigma * ary.col(k);
+        }
+      }
+
+      // Contiguous parameters of the k-th candidate
+      const T* candidate(const int& k) const
+      {
+        ASSERT(k >= 0 && k < lambda);
+        return arx.data() + size_t(k) * n;
+      }
+
+      T* candidate(const int& k)
+      {
+        ASSERT(k >= 0 && k < lambda);
+        return arx.data() + size_t(k) * n;
+      }
+
+      // fitness[k] is the value of candidate(k) to minimize
+      void updateDistribution(const T* fitness)
+      {
+        for (int k = 0; k < lambda; k++)
+          ranks[k] = k;
+        std::sort(ranks.begin(), ranks.end(), CompareFitness(fitness));
+
+        z_w.setZero();
+        y_w.setZero();
+        for (int i = 0; i < mu; i++)
+        {
+          z_w += weights(i) * arz.col(ranks[i]);
+          y_w += weights(i) * ary.col(ranks[i]);
+        }
+        xmean += sigma * y_w;
+
+        // C^{-1/2} y_w = B z_w, since the candidates were sampled with the current B and D
+        const T csn = std::sqrt(cs * (T(2) - cs) * mueff);
+        if (separable)
+          ps = (T(1) - cs) * ps + csn * z_w;
+        else
+          ps = (T(1) - cs) * ps + csn * (B * z_w);
+        ++generation;
+        const T psNorm = ps.norm();
+        const bool hsig = psNorm / std::sqrt(T(1) - std::pow(T(1) - cs, T(2 * generation))) / chiN
+            < T(1.4) + T(2) / (n + T(1));
+        pc = (T(1) - cc) * pc + (hsig ? std::sqrt(cc * (T(2) - cc) * mueff) : T(0)) * y_w;
+
+        const T decay = T(1) - c1 - cmu + (hsig ? T(0) : c1 * cc * (T(2) - cc));
+        if (separable)
+        {
+          diagC = decay * diagC + c1 * pc.cwiseProduct(pc);
+          for (int i = 0; i < mu; i++)
+            diagC += (cmu * weights(i)) * ary.col(ranks[i]).cwiseProduct(ary.col(ranks[i]));
+          D = diagC.cwiseSqrt();
+        }
+        else
+        {
+          // Only the lower triangle is maintained; the solver reads that one
+          C.template triangularView<Eigen::Lower>() *= decay;
+          C.template selfadjointView<Eigen::Lower>().rankUpdate(pc, c1);
+          for (int i = 0; i < mu; i++)
+            C.template selfadjointView<Eigen::Lower>().rankUpdate(ary.col(ranks[i]),
+                cmu * weights(i));
+          if (generation - eigenGeneration > lambda / ((c1 + cmu) * n * T(10)))
+            updateEigensystem();
+        }
+
+        sigma *= std::exp((cs / damps) * (psNorm / chiN - T(1)));
+      }
+
+      void updateEigensystem()
+      {
+        if (separable)
+          return;
+        eigenGeneration = generation;
+        ++nbEigenDecompositions;
+        Eigen::SelfAdjointEigenSolver<MatrixX> solver(C);
+        B = solver.eigenvectors();
+        D = solver.eigenvalues().cwiseMax(T(1e-20)).cwiseSqrt();
+      }
+
+      const VectorX& mean() const
+      {
+        return xmean;
+      }
+
+      T getSigma() const
+      {
+        return sigma;
+      }
+
+      int getLambda() const
+      {
+        return lambda;
+      }
+
+      int getMu() const
+      {
+        return mu;
+      }
+
+      int dimension() const
+      {
+        return n;
+      }
+
+      int getGeneration() const
+      {
+        return generation;
+      }
+
+      int getNbEigenDecompositions() const
+      {
+        return nbEigenDecompositions;
+      }
+
+      bool isSeparable() const
+      {
+        return separable;
+      }
+
+      // Condition of the sampling distribution
+      T axisRatio() const
+      {
+        return D.maxCoeff() / D.minCoeff();
+      }
+
+    private:
+      class CompareFitness
+      {
+        private:
+          const T* fitness;
+        public:
+          CompareFitness(const T* fitness) :
+              fitness(fitness)
+          {
+          }
+
+          bool operator()(const int& a, const int& b) const
+          {
+            return fitness[a] < fitness[b];
+          }
+      };
+  };
+
+} // namespace RLLib
+
+#endif /* CMAES_H_ */
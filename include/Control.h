@@ -65,6 +65,20 @@ namespace RLLib
       }
       virtual void learn(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1,
           const T& r_tp1, const T& z_tp1) = 0;
+      // Samples a_tp1 from the behavior policy without learning; step() is learn() followed by it
+      virtual const Action<T>* sampleAction(const Vector<T>* x_tp1) = 0;
+      // pi_b(a) in the state of the last initialize() or sampleAction(); 1 for the learners that do
+      // not weight their updates by it
+      virtual T behaviorProbability(const Action<T>* a) const
+      {
+        return T(1);
+      }
+      // learn() with pi_b(a_t) as it was when a_t was sampled, for the callers that learn late
+      virtual void learnDeferred(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1,
+          const T& r_tp1, const T& z_tp1, const T& pi_b_t)
+      {
+        learn(x_t, a_t, x_tp1, r_tp1, z_tp1);
+      }
   };
 
   template<typename T>
@@ -95,6 +109,8 @@ namespace RLLib
       virtual void update(const Representations<T>* phi_t, const Action<T>* a_t,
           const T& delta_t) =0;
       virtual PolicyDistribution<T>* policy() const =0;
+      // Updates the policy distribution with phi; actors with lazy parameters synchronize them first
+      virtual void updatePolicy(const Representations<T>* phi) =0;
       virtual const Action<T>* proposeAction(const Representations<T>* phi) =0;
   };
 
@@ -27,6 +27,7 @@
 #include "Policy.h"
 #include "PredictorAlgorithm.h"
 #include "StateToStateAction.h"
+#include "Replay.h"
 
 namespace RLLib
 {
@@ -40,10 +41,12 @@ namespace RLLib
       StateToStateAction<T>* toStateAction;
       Sarsa<T>* sarsa;
       Vector<T>* xa_t;
+      T* actionValues;
 
     public:
       SarsaControl(Policy<T>* acting, StateToStateAction<T>* toStateAction, Sarsa<T>* sarsa) :
-          acting(acting), toStateAction(toStateAction), sarsa(sarsa), xa_t(0)
+          acting(acting), toStateAction(toStateAction), sarsa(sarsa), xa_t(0), //
+          actionValues(new T[toStateAction->getActions()->dimension()])
       {
       }
 
@@ -51,6 +54,7 @@ namespace RLLib
       {
         if (xa_t)
           delete xa_t;
+        delete[] actionValues;
       }
 
       const Action<T>* initialize(const Vector<T>* x)
@@ -90,11 +94,12 @@ namespace RLLib
       {
         const Representations<T>* phis = toStateAction->stateActions(x);
         acting->update(phis);
+        sarsa->predictAll(phis, actionValues);
         T v_s = T(0);
         // V(s) = \sum_{a \in A} \pi(s,a) * Q(s,a)
         for (typename Actions<T>::const_iterator a = toStateAction->getActions()->begin();
             a != toStateAction->getActions()->end(); ++a)
-          v_s += acting->pi(*a) * sarsa->predict(phis->at(*a));
+          v_s += acting->pi(*a) * actionValues[(*a)->id()];
         return v_s;
       }
 
@@ -223,6 +228,11 @@ namespace RLLib
         return q->dot(x);
       }
 
+      void predictAll(const Representations<T>* phis, T* out) const
+      {
+        Predictors::predictAll(q, phis, out);
+      }
+
       T initialize()
       {
         e->clear();
@@ -262,15 +272,18 @@ namespace RLLib
       Policy<T>* behavior;
       StateToStateAction<T>* toStateAction;
       Q<T>* q;
+      T* actionValues;
 
     public:
       QControl(Policy<T>* behavior, StateToStateAction<T>* toStateAction, Q<T>* q) :
-          behavior(behavior), toStateAction(toStateAction), q(q)
+          behavior(behavior), toStateAction(toStateAction), q(q), //
+          actionValues(new T[toStateAction->getActions()->dimension()])
       {
       }
 
       virtual ~QControl()
       {
+        delete[] actionValues;
       }
 
       const Action<T>* initialize(const Vector<T>* x)
@@ -291,6 +304,11 @@ namespace RLLib
           const T& r_tp1, const T& z_tp1)
       {
         learn(x_t, a_t, x_tp1, r_tp1, z_tp1);
+        return sampleAction(x_tp1);
+      }
+
+      const Action<T>* sampleAction(const Vector<T>* x_tp1)
+      {
         return Policies::sampleAction(behavior, toStateAction->stateActions(x_tp1));
       }
 
@@ -308,11 +326,12 @@ namespace RLLib
       {
         const Representations<T>* phis = toStateAction->stateActions(x);
         behavior->update(phis); // ?
+        q->predictAll(phis, actionValues);
         T v_s = T(0);
         // V(s) = \sum_{a \in A} \pi(s,a) * Q(s,a)
         for (typename Actions<T>::const_iterator a = toStateAction->getActions()->begin();
             a != toStateAction->getActions()->end(); ++a)
-          v_s += behavior->pi(*a) * q->predict(phis->at(*a));
+          v_s += behavior->pi(*a) * actionValues[(*a)->id()];
         return v_s;
       }
 
@@ -332,6 +351,248 @@ namespace RLLib
       }
   };
 
+  /**
+   * Q-learning from a replay buffer: every environment step stores the transition, and then
+   * performs nbReplays one-step Q-learning updates on transitions drawn from the buffer, either
+   * uniformly or (priorityExponent > 0) proportionally to |delta|^priorityExponent, with the
+   * importance sampling correction of Schaul et al. (2016). When the buffer stores the active
+   * features, the updates work directly on the raw weights and the projector is not called
+   * again: a step projects x_tp1 once, for the buffer and for a_tp1, and the features of x_t are
+   * those of the previous x_tp1, copied within the buffer. Otherwise, the features are recomputed
+   * from the stored observations.
+   */
+  template<typename T>
+  class ReplayQControl: public OffPolicyControlLearner<T>
+  {
+    protected:
+      Random<T>* random;
+      Policy<T>* behavior;
+      StateToStateAction<T>* toStateAction;
+      Q<T>* q;
+      ReplayBuffer<T>* buffer;
+      SumTree<T>* priorities;
+      T alpha, gamma;
+      int nbReplays;
+      T priorityExponent, importanceExponent;
+      T* actionValues;
+      Vector<T>* x_t;
+      Vector<T>* x_tp1;
+      Vector<T>* phi_sa_t;
+      // The last transition stored, its x_tp1, and its projection while still current
+      int lastSlot;
+      Vector<T>* lastX_tp1;
+      const Representations<T>* phis_tp1;
+
+    public:
+      ReplayQControl(Random<T>* random, Policy<T>* behavior, StateToStateAction<T>* toStateAction,
+          Q<T>* q, ReplayBuffer<T>* buffer, const T& alpha, const T& gamma, const int& nbReplays,
+          const T& priorityExponent = T(0), const T& importanceExponent = T(0)) :
+          random(random), behavior(behavior), toStateAction(toStateAction), q(q), buffer(buffer), //
+          priorities(priorityExponent > T(0) ? new SumTree<T>(buffer->getCapacity()) : 0), //
+          alpha(alpha), gamma(gamma), nbReplays(nbReplays), //
+          priorityExponent(priorityExponent), importanceExponent(importanceExponent), //
+          actionValues(new T[toStateAction->getActions()->dimension()]), //
+          x_t(new PVector<T>(buffer->getObservationDimension())), //
+          x_tp1(new PVector<T>(buffer->getObservationDimension())), phi_sa_t(0), lastSlot(-1), //
+          lastX_tp1(0), phis_tp1(0)
+      {
+        ASSERT(buffer->storesFeatures() || buffer->storesObservations());
+        ASSERT(RTTI<T>::denseVector(q->weights()));
+      }
+
+      virtual ~ReplayQControl()
+      {
+        if (priorities)
+          delete priorities;
+        delete[] actionValues;
+        delete x_t;
+        delete x_tp1;
+        if (phi_sa_t)
+          delete phi_sa_t;
+        if (lastX_tp1)
+          delete lastX_tp1;
+      }
+
+      const Action<T>* initialize(const Vector<T>* x)
+      {
+        q->initialize();
+        lastSlot = -1;
+        phis_tp1 = 0;
+        return Policies::sampleAction(behavior, toStateAction->stateActions(x));
+      }
+
+      void learn(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1, const T& r_tp1,
+          const T& z_tp1)
+      {
+        (void) z_tp1;
+        const int slot = buffer->push(x_t, a_t, x_tp1, r_tp1);
+        phis_tp1 = 0;
+        if (buffer->storesFeatures())
+        {
+          if (lastSlot >= 0 && lastSlot != slot && follows(x_t))
+            buffer->copyFeatures_t(slot, lastSlot, a_t->id());
+          else
+            buffer->setFeatures_t(slot, toStateAction->stateActions(x_t)->at(a_t));
+          // Still current after the replays, which do not project
+          phis_tp1 = toStateAction->stateActions(x_tp1);
+          buffer->setFeatures_tp1(slot, phis_tp1);
+          // The episode ends at an empty x_tp1
+          lastSlot = x_tp1->empty() ? -1 : slot;
+          if (lastSlot >= 0)
+            Vectors<T>::bufferedCopy(x_tp1, lastX_tp1);
+        }
+        if (priorities)
+          priorities->update(slot, priorities->max());
+
+        for (int k = 0; k < nbReplays; k++)
+        {
+          if (!priorities)
+          {
+            replay(random->nextInt(buffer->size()), T(1));
+            continue;
+          }
+          const int index = priorities->sample(random);
+          T weight = T(1);
+          if (importanceExponent > T(0))
+          {
+            // w_i = (N P(i))^-beta, normalized by the largest weight
+            weight = std::pow(priorities->priority(index) / priorities->min(), -importanceExponent);
+          }
+          const T delta = replay(index, weight);
+          priorities->update(index, std::pow(std::abs(delta) + T(1e-6), priorityExponent));
+        }
+      }
+
+      const Action<T>* step(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1,
+          const T& r_tp1, const T& z_tp1)
+      {
+        learn(x_t, a_t, x_tp1, r_tp1, z_tp1);
+        if (phis_tp1)
+          return Policies::sampleAction(behavior, phis_tp1);
+        return sampleAction(x_tp1);
+      }
+
+      const Action<T>* sampleAction(const Vector<T>* x_tp1)
+      {
+        return Policies::sampleAction(behavior, toStateAction->stateActions(x_tp1));
+      }
+
+      void reset()
+      {
+        q->reset();
+        lastSlot = -1;
+        phis_tp1 = 0;
+        buffer->clear();
+        if (priorities)
+          priorities->clear();
+      }
+
+      const Action<T>* proposeAction(const Vector<T>* x)
+      {
+        return Policies::sampleBestAction(behavior, toStateAction->stateActions(x));
+      }
+
+      T computeValueFunction(const Vector<T>* x) const
+      {
+        const Representations<T>* phis = toStateAction->stateActions(x);
+        behavior->update(phis);
+        q->predictAll(phis, actionValues);
+        T v_s = T(0);
+        // V(s) = \sum_{a \in A} \pi(s,a) * Q(s,a)
+        for (typename Actions<T>::const_iterator a = toStateAction->getActions()->begin();
+            a != toStateAction->getActions()->end(); ++a)
+          v_s += behavior->pi(*a) * actionValues[(*a)->id()];
+        return v_s;
+      }
+
+      const Predictor<T>* predictor() const
+      {
+        return q;
+      }
+
+      const ReplayBuffer<T>* replayBuffer() const
+      {
+        return buffer;
+      }
+
+      void persist(const char* f) const
+      {
+        q->persist(f);
+      }
+
+      void resurrect(const char* f)
+      {
+        q->resurrect(f);
+      }
+
+    protected:
+      // Whether x_t is the x_tp1 of the last transition stored
+      bool follows(const Vector<T>* x_t) const
+      {
+        if (lastX_tp1->dimension() != x_t->dimension())
+          return false;
+        for (int i = 0; i < x_t->dimension(); i++)
+        {
+          if (lastX_tp1->getEntry(i) != x_t->getEntry(i))
+            return false;
+        }
+        return true;
+      }
+
+      // One-step Q-learning update on a stored transition; returns the TD error
+      T replay(const int& slot, const T& weight)
+      {
+        if (buffer->storesFeatures())
+          return replayFeatures(slot, weight);
+        return replayObservations(slot, weight);
+      }
+
+      T replayFeatures(const int& slot, const T& weight)
+      {
+        T* w = q->weights()->getValues();
+        T q_tp1 = T(0);
+        if (!buffer->terminal(slot))
+        {
+          for (int a = 0; a < toStateAction->getActions()->dimension(); a++)
+          {
+            const int32_t* phi = buffer->features_tp1(slot, a);
+            T q_a = T(0);
+            for (int i = 1; i <= phi[0]; i++)
+              q_a += w[phi[i]];
+            q_tp1 = (a == 0) ? q_a : std::max(q_tp1, q_a);
+          }
+        }
+        const int32_t* phi_t = buffer->features_t(slot);
+        T q_t = T(0);
+        for (int i = 1; i <= phi_t[0]; i++)
+          q_t += w[phi_t[i]];
+        const T delta = buffer->reward(slot) + gamma * q_tp1 - q_t;
+        const T step = alpha * weight * delta;
+        for (int i = 1; i <= phi_t[0]; i++)
+          w[phi_t[i]] += step;
+        return delta;
+      }
+
+      T replayObservations(const int& slot, const T& weight)
+      {
+        buffer->observation_t(slot, x_t);
+        Vectors<T>::bufferedCopy(
+            toStateAction->stateActions(x_t)->at(toStateAction->getActions()->getEntry(
+                buffer->action(slot))), phi_sa_t);
+        T q_tp1 = T(0);
+        if (!buffer->terminal(slot))
+        {
+          buffer->observation_tp1(slot, x_tp1);
+          const Representations<T>* phis_tp1 = toStateAction->stateActions(x_tp1);
+          q->predictAll(phis_tp1, actionValues);
+          q_tp1 = ActionValues::max(actionValues, phis_tp1->dimension());
+        }
+        const T delta = buffer->reward(slot) + gamma * q_tp1 - q->predict(phi_sa_t);
+        q->weights()->addToSelf(alpha * weight * delta, phi_sa_t);
+        return delta;
+      }
+  };
+
 // Gradient decent control
   template<typename T>
   class GreedyGQ: public OffPolicyControlLearner<T>
@@ -347,12 +608,14 @@ namespace RLLib
       GQ<T>* gq;
       Vector<T>* phi_t;
       Vector<T>* phi_bar_tp1;
+      T* actionValues;
 
     public:
       GreedyGQ(Policy<T>* target, Policy<T>* behavior, Actions<T>* actions,
           StateToStateAction<T>* toStateAction, GQ<T>* gq) :
           rho_t(0), target(target), behavior(behavior), actions(actions), //
-          toStateAction(toStateAction), gq(gq), phi_t(0), phi_bar_tp1(0)
+          toStateAction(toStateAction), gq(gq), phi_t(0), phi_bar_tp1(0), //
+          actionValues(new T[actions->dimension()])
       {
       }
 
@@ -362,6 +625,7 @@ namespace RLLib
           delete phi_t;
         if (phi_t)
           delete phi_bar_tp1;
+        delete[] actionValues;
       }
 
       const Action<T>* initialize(const Vector<T>* x)
@@ -375,18 +639,36 @@ namespace RLLib
         return a;
       }
 
-      virtual T computeRho(const Action<T>* a_t)
+      virtual T computeRho(const Action<T>* a_t, const T& pi_b_t)
       {
-        return target->pi(a_t) / behavior->pi(a_t);
+        return target->pi(a_t) / pi_b_t;
       }
 
       void learn(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1, const T& r_tp1,
           const T& z_tp1)
       {
         const Representations<T>* xas_t = toStateAction->stateActions(x_t);
-        target->update(xas_t);
         behavior->update(xas_t);
-        rho_t = computeRho(a_t);
+        update(xas_t, a_t, x_tp1, r_tp1, z_tp1, behavior->pi(a_t));
+      }
+
+      void learnDeferred(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1,
+          const T& r_tp1, const T& z_tp1, const T& pi_b_t)
+      {
+        update(toStateAction->stateActions(x_t), a_t, x_tp1, r_tp1, z_tp1, pi_b_t);
+      }
+
+      T behaviorProbability(const Action<T>* a) const
+      {
+        return behavior->pi(a);
+      }
+
+    private:
+      void update(const Representations<T>* xas_t, const Action<T>* a_t, const Vector<T>* x_tp1,
+          const T& r_tp1, const T& z_tp1, const T& pi_b_t)
+      {
+        target->update(xas_t);
+        rho_t = computeRho(a_t, pi_b_t);
         Vectors<T>::bufferedCopy(xas_t->at(a_t), phi_t);
 
         const Representations<T>* xas_tp1 = toStateAction->stateActions(x_tp1);
@@ -403,10 +685,16 @@ namespace RLLib
         gq->update(phi_t, phi_bar_tp1, rho_t, r_tp1, z_tp1);
       }
 
+    public:
       const Action<T>* step(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1,
           const T& r_tp1, const T& z_tp1)
       {
         learn(x_t, a_t, x_tp1, r_tp1, z_tp1);
+        return sampleAction(x_tp1);
+      }
+
+      const Action<T>* sampleAction(const Vector<T>* x_tp1)
+      {
         return Policies::sampleAction(behavior, toStateAction->stateActions(x_tp1));
       }
 
@@ -424,10 +712,11 @@ namespace RLLib
       {
         const Representations<T>* phis = toStateAction->stateActions(x);
         target->update(phis);
+        gq->predictAll(phis, actionValues);
         T v_s = T(0);
         // V(s) = \sum_{a \in A} \pi(s,a) * Q(s,a)
         for (typename Actions<T>::const_iterator a = actions->begin(); a != actions->end(); ++a)
-          v_s += target->pi(*a) * gq->predict(phis->at(*a));
+          v_s += target->pi(*a) * actionValues[(*a)->id()];
         return v_s;
       }
 
@@ -459,7 +748,7 @@ namespace RLLib
       virtual ~GQOnPolicyControl()
       {
       }
-      virtual T computeRho(const Action<T>* a_t)
+      virtual T computeRho(const Action<T>* a_t, const T& pi_b_t)
       {
         return T(1);
       }
@@ -550,10 +839,9 @@ namespace RLLib
           const T& delta_t)
       {
         ASSERT(Base::initialized);
-        const Vectors<T>* gradLog = Base::targetPolicy->computeGradLog(phi_t, a_t);
+        Base::targetPolicy->updateTraces(phi_t, a_t, lambda, e_u);
         for (int i = 0; i < e_u->dimension(); i++)
         {
-          e_u->getEntry(i)->update(lambda, gradLog->getEntry(i));
           e_u->getEntry(i)->vect()->mapMultiplyToSelf(rho_t);
           Base::u->getEntry(i)->addToSelf(alpha_u * delta_t, e_u->getEntry(i)->vect());
         }
@@ -607,9 +895,27 @@ namespace RLLib
           const T& z_tp1)
       {
         const Representations<T>* xas_t = toStateAction->stateActions(x_t);
-        actor->policy()->update(xas_t);
         behavior->update(xas_t);
-        rho_t = actor->pi(a_t) / behavior->pi(a_t);
+        update(xas_t, a_t, x_tp1, r_tp1, z_tp1, behavior->pi(a_t));
+      }
+
+      void learnDeferred(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1,
+          const T& r_tp1, const T& z_tp1, const T& pi_b_t)
+      {
+        update(toStateAction->stateActions(x_t), a_t, x_tp1, r_tp1, z_tp1, pi_b_t);
+      }
+
+      T behaviorProbability(const Action<T>* a) const
+      {
+        return behavior->pi(a);
+      }
+
+    private:
+      void update(const Representations<T>* xas_t, const Action<T>* a_t, const Vector<T>* x_tp1,
+          const T& r_tp1, const T& z_tp1, const T& pi_b_t)
+      {
+        actor->policy()->update(xas_t);
+        rho_t = actor->pi(a_t) / pi_b_t;
         ASSERT(Boundedness::checkValue(rho_t));
 
         const Vector<T>* phi_tp1 = projector->project(x_tp1);
@@ -619,10 +925,16 @@ namespace RLLib
         actor->update(xas_t, a_t, rho_t, delta_t);
       }
 
+    public:
       const Action<T>* step(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1,
           const T& r_tp1, const T& z_tp1)
       {
         learn(x_t, a_t, x_tp1, r_tp1, z_tp1);
+        return sampleAction(x_tp1);
+      }
+
+      const Action<T>* sampleAction(const Vector<T>* x_tp1)
+      {
         return Policies::sampleAction(behavior, toStateAction->stateActions(x_tp1));
       }
 
@@ -702,9 +1014,7 @@ namespace RLLib
       void update(const Representations<T>* phi_t, const Action<T>* a_t, const T& delta_t)
       {
         ASSERT(initialized);
-        const Vectors<T>* gradLog = policyDistribution->computeGradLog(phi_t, a_t);
-        for (int i = 0; i < gradLog->dimension(); i++)
-          u->getEntry(i)->addToSelf(alpha_u * delta_t, gradLog->getEntry(i));
+        policyDistribution->addGradLog(phi_t, a_t, alpha_u * delta_t, u);
       }
 
       PolicyDistribution<T>* policy() const
@@ -712,9 +1022,14 @@ namespace RLLib
         return policyDistribution;
       }
 
+      virtual void updatePolicy(const Representations<T>* phi)
+      {
+        policyDistribution->update(phi);
+      }
+
       const Action<T>* proposeAction(const Representations<T>* phi)
       {
-        policy()->update(phi);
+        updatePolicy(phi);
         return policyDistribution->sampleBestAction();
       }
 
@@ -760,15 +1075,19 @@ namespace RLLib
       void update(const Representations<T>* phi_t, const Action<T>* a_t, T delta)
       {
         ASSERT(Base::initialized);
-        const Vectors<T>* gradLog = Base::policy()->computeGradLog(phi_t, a_t);
+        Base::policy()->updateTraces(phi_t, a_t, gamma * lambda, e);
         for (int i = 0; i < Base::u->dimension(); i++)
-        {
-          e->getEntry(i)->update(gamma * lambda, gradLog->getEntry(i));
           Base::u->getEntry(i)->addToSelf(Base::alpha_u * delta, e->getEntry(i)->vect());
-        }
       }
   };
 
+  /**
+   * Natural actor: w holds the weights of the compatible advantage function, and every step
+   * u += alpha_u * w. The step on u is applied lazily: w_j only changes when feature j is active,
+   * so u_j is brought up to date with alpha_u * (nbUpdates - synchronizedAt_j) * w_j when feature
+   * j is read or w_j is about to change. The cost of an update is O(active features) instead of
+   * O(features ever touched). flush() brings all the parameters up to date.
+   */
   template<typename T>
   class ActorNatural: public Actor<T>
   {
@@ -776,12 +1095,19 @@ namespace RLLib
       typedef Actor<T> Base;
       Vectors<T>* w;
       T alpha_v;
+      int nbUpdates;
+      mutable std::vector<std::vector<int> > synchronizedAt;
+
     public:
       ActorNatural(const T& alpha_u, const T& alpha_v, PolicyDistribution<T>* policyDistribution) :
-          Actor<T>(alpha_u, policyDistribution), w(new Vectors<T>()), alpha_v(alpha_v)
+          Actor<T>(alpha_u, policyDistribution), w(new Vectors<T>()), alpha_v(alpha_v), //
+          nbUpdates(0), synchronizedAt(Base::u->dimension())
       {
         for (int i = 0; i < Base::u->dimension(); i++)
+        {
           w->push_back(new SVector<T>(Base::u->getEntry(i)->dimension()));
+          synchronizedAt[i].assign(Base::u->getEntry(i)->dimension(), 0);
+        }
       }
 
       virtual ~ActorNatural()
@@ -801,17 +1127,81 @@ namespace RLLib
           advantageValue += gradLog->getEntry(i)->dot(w->getEntry(i));
         for (int i = 0; i < w->dimension(); i++)
         {
+          // The policy parameters of the features whose advantage weights change
+          synchronize(i, gradLog->getEntry(i));
           // Update the weights of the advantage function
           w->getEntry(i)->addToSelf(alpha_v * (delta - advantageValue), gradLog->getEntry(i));
-          // Update the policy parameters
-          Base::u->getEntry(i)->addToSelf(Base::alpha_u, w->getEntry(i));
         }
+        // u += alpha_u * w, pending until the features are read
+        ++nbUpdates;
+      }
+
+      void updatePolicy(const Representations<T>* phi)
+      {
+        for (int i = 0; i < w->dimension(); i++)
+          for (int a = 0; a < phi->dimension(); a++)
+            synchronize(i, phi->at(a));
+        Base::updatePolicy(phi);
+      }
+
+      void flush() const
+      {
+        for (int i = 0; i < w->dimension(); i++)
+          for (int j = 0; j < w->getEntry(i)->dimension(); j++)
+            synchronize(i, j);
       }
 
       void reset()
       {
         Base::reset();
         w->clear();
+        nbUpdates = 0;
+        for (size_t i = 0; i < synchronizedAt.size(); i++)
+          std::fill(synchronizedAt[i].begin(), synchronizedAt[i].end(), 0);
+      }
+
+      void persist(const char* f) const
+      {
+        flush();
+        Base::persist(f);
+      }
+
+      void resurrect(const char* f)
+      {
+        flush();
+        Base::resurrect(f);
+      }
+
+    private:
+      void synchronize(const int& i, const int& j) const
+      {
+        const int lag = nbUpdates - synchronizedAt[i][j];
+        if (lag > 0)
+        {
+          const T w_ij = w->getEntry(i)->getEntry(j);
+          if (w_ij != T(0))
+            Base::u->getEntry(i)->setEntry(j,
+                Base::u->getEntry(i)->getEntry(j) + Base::alpha_u * lag * w_ij);
+        }
+        synchronizedAt[i][j] = nbUpdates;
+      }
+
+      void synchronize(const int& i, const Vector<T>* phi) const
+      {
+        ASSERT(phi->dimension() == w->getEntry(i)->dimension());
+        const SparseVector<T>* sphi = RTTI<T>::constSparseVector(phi);
+        if (sphi)
+        {
+          const int* indexes = sphi->nonZeroIndexes();
+          for (int k = 0; k < sphi->nonZeroElements(); k++)
+            synchronize(i, indexes[k]);
+        }
+        else
+        {
+          for (int j = 0; j < phi->dimension(); j++)
+            if (phi->getEntry(j) != T(0))
+              synchronize(i, j);
+        }
       }
 
   };
@@ -846,7 +1236,7 @@ namespace RLLib
       void updateActor(const Vector<T>* x_t, const Action<T>* a_t, const T& actorDelta)
       {
         const Representations<T>* phi_t = toStateAction->stateActions(x_t);
-        policy()->update(phi_t);
+        actor->updatePolicy(phi_t);
         actor->update(phi_t, a_t, actorDelta);
       }
 
@@ -865,7 +1255,7 @@ namespace RLLib
       {
         critic->initialize();
         actor->initialize();
-        policy()->update(toStateAction->stateActions(x));
+        actor->updatePolicy(toStateAction->stateActions(x));
         Vectors<T>::bufferedCopy(projector->project(x), phi_t);
         return policy()->sampleAction();
       }
@@ -882,7 +1272,7 @@ namespace RLLib
         T delta_t = updateCritic(x_t, a_t, x_tp1, r_tp1, z_tp1);
         // Update actor
         updateActor(x_t, a_t, delta_t);
-        policy()->update(toStateAction->stateActions(x_tp1));
+        actor->updatePolicy(toStateAction->stateActions(x_tp1));
         return policy()->sampleAction();
       }
 
@@ -0,0 +1,381 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * EvolutionStrategies.h
+ */
+
+#ifndef EVOLUTIONSTRATEGIES_H_
+#define EVOLUTIONSTRATEGIES_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+
+#include "RL.h"
+
+namespace RLLib
+{
+
+  /**
+   * Natural evolution strategies for direct policy search (Salimans et al., "Evolution
+   * strategies as a scalable alternative to reinforcement learning", 2017). Every generation
+   * evaluates nbPairs mirrored perturbations w +/- sigma eps_p, ranks the 2 nbPairs returns into
+   * centered utilities in [-0.5, 0.5], and takes the step
+   * w += alpha / (2 nbPairs sigma) sum_p (u+_p - u-_p) eps_p - alpha weightDecay w.
+   *
+   * eps_p is never stored: it is the Philox stream (seed, generation nbPairs + p), so a worker
+   * only needs the stream id to rebuild it, and only returns are exchanged. One worker runs per
+   * RLProblem in problems, the caller being the first one; the others are threads that live as
+   * long as the trainer and wait on a start/done barrier between the two phases of a generation.
+   * The problems must be independent instances (with their own Random) of the same task. The
+   * perturbations are handed out dynamically, since episode lengths vary.
+   */
+  template<typename T>
+  class EvolutionStrategies
+  {
+    protected:
+      std::vector<RLProblem<T>*> problems;
+      int n;
+      int nbPairs;
+      T sigma;
+      T alpha;
+      T weightDecay;
+      uint64_t seed;
+      int nbEpisodes;
+      int maxEpisodeTimeSteps;
+      PVector<T>* w;
+      // Per worker
+      std::vector<PVector<T>*> perturbed;
+      std::vector<PVector<T>*> gradients;
+      std::vector<std::vector<T> > noises;
+      // Per perturbation, [w + sigma eps_p, w - sigma eps_p]
+      std::vector<T> returns;
+      std::vector<T> utilities;
+      std::vector<int> ranks;
+      std::atomic<int> nextPair;
+      int generation;
+      T meanReturn;
+      // Workers
+      std::vector<std::thread*> workerThreads;
+      std::mutex mutex;
+      std::condition_variable startCondition;
+      std::condition_variable doneCondition;
+      void (EvolutionStrategies::*task)(const int&);
+      int round;
+      int nbDone;
+      bool stopping;
+
+    public:
+      EvolutionStrategies(const std::vector<RLProblem<T>*>& problems, const int& n,
+          const int& nbPairs, const T& sigma, const T& alpha, const T& weightDecay = T(0),
+          const uint64_t& seed = 0, const int& nbEpisodes = 1,
+          const int& maxEpisodeTimeSteps = 1000) :
+          problems(problems), n(n), nbPairs(nbPairs), sigma(sigma), alpha(alpha), //
+          weightDecay(weightDecay), seed(seed), nbEpisodes(nbEpisodes), //
+          maxEpisodeTimeSteps(maxEpisodeTimeSteps), w(new PVector<T>(n)), //
+          returns(2 * nbPairs), utilities(2 * nbPairs), ranks(2 * nbPairs), nextPair(0), //
+          generation(0), meanReturn(0), task(0), round(0), nbDone(0), stopping(false)
+      {
+        ASSERT(!problems.empty() && n > 0 && nbPairs > 0 && sigma > T(0));
+        for (size_t k = 0; k < problems.size(); k++)
+        {
+          perturbed.push_back(new PVector<T>(n));
+          gradients.push_back(new PVector<T>(n));
+          noises.push_back(std::vector<T>(n));
+        }
+        for (int k = 1; k < int(problems.size()); k++)
+          workerThreads.push_back(new std::thread(&EvolutionStrategies::work, this, k));
+      }
+
+      virtual ~EvolutionStrategies()
+      {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          stopping = true;
+        }
+        startCondition.notify_all();
+        for (size_t k = 0; k < workerThreads.size(); k++)
+        {
+          workerThreads[k]->join();
+          delete workerThreads[k];
+        }
+        delete w;
+        for (size_t k = 0; k < problems.size(); k++)
+        {
+          delete perturbed[k];
+          delete gradients[k];
+        }
+      }
+
+      // The action of the policy with parameters theta, from the observation of problem
+      virtual const Action<T>* policy(RLProblem<T>* problem, const Vector<T>* theta,
+          const Vector<T>* o_tp1) const =0;
+
+      // One generation; returns the mean return of the perturbations
+      T update()
+      {
+        nextPair = 0;
+        runWorkers(&EvolutionStrategies::evaluateWorker);
+
+        // Centered ranks, insensitive to the scale and to the outliers of the returns
+        const int size = 2 * nbPairs;
+        meanReturn = T(0);
+        for (int i = 0; i < size; i++)
+        {
+          ranks[i] = i;
+          meanReturn += returns[i];
+        }
+        meanReturn /= size;
+        std::sort(ranks.begin(), ranks.end(), CompareReturns(&returns[0]));
+        for (int i = 0; i < size; i++)
+          utilities[ranks[i]] = (size > 1) ? T(i) / T(size - 1) - T(0.5) : T(0);
+
+        // Each worker rebuilds the noise of its share of the pairs into its own gradient
+        runWorkers(&EvolutionStrategies::gradientWorker);
+        const T scale = alpha / (T(2 * nbPairs) * sigma);
+        T* values = w->getValues();
+        for (int i = 0; i < n; i++)
+          values[i] *= (T(1) - alpha * weightDecay);
+        for (size_t k = 0; k < gradients.size(); k++)
+          w->addToSelf(scale, gradients[k]);
+        ++generation;
+        return meanReturn;
+      }
+
+      // Mean return of theta over nbEpisodes, with the first problem
+      T evaluate(const Vector<T>* theta)
+      {
+        return evaluate(problems[0], theta);
+      }
+
+      Vector<T>* weights() const
+      {
+        return w;
+      }
+
+      int dimension() const
+      {
+        return n;
+      }
+
+      int getGeneration() const
+      {
+        return generation;
+      }
+
+      int getNbPairs() const
+      {
+        return nbPairs;
+      }
+
+      int getNbWorkers() const
+      {
+        return int(problems.size());
+      }
+
+      // Stream of eps_p at the current generation, which is all a worker needs to rebuild it
+      uint64_t noiseStream(const int& pair) const
+      {
+        return uint64_t(generation) * uint64_t(nbPairs) + uint64_t(pair);
+      }
+
+      void noise(const uint64_t& stream, T* eps) const
+      {
+        Random<T> random(seed, stream);
+        random.nextNormalGaussians(eps, n);
+      }
+
+      void persist(const char* f) const
+      {
+        w->persist(f);
+      }
+
+      void resurrect(const char* f)
+      {
+        w->resurrect(f);
+      }
+
+    protected:
+      T evaluate(RLProblem<T>* problem, const Vector<T>* theta)
+      {
+        T result = T(0);
+        for (int episode = 0; episode < nbEpisodes; episode++)
+        {
+          problem->initialize();
+          problem->updateTuple();
+          for (int timeStep = 0; timeStep < maxEpisodeTimeSteps; timeStep++)
+          {
+            problem->step(policy(problem, theta, problem->getTRStep()->o_tp1));
+            problem->updateTuple();
+            const TRStep<T>* step = problem->getTRStep();
+            result += step->r_tp1;
+            if (step->endOfEpisode)
+            {
+              result += step->z_tp1;
+              break;
+            }
+          }
+        }
+        return result / nbEpisodes;
+      }
+
+      void evaluateWorker(const int& k)
+      {
+        T* eps = &noises[k][0];
+        PVector<T>* theta = perturbed[k];
+        for (int p = nextPair++; p < nbPairs; p = nextPair++)
+        {
+          noise(noiseStream(p), eps);
+          const T* values = w->getValues();
+          T* thetaValues = theta->getValues();
+          for (int i = 0; i < n; i++)
+            thetaValues[i] = values[i] + sigma * eps[i];
+          returns[2 * p] = evaluate(problems[k], theta);
+          for (int i = 0; i < n; i++)
+            thetaValues[i] = values[i] - sigma * eps[i];
+          returns[2 * p + 1] = evaluate(problems[k], theta);
+        }
+      }
+
+      void gradientWorker(const int& k)
+      {
+        T* eps = &noises[k][0];
+        T* g = gradients[k]->getValues();
+        std::fill(g, g + n, T(0));
+        for (int p = k; p < nbPairs; p += int(problems.size()))
+        {
+          const T u = utilities[2 * p] - utilities[2 * p + 1];
+          if (u == T(0))
+            continue;
+          noise(noiseStream(p), eps);
+          for (int i = 0; i < n; i++)
+            g[i] += u * eps[i];
+        }
+      }
+
+      void runWorkers(void (EvolutionStrategies::*worker)(const int&))
+      {
+        if (workerThreads.empty())
+        {
+          (this->*worker)(0);
+          return;
+        }
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          task = worker;
+          nbDone = 0;
+          ++round;
+        }
+        startCondition.notify_all();
+        (this->*worker)(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (nbDone < int(workerThreads.size()))
+          doneCondition.wait(lock);
+      }
+
+      void work(const int k)
+      {
+        int seen = 0;
+        for (;;)
+        {
+          void (EvolutionStrategies::*current)(const int&);
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopping && round == seen)
+              startCondition.wait(lock);
+            if (stopping)
+              return;
+            seen = round;
+            current = task;
+          }
+          (this->*current)(k);
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++nbDone;
+          }
+          doneCondition.notify_one();
+        }
+      }
+
+    private:
+      class CompareReturns
+      {
+        private:
+          const T* values;
+        public:
+          CompareReturns(const T* values) :
+              values(values)
+          {
+          }
+
+          bool operator()(const int& a, const int& b) const
+          {
+            return values[a] < values[b];
+          }
+      };
+  };
+
+  /**
+   * Deterministic linear policy on the first continuous action: each of its dimensions is an
+   * affine function of the observation, with dimension() * (nbVars + 1) weights in total.
+   */
+  template<typename T>
+  class LinearPolicyEvolutionStrategies: public EvolutionStrategies<T>
+  {
+    private:
+      typedef EvolutionStrategies<T> Base;
+      int nbVars;
+      int nbOutputs;
+
+    public:
+      LinearPolicyEvolutionStrategies(const std::vector<RLProblem<T>*>& problems,
+          const int& nbPairs, const T& sigma, const T& alpha, const T& weightDecay = T(0),
+          const uint64_t& seed = 0, const int& nbEpisodes = 1,
+          const int& maxEpisodeTimeSteps = 1000) :
+          Base(problems,
+              problems[0]->getContinuousActions()->getEntry(0)->dimension()
+                  * (problems[0]->dimension() + 1), nbPairs, sigma, alpha, weightDecay, seed,
+              nbEpisodes, maxEpisodeTimeSteps), //
+          nbVars(problems[0]->dimension()), //
+          nbOutputs(problems[0]->getContinuousActions()->getEntry(0)->dimension())
+      {
+      }
+
+      virtual ~LinearPolicyEvolutionStrategies()
+      {
+      }
+
+      const Action<T>* policy(RLProblem<T>* problem, const Vector<T>* theta,
+          const Vector<T>* o_tp1) const
+      {
+        const T* values = theta->getValues();
+        for (int j = 0; j < nbOutputs; j++)
+        {
+          const T* row = values + j * (nbVars + 1);
+          T a = row[nbVars];
+          for (int i = 0; i < nbVars; i++)
+            a += row[i] * o_tp1->getEntry(i);
+          problem->getContinuousActions()->update(0, j, a);
+        }
+        return problem->getContinuousActions()->getEntry(0);
+      }
+  };
+
+} // namespace RLLib
+
+#endif /* EVOLUTIONSTRATEGIES_H_ */
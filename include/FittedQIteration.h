@@ -0,0 +1,455 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * FittedQIteration.h
+ */
+
+#ifndef FITTEDQITERATION_H_
+#define FITTEDQITERATION_H_
+
+#include <thread>
+
+#include "RL.h"
+#include "Control.h"
+#include "Predictor.h"
+#include "StateToStateAction.h"
+#include "util/TreeFitted/ExtraTreeEnsemble.h"
+
+/**
+ * Batch fitted Q-iteration (Ernst, Geurts and Wehenkel, 2005) with extremely randomized trees.
+ * This header depends on util/TreeFitted, hence it is not included by the rest of the library.
+ */
+namespace RLLib
+{
+
+  /**
+   * The observation followed by the id of the action. FittedQ does not regress on the id: it
+   * selects the ensemble of the action, and the trees only see the observation.
+   */
+  template<typename T>
+  class StateActionTuple: public StateToStateAction<T>
+  {
+    protected:
+      int nbVars;
+      Actions<T>* actions;
+      Representations<T>* phis;
+      Vector<T>* phi;
+
+    public:
+      StateActionTuple(const int& nbVars, Actions<T>* actions) :
+          nbVars(nbVars), actions(actions), phis(new Representations<T>(nbVars + 1, actions)), //
+          phi(new PVector<T>(nbVars + 1))
+      {
+      }
+
+      virtual ~StateActionTuple()
+      {
+        delete phis;
+        delete phi;
+      }
+
+      const Vector<T>* stateAction(const Vector<T>* x, const Action<T>* a)
+      {
+        ASSERT(x->dimension() == nbVars);
+        for (int i = 0; i < nbVars; i++)
+          phi->setEntry(i, x->getEntry(i));
+        phi->setEntry(nbVars, a->id());
+        return phi;
+      }
+
+      const Representations<T>* stateActions(const Vector<T>* x)
+      {
+        for (typename Actions<T>::const_iterator a = actions->begin(); a != actions->end(); ++a)
+          phis->set(stateAction(x, *a), *a);
+        return phis;
+      }
+
+      const Actions<T>* getActions() const
+      {
+        return actions;
+      }
+
+      T vectorNorm() const
+      {
+        return T(1);
+      }
+
+      int dimension() const
+      {
+        return nbVars + 1;
+      }
+  };
+
+  /**
+   * Q(s,a) given by one ensemble of extremely randomized trees per action, which keeps the
+   * actions apart even where their values are close. The inputs are StateActionTuple vectors,
+   * whose last entry selects the ensemble. The trees are not linear, so weights() returns 0.
+   */
+  template<typename T>
+  class FittedQ: public Predictor<T>
+  {
+    protected:
+      int nbVars;
+      unsigned int nbThreads;
+      std::vector<PoliFitted::ExtraTreeEnsemble*> ensembles;
+      mutable PoliFitted::Tuple input;
+      bool fitted;
+
+    public:
+      FittedQ(const int& nbVars, const int& nbActions, const int& nbTrees = 50,
+          const int& nbSplits = 5, const int& nMin = 2, const unsigned int& nbThreads = 1) :
+          nbVars(nbVars), nbThreads(std::max(nbThreads, 1u)), input(nbVars), fitted(false)
+      {
+        for (int a = 0; a < nbActions; a++)
+          ensembles.push_back(
+              new PoliFitted::ExtraTreeEnsemble(nbVars, 1, nbTrees, nbSplits, nMin));
+      }
+
+      virtual ~FittedQ()
+      {
+        for (std::vector<PoliFitted::ExtraTreeEnsemble*>::iterator iter = ensembles.begin();
+            iter != ensembles.end(); ++iter)
+          delete *iter;
+      }
+
+      // datasets[a] holds the samples of the action a
+      void fit(const std::vector<PoliFitted::Dataset*>& datasets)
+      {
+        ASSERT(datasets.size() == ensembles.size());
+        for (size_t a = 0; a < ensembles.size(); a++)
+        {
+          // New trees each time, the previous ones fitted the previous targets
+          ensembles[a]->Initialize();
+          if (!datasets[a]->empty())
+            ensembles[a]->Train(datasets[a]);
+        }
+        fitted = true;
+      }
+
+      bool isFitted() const
+      {
+        return fitted;
+      }
+
+      // Q(s,a) of a batch of observations, the batch is split among the threads
+      void evaluate(const int& action, const std::vector<PoliFitted::Tuple*>& batch,
+          float* out) const
+      {
+        if (!fitted)
+          std::fill(out, out + batch.size(), 0.0f);
+        else
+          ensembles[action]->Evaluate(batch, out, nbThreads);
+      }
+
+      T predict(const Vector<T>* x) const
+      {
+        ASSERT(x->dimension() == nbVars + 1);
+        if (!fitted)
+          return T(0);
+        for (int i = 0; i < nbVars; i++)
+          input[i] = float(x->getEntry(i));
+        float output = 0.0f;
+        ensembles[int(x->getEntry(nbVars))]->Evaluate(&input, output);
+        return T(output);
+      }
+
+      Vector<T>* weights() const
+      {
+        return 0;
+      }
+
+      void persist(const char* f) const
+      {
+#if !defined(EMBEDDED_MODE)
+        std::ofstream of(f);
+        for (size_t a = 0; a < ensembles.size(); a++)
+          ensembles[a]->WriteOnStream(of);
+#endif
+      }
+
+      void resurrect(const char* f)
+      {
+#if !defined(EMBEDDED_MODE)
+        std::ifstream ifs(f);
+        for (size_t a = 0; a < ensembles.size(); a++)
+          ensembles[a]->ReadFromStream(ifs);
+        fitted = true;
+#endif
+      }
+  };
+
+  /**
+   * Fitted Q-iteration. The transitions are collected once, either from an RLProblem with a
+   * uniformly random behavior or one at a time, and each iteration fits
+   * Q_k+1(s,a) = r + gamma * max_a' Q_k(s',a') over all of them. The targets are computed by
+   * evaluating Q_k(.,a') on the next observations of all the samples as one batch per action,
+   * split among the threads. The greedy policy with respect to the last Q is exposed through the
+   * Control interface, hence it runs with a ControlAgent.
+   */
+  template<typename T>
+  class FittedQIteration: public Control<T>
+  {
+    protected:
+      Random<T>* random;
+      Actions<T>* actions;
+      int nbVars;
+      T gamma;
+      StateActionTuple<T>* toStateAction;
+      FittedQ<T>* q;
+      Greedy<T>* greedy;
+      std::vector<PoliFitted::Dataset*> datasets;
+      // Per sample, in the order of arrival
+      std::vector<PoliFitted::Tuple*> targets;
+      std::vector<PoliFitted::Tuple*> nextObservations;
+      std::vector<float> rewards;
+      std::vector<bool> terminals;
+      std::vector<float> nextValues;
+      std::vector<float> maxNextValues;
+      int nbIterations;
+      T lastIterationTimeInMilliseconds;
+      T totalIterationTimeInMilliseconds;
+      T lastBellmanResidual;
+#if !defined(EMBEDDED_MODE)
+      Timer timer;
+#endif
+
+    public:
+      FittedQIteration(Random<T>* random, Actions<T>* actions, const int& nbVars, const T& gamma,
+          const int& nbTrees = 50, const int& nbSplits = 5, const int& nMin = 2,
+          const unsigned int& nbThreads = std::thread::hardware_concurrency()) :
+          random(random), actions(actions), nbVars(nbVars), gamma(gamma), //
+          toStateAction(new StateActionTuple<T>(nbVars, actions)), //
+          q(new FittedQ<T>(nbVars, actions->dimension(), nbTrees, nbSplits, nMin, nbThreads)), //
+          greedy(new Greedy<T>(actions, q)), nbIterations(0), lastIterationTimeInMilliseconds(0), //
+          totalIterationTimeInMilliseconds(0), lastBellmanResidual(0)
+      {
+        for (int a = 0; a < actions->dimension(); a++)
+          datasets.push_back(new PoliFitted::Dataset(nbVars, 1));
+      }
+
+      virtual ~FittedQIteration()
+      {
+        clear();
+        for (std::vector<PoliFitted::Dataset*>::iterator iter = datasets.begin();
+            iter != datasets.end(); ++iter)
+          delete *iter;
+        delete toStateAction;
+        delete q;
+        delete greedy;
+      }
+
+      void clear()
+      {
+        for (std::vector<PoliFitted::Dataset*>::iterator iter = datasets.begin();
+            iter != datasets.end(); ++iter)
+        {
+          (*iter)->Clear(true);
+          (*iter)->clear();
+        }
+        for (std::vector<PoliFitted::Tuple*>::iterator iter = nextObservations.begin();
+            iter != nextObservations.end(); ++iter)
+          delete *iter;
+        targets.clear();
+        nextObservations.clear();
+        rewards.clear();
+        terminals.clear();
+      }
+
+      // An empty x_tp1 marks the end of an episode
+      void addTransition(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1,
+          const T& r_tp1)
+      {
+        PoliFitted::Tuple* target = new PoliFitted::Tuple(1);
+        target->at(0) = 0.0f;
+        datasets[a_t->id()]->AddSample(newTuple(x_t), target);
+        targets.push_back(target);
+        const bool terminal = x_tp1->empty();
+        // The next observation of a terminal transition is never used
+        nextObservations.push_back(newTuple(terminal ? x_t : x_tp1));
+        rewards.push_back(float(r_tp1));
+        terminals.push_back(terminal);
+      }
+
+      // Runs nbEpisodes episodes with uniformly random actions and keeps all the transitions
+      void collect(RLProblem<T>* problem, const int& nbEpisodes, const int& maxEpisodeTimeSteps)
+      {
+        Vector<T>* x_t = new PVector<T>(nbVars);
+        Vector<T>* absorbingState = new PVector<T>(0);
+        for (int episode = 0; episode < nbEpisodes; episode++)
+        {
+          problem->initialize();
+          problem->updateTuple();
+          for (int timeStep = 0; timeStep < maxEpisodeTimeSteps; timeStep++)
+          {
+            x_t->set(problem->getTRStep()->o_tp1);
+            const Action<T>* a_t = actions->getEntry(random->nextInt(actions->dimension()));
+            problem->step(a_t);
+            problem->updateTuple();
+            const TRStep<T>* step = problem->getTRStep();
+            addTransition(x_t, a_t, step->endOfEpisode ? absorbingState : step->o_tp1,
+                step->r_tp1);
+            if (step->endOfEpisode)
+              break;
+          }
+        }
+        delete x_t;
+        delete absorbingState;
+      }
+
+      // One Bellman backup over all the samples; returns the time spent in milliseconds
+      T iterate()
+      {
+        ASSERT(!targets.empty());
+#if !defined(EMBEDDED_MODE)
+        timer.start();
+#endif
+        const size_t nbSamples = targets.size();
+        nextValues.resize(nbSamples);
+        maxNextValues.assign(nbSamples, -std::numeric_limits<float>::max());
+        for (int a = 0; a < actions->dimension(); a++)
+        {
+          q->evaluate(a, nextObservations, &nextValues[0]);
+          for (size_t i = 0; i < nbSamples; i++)
+            maxNextValues[i] = std::max(maxNextValues[i], nextValues[i]);
+        }
+        lastBellmanResidual = T(0);
+        for (size_t i = 0; i < nbSamples; i++)
+        {
+          const float target = rewards[i]
+              + (terminals[i] ? 0.0f : float(gamma) * maxNextValues[i]);
+          float& output = targets[i]->at(0);
+          lastBellmanResidual = std::max(lastBellmanResidual, T(std::fabs(target - output)));
+          output = target;
+        }
+        q->fit(datasets);
+        ++nbIterations;
+#if !defined(EMBEDDED_MODE)
+        timer.stop();
+        lastIterationTimeInMilliseconds = timer.getElapsedTimeInMilliSec();
+#endif
+        totalIterationTimeInMilliseconds += lastIterationTimeInMilliseconds;
+        return lastIterationTimeInMilliseconds;
+      }
+
+      void iterate(const int& nbIterations, const bool& verbose = false)
+      {
+        for (int i = 0; i < nbIterations; i++)
+        {
+          iterate();
+#if !defined(EMBEDDED_MODE)
+          if (verbose)
+            std::cout << "iteration=" << this->nbIterations << " samples=" << targets.size()
+                << " residual=" << lastBellmanResidual << " time(ms)="
+                << lastIterationTimeInMilliseconds << std::endl;
+#endif
+        }
+      }
+
+      int getNbSamples() const
+      {
+        return targets.size();
+      }
+
+      int getNbIterations() const
+      {
+        return nbIterations;
+      }
+
+      T getLastIterationTime() const
+      {
+        return lastIterationTimeInMilliseconds;
+      }
+
+      T getTotalIterationTime() const
+      {
+        return totalIterationTimeInMilliseconds;
+      }
+
+      // Largest change of the targets during the last iteration
+      T getBellmanResidual() const
+      {
+        return lastBellmanResidual;
+      }
+
+      Policy<T>* policy() const
+      {
+        return greedy;
+      }
+
+      StateToStateAction<T>* stateToStateAction() const
+      {
+        return toStateAction;
+      }
+
+      const Action<T>* initialize(const Vector<T>* x)
+      {
+        return proposeAction(x);
+      }
+
+      void reset()
+      {
+        clear();
+        nbIterations = 0;
+        totalIterationTimeInMilliseconds = 0;
+      }
+
+      const Action<T>* proposeAction(const Vector<T>* x)
+      {
+        return Policies::sampleBestAction(greedy, toStateAction->stateActions(x));
+      }
+
+      // Records the transition for the next iterations and acts greedily
+      const Action<T>* step(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1,
+          const T& r_tp1, const T& z_tp1)
+      {
+        (void) z_tp1;
+        addTransition(x_t, a_t, x_tp1, r_tp1);
+        return x_tp1->empty() ? a_t : proposeAction(x_tp1);
+      }
+
+      T computeValueFunction(const Vector<T>* x) const
+      {
+        greedy->update(toStateAction->stateActions(x));
+        return greedy->sampleBestActionValue();
+      }
+
+      const Predictor<T>* predictor() const
+      {
+        return q;
+      }
+
+      void persist(const char* f) const
+      {
+        q->persist(f);
+      }
+
+      void resurrect(const char* f)
+      {
+        q->resurrect(f);
+      }
+
+    private:
+      PoliFitted::Tuple* newTuple(const Vector<T>* x) const
+      {
+        PoliFitted::Tuple* tuple = new PoliFitted::Tuple(nbVars);
+        for (int i = 0; i < nbVars; i++)
+          tuple->at(i) = float(x->getEntry(i));
+        return tuple;
+      }
+  };
+
+} // namespace RLLib
+
+#endif /* FITTEDQITERATION_H_ */
@@ -0,0 +1,368 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Horde.h
+ */
+
+#ifndef HORDE_H_
+#define HORDE_H_
+
+#include <vector>
+
+#include "Vector.h"
+#include "Action.h"
+#include "Trace.h"
+#include "Policy.h"
+#include "Function.h"
+
+namespace RLLib
+{
+
+  /**
+   * GTD(lambda) demons that share the target policy, gamma, lambda and the step sizes, and only
+   * differ by their cumulants (r and z). The importance sampling ratio is the same for all of
+   * them, hence so is the eligibility trace: the group keeps a single trace. The weights of the
+   * demons are stored feature-major, i.e., the weights of feature i for all the demons are
+   * contiguous, such that one sweep over the active features updates all the demons.
+   */
+  template<typename T>
+  class GTDLambdaGroup
+  {
+    protected:
+      Policy<T>* target;
+      T alpha_v, alpha_w, gamma, lambda;
+      Trace<T>* e;
+      int nbFeatures;
+      int nbDemons;
+      bool initialized;
+      std::vector<RewardFunction<T>*> rewards;
+      std::vector<OutcomeFunction<T>*> outcomes;
+      std::vector<T> v;
+      std::vector<T> w;
+      // Per demon buffers of the current step
+      std::vector<T> r_tp1, z_tp1, delta_t, v_t, v_tp1, wDotE, wDotPhi, scale;
+
+    public:
+      GTDLambdaGroup(Policy<T>* target, const T& alpha_v, const T& alpha_w, const T& gamma,
+          const T& lambda, Trace<T>* e) :
+          target(target), alpha_v(alpha_v), alpha_w(alpha_w), gamma(gamma), lambda(lambda), //
+          e(e), nbFeatures(e->vect()->dimension()), nbDemons(0), initialized(false)
+      {
+      }
+
+      virtual ~GTDLambdaGroup()
+      {
+      }
+
+      // Returns the index of the demon; the demons are added before learning starts
+      int addDemon(RewardFunction<T>* reward, OutcomeFunction<T>* outcome = 0)
+      {
+        ASSERT(!initialized);
+        rewards.push_back(reward);
+        outcomes.push_back(outcome);
+        ++nbDemons;
+        v.assign(size_t(nbFeatures) * nbDemons, T(0));
+        w.assign(size_t(nbFeatures) * nbDemons, T(0));
+        r_tp1.assign(nbDemons, T(0));
+        z_tp1.assign(nbDemons, T(0));
+        delta_t.assign(nbDemons, T(0));
+        v_t.assign(nbDemons, T(0));
+        v_tp1.assign(nbDemons, T(0));
+        wDotE.assign(nbDemons, T(0));
+        wDotPhi.assign(nbDemons, T(0));
+        scale.assign(nbDemons, T(0));
+        return nbDemons - 1;
+      }
+
+      void initialize()
+      {
+        e->clear();
+        initialized = true;
+      }
+
+      // Reads the cumulants of the demons and learns; rho_t is computed once for the group
+      void update(const Vector<T>* phi_t, const Vector<T>* phi_tp1, const T& rho_t)
+      {
+        for (int k = 0; k < nbDemons; k++)
+        {
+          r_tp1[k] = rewards[k]->reward();
+          z_tp1[k] = outcomes[k] ? outcomes[k]->outcome() : T(0);
+        }
+        update(phi_t, phi_tp1, rho_t, &r_tp1[0], &z_tp1[0]);
+      }
+
+      /**
+       * Same update as GTDLambda for every demon k:
+       * delta_k = r_k + (1 - gamma) z_k + gamma v_k.phi_tp1 - v_k.phi_t
+       * e = rho (gamma lambda e + phi_t)
+       * v_k += alpha_v (delta_k e - gamma (1 - lambda) (w_k.e) phi_tp1)
+       * w_k += alpha_w (delta_k e - (w_k.phi_t) phi_t)
+       */
+      void update(const Vector<T>* phi_t, const Vector<T>* phi_tp1, const T& rho_t,
+          const T* r_tp1, const T* z_tp1)
+      {
+        ASSERT(initialized && nbDemons > 0);
+        dotAll(phi_t, &v[0], &v_t[0]);
+        dotAll(phi_tp1, &v[0], &v_tp1[0]);
+        for (int k = 0; k < nbDemons; k++)
+          delta_t[k] = r_tp1[k] + (T(1) - gamma) * z_tp1[k] + gamma * v_tp1[k] - v_t[k];
+
+        e->update(gamma * lambda, phi_t);
+        e->vect()->mapMultiplyToSelf(rho_t);
+        const Vector<T>* ev = e->vect();
+
+        // Both corrections use w before its update
+        dotAll(ev, &w[0], &wDotE[0]);
+        dotAll(phi_t, &w[0], &wDotPhi[0]);
+
+        // v
+        for (int k = 0; k < nbDemons; k++)
+          scale[k] = alpha_v * delta_t[k];
+        addAll(ev, &scale[0], &v[0]);
+        for (int k = 0; k < nbDemons; k++)
+          scale[k] = -alpha_v * gamma * (T(1) - lambda) * wDotE[k];
+        addAll(phi_tp1, &scale[0], &v[0]);
+
+        // w
+        for (int k = 0; k < nbDemons; k++)
+          scale[k] = -alpha_w * wDotPhi[k];
+        addAll(phi_t, &scale[0], &w[0]);
+        for (int k = 0; k < nbDemons; k++)
+          scale[k] = alpha_w * delta_t[k];
+        addAll(ev, &scale[0], &w[0]);
+      }
+
+      void reset()
+      {
+        e->clear();
+        std::fill(v.begin(), v.end(), T(0));
+        std::fill(w.begin(), w.end(), T(0));
+        initialized = false;
+      }
+
+      T predict(const int& demon, const Vector<T>* phi) const
+      {
+        ASSERT(demon >= 0 && demon < nbDemons);
+        T result = T(0);
+        const SparseVector<T>* sphi = RTTI<T>::constSparseVector(phi);
+        if (sphi)
+        {
+          const int* indexes = sphi->nonZeroIndexes();
+          const T* values = sphi->getValues();
+          for (int i = 0; i < sphi->nonZeroElements(); i++)
+            result += v[size_t(indexes[i]) * nbDemons + demon] * values[i];
+        }
+        else
+        {
+          for (int i = 0; i < nbFeatures; i++)
+            result += v[size_t(i) * nbDemons + demon] * phi->getEntry(i);
+        }
+        return result;
+      }
+
+      // out[k] = v_k.phi for all the demons in one sweep
+      void predictAll(const Vector<T>* phi, T* out) const
+      {
+        dotAll(phi, &v[0], out);
+      }
+
+      // Copies the weights of a demon in the usual (demon-major) layout
+      void weights(const int& demon, Vector<T>* result) const
+      {
+        ASSERT(demon >= 0 && demon < nbDemons && result->dimension() == nbFeatures);
+        for (int i = 0; i < nbFeatures; i++)
+          result->setEntry(i, v[size_t(i) * nbDemons + demon]);
+      }
+
+      Policy<T>* getTarget() const
+      {
+        return target;
+      }
+
+      Trace<T>* trace() const
+      {
+        return e;
+      }
+
+      int dimension() const
+      {
+        return nbDemons;
+      }
+
+      T getDelta(const int& demon) const
+      {
+        return delta_t[demon];
+      }
+
+    private:
+      void dotAll(const Vector<T>* phi, const T* weights, T* out) const
+      {
+        std::fill(out, out + nbDemons, T(0));
+        const SparseVector<T>* sphi = RTTI<T>::constSparseVector(phi);
+        if (sphi)
+        {
+          const int* indexes = sphi->nonZeroIndexes();
+          const T* values = sphi->getValues();
+          for (int i = 0; i < sphi->nonZeroElements(); i++)
+          {
+            const T* row = weights + size_t(indexes[i]) * nbDemons;
+            for (int k = 0; k < nbDemons; k++)
+              out[k] += row[k] * values[i];
+          }
+        }
+        else
+        {
+          const T* values = phi->getValues();
+          for (int i = 0; i < phi->dimension(); i++)
+          {
+            if (values[i] == T(0))
+              continue;
+            const T* row = weights + size_t(i) * nbDemons;
+            for (int k = 0; k < nbDemons; k++)
+              out[k] += row[k] * values[i];
+          }
+        }
+      }
+
+      void addAll(const Vector<T>* phi, const T* factors, T* weights)
+      {
+        const SparseVector<T>* sphi = RTTI<T>::constSparseVector(phi);
+        if (sphi)
+        {
+          const int* indexes = sphi->nonZeroIndexes();
+          const T* values = sphi->getValues();
+          for (int i = 0; i < sphi->nonZeroElements(); i++)
+          {
+            T* row = weights + size_t(indexes[i]) * nbDemons;
+            for (int k = 0; k < nbDemons; k++)
+              row[k] += factors[k] * values[i];
+          }
+        }
+        else
+        {
+          const T* values = phi->getValues();
+          for (int i = 0; i < phi->dimension(); i++)
+          {
+            if (values[i] == T(0))
+              continue;
+            T* row = weights + size_t(i) * nbDemons;
+            for (int k = 0; k < nbDemons; k++)
+              row[k] += factors[k] * values[i];
+          }
+        }
+      }
+  };
+
+  /**
+   * Off-policy Horde: many GTD(lambda) demons learning from the same behavior stream. The
+   * behavior policy is evaluated once per step, the demons are grouped by target policy such that
+   * pi(a_t|s_t) and rho_t are computed once per group, and each group updates its demons in
+   * batch. The state-action representations used by the policies are also computed once by the
+   * caller, and shared by all the groups.
+   */
+  template<typename T>
+  class OffPolicyHorde
+  {
+    protected:
+      Policy<T>* behavior;
+      std::vector<GTDLambdaGroup<T>*> groups;
+      std::vector<T> rhos;
+
+    public:
+      OffPolicyHorde(Policy<T>* behavior) :
+          behavior(behavior)
+      {
+      }
+
+      virtual ~OffPolicyHorde()
+      {
+        for (typename std::vector<GTDLambdaGroup<T>*>::iterator iter = groups.begin();
+            iter != groups.end(); ++iter)
+          delete *iter;
+      }
+
+      // The Horde owns the group; the trace is owned by the caller
+      GTDLambdaGroup<T>* addGroup(Policy<T>* target, const T& alpha_v, const T& alpha_w,
+          const T& gamma, const T& lambda, Trace<T>* e)
+      {
+        GTDLambdaGroup<T>* group = new GTDLambdaGroup<T>(target, alpha_v, alpha_w, gamma, lambda,
+            e);
+        groups.push_back(group);
+        rhos.push_back(T(0));
+        return group;
+      }
+
+      void initialize()
+      {
+        for (typename std::vector<GTDLambdaGroup<T>*>::iterator iter = groups.begin();
+            iter != groups.end(); ++iter)
+          (*iter)->initialize();
+      }
+
+      /**
+       * xas_t: the state-action representations of s_t for the policies
+       * phi_t, phi_tp1: the state features of the demons
+       */
+      void update(const Representations<T>* xas_t, const Action<T>* a_t, const Vector<T>* phi_t,
+          const Vector<T>* phi_tp1)
+      {
+        behavior->update(xas_t);
+        const T b_t = behavior->pi(a_t);
+        ASSERT(b_t > T(0));
+        for (size_t g = 0; g < groups.size(); g++)
+        {
+          Policy<T>* target = groups[g]->getTarget();
+          target->update(xas_t);
+          rhos[g] = target->pi(a_t) / b_t;
+          groups[g]->update(phi_t, phi_tp1, rhos[g]);
+        }
+      }
+
+      void reset()
+      {
+        for (typename std::vector<GTDLambdaGroup<T>*>::iterator iter = groups.begin();
+            iter != groups.end(); ++iter)
+          (*iter)->reset();
+      }
+
+      GTDLambdaGroup<T>* at(const int& index) const
+      {
+        return groups[index];
+      }
+
+      // Importance sampling ratio of the last update for a group
+      T getRho(const int& index) const
+      {
+        return rhos[index];
+      }
+
+      int dimension() const
+      {
+        return int(groups.size());
+      }
+
+      int nbDemons() const
+      {
+        int result = 0;
+        for (typename std::vector<GTDLambdaGroup<T>*>::const_iterator iter = groups.begin();
+            iter != groups.end(); ++iter)
+          result += (*iter)->dimension();
+        return result;
+      }
+  };
+
+} // namespace RLLib
+
+#endif /* HORDE_H_ */
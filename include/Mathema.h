@@ -26,6 +26,9 @@
 #include <limits>
 #include <limits.h>
 #include <stdint.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "Vector.h"
 
@@ -58,6 +61,142 @@ namespace RLLib
       }
   };
 
+  // Operations on the contiguous action-value arrays used by the discrete policies
+  class ActionValues
+  {
+    public:
+      template<typename T>
+      inline static T max(const T* values, const int& size)
+      {
+        T maxValue = values[0];
+        for (int i = 1; i < size; i++)
+          maxValue = std::max(maxValue, values[i]);
+        return maxValue;
+      }
+
+#if defined(__SSE2__)
+      // The compiler does not vectorize floating point max reductions on its own (NaN ordering).
+      // Four independent accumulators hide the latency of the max instruction.
+      inline static double max(const double* values, const int& size)
+      {
+        if (size < 8)
+          return max<double>(values, size);
+        __m128d m0 = _mm_loadu_pd(values), m1 = _mm_loadu_pd(values + 2);
+        __m128d m2 = _mm_loadu_pd(values + 4), m3 = _mm_loadu_pd(values + 6);
+        int i = 8;
+        for (; i + 8 <= size; i += 8)
+        {
+          m0 = _mm_max_pd(m0, _mm_loadu_pd(values + i));
+          m1 = _mm_max_pd(m1, _mm_loadu_pd(values + i + 2));
+          m2 = _mm_max_pd(m2, _mm_loadu_pd(values + i + 4));
+          m3 = _mm_max_pd(m3, _mm_loadu_pd(values + i + 6));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_max_pd(_mm_max_pd(m0, m1), _mm_max_pd(m2, m3)));
+        double maxValue = std::max(lanes[0], lanes[1]);
+        for (; i < size; i++)
+          maxValue = std::max(maxValue, values[i]);
+        return maxValue;
+      }
+
+      inline static float max(const float* values, const int& size)
+      {
+        if (size < 16)
+          return max<float>(values, size);
+        __m128 m0 = _mm_loadu_ps(values), m1 = _mm_loadu_ps(values + 4);
+        __m128 m2 = _mm_loadu_ps(values + 8), m3 = _mm_loadu_ps(values + 12);
+        int i = 16;
+        for (; i + 16 <= size; i += 16)
+        {
+          m0 = _mm_max_ps(m0, _mm_loadu_ps(values + i));
+          m1 = _mm_max_ps(m1, _mm_loadu_ps(values + i + 4));
+          m2 = _mm_max_ps(m2, _mm_loadu_ps(values + i + 8));
+          m3 = _mm_max_ps(m3, _mm_loadu_ps(values + i + 12));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, _mm_max_ps(_mm_max_ps(m0, m1), _mm_max_ps(m2, m3)));
+        float maxValue = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+        for (; i < size; i++)
+          maxValue = std::max(maxValue, values[i]);
+        return maxValue;
+      }
+
+      inline static int indexOf(const double* values, const int& size, const double& value)
+      {
+        const __m128d target = _mm_set1_pd(value);
+        int i = 0;
+        for (; i + 4 <= size; i += 4)
+        {
+          const int mask = _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(values + i), target))
+              | (_mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(values + i + 2), target)) << 2);
+          if (mask)
+            return i + __builtin_ctz(mask);
+        }
+        return indexOf<double>(values + i, size - i, value) + i;
+      }
+
+      inline static int indexOf(const float* values, const int& size, const float& value)
+      {
+        const __m128 target = _mm_set1_ps(value);
+        int i = 0;
+        for (; i + 4 <= size; i += 4)
+        {
+          const int mask = _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(values + i), target));
+          if (mask)
+            return i + __builtin_ctz(mask);
+        }
+        return indexOf<float>(values + i, size - i, value) + i;
+      }
+#endif
+
+      // Index of the first occurrence of value, or size
+      template<typename T>
+      inline static int indexOf(const T* values, const int& size, const T& value)
+      {
+        for (int i = 0; i < size; i++)
+        {
+          if (values[i] == value)
+            return i;
+        }
+        return size;
+      }
+
+      // Index of the first maximum value
+      template<typename T>
+      inline static int argmax(const T* values, const int& size)
+      {
+        const int index = indexOf(values, size, max(values, size));
+        return index < size ? index : 0; // NaN values
+      }
+
+      /**
+       * distribution = exp((values - max(values)) / temperature) / Z
+       * The exponential function may become very large and overflow. Therefore, we multiply top
+       * and bottom of the hypothesis by the same constant without changing the output. Each stage
+       * is a separate flat loop over the arrays, so that the compiler can vectorize them (the
+       * exponential as well, when a vector math library is available).
+       */
+      template<typename T>
+      static void boltzmann(const T* values, const int& size, const T& temperature,
+          T* distribution)
+      {
+        const T maxValue = max(values, size);
+        ASSERT(Boundedness::checkValue(maxValue));
+        const T invTemperature = T(1) / temperature;
+        for (int i = 0; i < size; i++)
+          distribution[i] = (values[i] - maxValue) * invTemperature;
+        for (int i = 0; i < size; i++)
+          distribution[i] = std::exp(distribution[i]);
+        T sum = T(0);
+        for (int i = 0; i < size; i++)
+          sum += distribution[i];
+        ASSERT(Boundedness::checkValue(sum) && sum > T(0));
+        const T invSum = T(1) / sum;
+        for (int i = 0; i < size; i++)
+          distribution[i] *= invSum;
+      }
+  };
+
 //-----------------------------------------------------------------------------
 // Xorshift RNG based on code by George Marsaglia
 // http://en.wikipedia.org/wiki/Xorshift
@@ -151,45 +290,185 @@ namespace RLLib
       }
   };
 
+  /**
+   * Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers: as easy
+   * as 1, 2, 3", SC'11). Each block of four words is a keyed bijection of a 128-bit counter,
+   * so there is no state to carry between draws besides the counter itself. The low half of
+   * the counter enumerates the blocks, and the high half selects the stream: every (seed,
+   * stream) pair is an independent sequence of 2^64 blocks, which gives cheap, reproducible
+   * streams per agent, thread or run.
+   */
+  class Philox
+  {
+    private:
+      uint32_t key[2];
+      uint32_t counter[4];
+      uint32_t block[4];
+      int index;
+
+    public:
+      Philox(const uint64_t& seed = 0, const uint64_t& stream = 0)
+      {
+        reseed(seed, stream);
+      }
+
+      void reseed(const uint64_t& seed, const uint64_t& stream = 0)
+      {
+        key[0] = uint32_t(seed);
+        key[1] = uint32_t(seed >> 32);
+        counter[0] = counter[1] = 0;
+        setStream(stream);
+      }
+
+      // Restarts the sequence of the current seed at the beginning of the given stream
+      void setStream(const uint64_t& stream)
+      {
+        counter[0] = counter[1] = 0;
+        counter[2] = uint32_t(stream);
+        counter[3] = uint32_t(stream >> 32);
+        index = 4;
+      }
+
+      uint64_t getStream() const
+      {
+        return (uint64_t(counter[3]) << 32) | counter[2];
+      }
+
+      inline uint32_t rand_u32()
+      {
+        if (index == 4)
+          nextBlock();
+        return block[index++];
+      }
+
+      uint64_t rand_u64()
+      {
+        const uint64_t a = rand_u32();
+        return (a << 32) | rand_u32();
+      }
+
+      // Bulk generation; whole blocks are written directly to the output
+      void rand_u32(uint32_t* out, int size)
+      {
+        while (size > 0 && index < 4)
+        {
+          *out++ = block[index++];
+          --size;
+        }
+        for (; size >= 4; size -= 4, out += 4)
+        {
+          generate(counter, key, out);
+          increment();
+        }
+        for (; size > 0; --size)
+          *out++ = rand_u32();
+      }
+
+      static void generate(const uint32_t in[4], const uint32_t seed[2], uint32_t out[4])
+      {
+        uint32_t c0 = in[0], c1 = in[1], c2 = in[2], c3 = in[3];
+        uint32_t k0 = seed[0], k1 = seed[1];
+        for (int round = 0; round < 10; round++)
+        {
+          const uint64_t p0 = uint64_t(0xD2511F53) * c0;
+          const uint64_t p1 = uint64_t(0xCD9E8D57) * c2;
+          const uint32_t hi0 = uint32_t(p0 >> 32), lo0 = uint32_t(p0);
+          const uint32_t hi1 = uint32_t(p1 >> 32), lo1 = uint32_t(p1);
+          c0 = hi1 ^ c1 ^ k0;
+          c1 = lo1;
+          c2 = hi0 ^ c3 ^ k1;
+          c3 = lo0;
+          k0 += 0x9E3779B9;
+          k1 += 0xBB67AE85;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+      }
+
+    private:
+      void increment()
+      {
+        if (++counter[0] == 0)
+          ++counter[1];
+      }
+
+      void nextBlock()
+      {
+        generate(counter, key, block);
+        increment();
+        index = 0;
+      }
+  };
+
 // Important distributions
   template<typename T>
   class Random
   {
     private:
-      Xorshift xorshift;
+      Philox philox;
+      T gaussianCache;
+      bool gaussianCached;
 
     public:
-      Random()
+      Random(const uint64_t& seed = 0, const uint64_t& stream = 0) :
+          philox(seed, stream), gaussianCache(0), gaussianCached(false)
       {
       }
 
       inline void reseed(const uint32_t& seed)
       {
-        //::srand(seed);
-        xorshift.reseed(seed);
+        philox.reseed(seed, philox.getStream());
+        gaussianCached = false;
+      }
+
+      // Independent sequence of the same seed, e.g., one per agent or thread
+      inline void setStream(const uint64_t& stream)
+      {
+        philox.setStream(stream);
+        gaussianCached = false;
       }
 
+      inline uint64_t getStream() const
+      {
+        return philox.getStream();
+      }
+
+      // [0 .. RAND_MAX]
       inline int rand()
       {
-        //return ::rand();
-        return xorshift.rand_u32() % RAND_MAX;
+        return int(philox.rand_u32() & uint32_t(RAND_MAX));
       }
 
       inline uint32_t randu32(void)
       {
-        return xorshift.rand_u32();
+        return philox.rand_u32();
       }
 
       // [0 .. size)
       inline int nextInt(const int& size)
       {
-        return rand() % size;
+        // Multiply-shift instead of a modulo
+        return int((uint64_t(philox.rand_u32()) * uint64_t(size)) >> 32);
       }
 
       // [0..1)
       inline T nextReal()
       {
-        return T(rand()) / static_cast<T>(RAND_MAX);
+        return toReal(philox.rand_u32());
+      }
+
+      void nextReals(T* values, const int& size)
+      {
+        uint32_t bits[64];
+        for (int i = 0; i < size; i += 64)
+        {
+          const int chunk = std::min(64, size - i);
+          philox.rand_u32(bits, chunk);
+          for (int j = 0; j < chunk; j++)
+            values[i + j] = toReal(bits[j]);
+        }
       }
 
       // A gaussian random deviate
@@ -207,6 +486,25 @@ namespace RLLib
         return v1 * fac;
       }
 
+      /**
+       * Bulk standard normal deviates with the (trigonometric) Box-Muller transform. Unlike the
+       * polar method there is no rejection, and each stage is a flat loop over the output.
+       */
+      void nextNormalGaussians(T* values, const int& size)
+      {
+        const int pairs = size / 2;
+        nextReals(values, 2 * pairs);
+        for (int i = 0; i < pairs; i++)
+        {
+          const T radius = std::sqrt(-T(2) * std::log(T(1) - values[2 * i]));
+          const T theta = T(2 * M_PI) * values[2 * i + 1];
+          values[2 * i] = radius * std::cos(theta);
+          values[2 * i + 1] = radius * std::sin(theta);
+        }
+        if (size % 2)
+          values[size - 1] = nextNormalGaussian();
+      }
+
       inline T gaussianProbability(const T& x, const T& m, const T& s) const
       {
         return exp(-0.5f * pow((x - m) / s, 2)) / (s * sqrt(2.0f * M_PI));
@@ -215,9 +513,7 @@ namespace RLLib
       // http://en.literateprograms.org/Box-Muller_transform_(C)
       inline T nextGaussian(const T& mean, const T& stddev)
       {
-        static T n2 = T(0);
-        static int n2_cached = 0;
-        if (!n2_cached)
+        if (!gaussianCached)
         {
           T x, y, r;
           do
@@ -231,19 +527,156 @@ namespace RLLib
           {
             T d = sqrt(-T(2) * log(r) / r);
             T n1 = x * d;
-            n2 = y * d;
+            gaussianCache = y * d;
             T result = n1 * stddev + mean;
-            n2_cached = 1;
+            gaussianCached = true;
             return result;
           }
         }
         else
         {
-          n2_cached = 0;
-          return n2 * stddev + mean;
+          gaussianCached = false;
+          return gaussianCache * stddev + mean;
+        }
+      }
+
+    private:
+      // Uses as many bits as the mantissa holds, so that the result never rounds up to 1
+      inline static T toReal(const uint32_t& bits)
+      {
+        const int digits = std::numeric_limits<T>::digits < 32 ? std::numeric_limits<T>::digits : 32;
+        return T(bits >> (32 - digits)) * (T(1) / T(uint64_t(1) << digits));
+      }
+
+  };
+
+  /**
+   * Inverse transform sampling from a discrete distribution. The table holds the running sums
+   * of the probabilities, and a uniform draw is mapped back to an index by binary search in
+   * O(log n). The sums are accumulated in index order, hence the index is the same as the one
+   * of a linear scan over the distribution with the same draw.
+   */
+  template<typename T>
+  class CumulativeTable
+  {
+    private:
+      int size;
+      T* cumulative;
+
+    public:
+      CumulativeTable(const int& size) :
+          size(size), cumulative(new T[size])
+      {
+      }
+
+      ~CumulativeTable()
+      {
+        delete[] cumulative;
+      }
+
+      void update(const T* distribution)
+      {
+        T sum = T(0);
+        for (int i = 0; i < size; i++)
+        {
+          sum += distribution[i];
+          cumulative[i] = sum;
         }
       }
 
+      // First index with cumulative[index] >= rand
+      int sample(const T& rand) const
+      {
+        const int index = std::lower_bound(cumulative, cumulative + size, rand) - cumulative;
+        return index < size ? index : size - 1;
+      }
+
+      int sample(Random<T>* random) const
+      {
+        return sample(random->nextReal());
+      }
+  };
+
+  /**
+   * Walker's alias method (with Vose's construction). The table is built in O(n), and each
+   * sample costs one uniform draw and one comparison, independently of the number of
+   * outcomes. This is the right choice when the same distribution is sampled many times.
+   */
+  template<typename T>
+  class AliasTable
+  {
+    private:
+      int size;
+      T* probabilities;
+      int* aliases;
+      int* smalls;
+      int* larges;
+
+    public:
+      AliasTable(const int& size) :
+          size(size), probabilities(new T[size]), aliases(new int[size]), //
+          smalls(new int[size]), larges(new int[size])
+      {
+      }
+
+      ~AliasTable()
+      {
+        delete[] probabilities;
+        delete[] aliases;
+        delete[] smalls;
+        delete[] larges;
+      }
+
+      void update(const T* distribution)
+      {
+        T sum = T(0);
+        for (int i = 0; i < size; i++)
+          sum += distribution[i];
+        ASSERT(sum > T(0));
+        const T scale = T(size) / sum;
+        int nbSmalls = 0, nbLarges = 0;
+        for (int i = 0; i < size; i++)
+        {
+          probabilities[i] = distribution[i] * scale;
+          aliases[i] = i;
+          if (probabilities[i] < T(1))
+            smalls[nbSmalls++] = i;
+          else
+            larges[nbLarges++] = i;
+        }
+        while (nbSmalls > 0 && nbLarges > 0)
+        {
+          const int small = smalls[--nbSmalls];
+          const int large = larges[nbLarges - 1];
+          aliases[small] = large;
+          probabilities[large] = (probabilities[large] + probabilities[small]) - T(1);
+          if (probabilities[large] < T(1))
+          {
+            --nbLarges;
+            smalls[nbSmalls++] = large;
+          }
+        }
+        // Numerical leftovers are (up to rounding) full columns
+        while (nbLarges > 0)
+          probabilities[larges[--nbLarges]] = T(1);
+        while (nbSmalls > 0)
+          probabilities[smalls[--nbSmalls]] = T(1);
+      }
+
+      // A single draw in [0..1) selects both the column and the coin
+      int sample(const T& rand) const
+      {
+        const T x = rand * size;
+        int column = int(x);
+        if (column >= size)
+          column = size - 1;
+        return (x - column) < probabilities[column] ? column : aliases[column];
+      }
+
+      int sample(Random<T>* random) const
+      {
+        return sample(random->nextReal());
+      }
   };
 
 // Helper class for range management for testing environments
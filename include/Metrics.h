@@ -0,0 +1,362 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Metrics.h
+ */
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <cstring>
+#include <stdint.h>
+
+#include "RL.h"
+#include "Statistics.h"
+
+namespace RLLib
+{
+
+  // One line of the metrics stream; the binary format stores it as is
+  class MetricsRecord
+  {
+    public:
+      enum Kind
+      {
+        STEP = 0, EPISODE = 1
+      };
+
+      int32_t kind;
+      int32_t episode; // From 0, per run
+      int32_t timeStep;
+      int32_t endingOfEpisode;
+      double episodeR;
+      double episodeZ;
+      double averageTimePerStep; // ms
+
+      MetricsRecord() :
+          kind(STEP), episode(0), timeStep(0), endingOfEpisode(0), episodeR(0), episodeZ(0), //
+          averageTimePerStep(0)
+      {
+      }
+  };
+
+  /**
+   * Bounded single producer, single consumer queue: the producer only writes the tail, the
+   * consumer only writes the head, hence no locks. The capacity is rounded up to a power of two.
+   */
+  template<typename E>
+  class SPSCQueue
+  {
+    protected:
+      std::vector<E> elements;
+      size_t mask;
+      std::atomic<size_t> head;
+      std::atomic<size_t> tail;
+
+    public:
+      SPSCQueue(const size_t& capacity) :
+          head(0), tail(0)
+      {
+        size_t size = 2;
+        while (size < capacity)
+          size <<= 1;
+        elements.resize(size);
+        mask = size - 1;
+      }
+
+      // Producer; false when full
+      bool push(const E& e)
+      {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == elements.size())
+          return false;
+        elements[t & mask] = e;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+      }
+
+      // Consumer; false when empty
+      bool pop(E& e)
+      {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+          return false;
+        e = elements[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+      }
+
+      bool empty() const
+      {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+      }
+
+      size_t size() const
+      {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+      }
+
+      size_t capacity() const
+      {
+        return elements.size();
+      }
+  };
+
+  /**
+   * Per episode (and optionally per step) records of RLRunners, written by a background thread,
+   * so that the runner never waits on the file. The runner only pushes to a lock-free queue. The
+   * writer sleeps on a condition variable, which the runner signals (taking the lock) once the
+   * queue is half full; the wait also times out after 100 ms, so that the records of a slow stream
+   * still reach the file, hence an idle writer wakes up ten times per second. When the queue is
+   * full, the runner waits until the writer has brought it back to half full rather than drop
+   * records.
+   *
+   * CSV: a header line, then kind,episode,timeStep,end,R,Z,msPerStep per record.
+   * Binary: "RLLIBMET", uint32 sizeof(MetricsRecord), uint32 0, then the records.
+   *
+   * The episode lengths and returns are also summarized in constant memory.
+   */
+  template<typename T>
+  class MetricsSink
+  {
+    public:
+      enum Format
+      {
+        CSV, BINARY
+      };
+
+    protected:
+      class MetricsEvent: public RLRunner<T>::Event
+      {
+        private:
+          typedef typename RLRunner<T>::Event Base;
+          MetricsSink<T>* sink;
+          int32_t kind;
+
+        public:
+          MetricsEvent(MetricsSink<T>* sink, const int32_t& kind) :
+              sink(sink), kind(kind)
+          {
+          }
+
+          void update() const
+          {
+            MetricsRecord record;
+            record.kind = kind;
+            // nbEpisodeDone is incremented before the episode events
+            record.episode = kind == MetricsRecord::EPISODE ? Base::nbEpisodeDone - 1 :
+                Base::nbEpisodeDone;
+            record.timeStep = Base::nbTotalTimeSteps;
+            record.endingOfEpisode = Base::endingOfEpisode;
+            record.episodeR = Base::episodeR;
+            record.episodeZ = Base::episodeZ;
+            record.averageTimePerStep = Base::averageTimePerStep;
+            sink->push(record);
+          }
+      };
+
+      std::ofstream* out;
+      Format format;
+      SPSCQueue<MetricsRecord> queue;
+      MetricsEvent stepEvent;
+      MetricsEvent episodeEvent;
+      std::thread* writer;
+      std::atomic<bool> done;
+      std::mutex mutex;
+      std::condition_variable wakeup;
+      std::condition_variable room;
+      std::atomic<bool> writerWaiting;
+      std::atomic<bool> producerWaiting;
+      size_t highWater;
+      long nbRecords;
+      long nbStalls;
+      RunningStatistics<T> lengths;
+      RunningStatistics<T> returns;
+      P2Quantile<T> medianReturn;
+
+    public:
+      MetricsSink(const char* f, const Format& format = CSV, const size_t& capacity = 1 << 16) :
+          out(new std::ofstream(f, format == BINARY ? std::ios::binary : std::ios::out)), //
+          format(format), queue(capacity), stepEvent(this, MetricsRecord::STEP), //
+          episodeEvent(this, MetricsRecord::EPISODE), writer(0), done(false), //
+          writerWaiting(false), producerWaiting(false), highWater(queue.capacity() / 2), //
+          nbRecords(0), nbStalls(0)
+      {
+        if (!out->is_open())
+        {
+          std::cerr << "ERROR! (persist) file=" << f << std::endl;
+          delete out;
+          out = 0;
+          return;
+        }
+        if (format == BINARY)
+        {
+          const char magic[8] = { 'R', 'L', 'L', 'I', 'B', 'M', 'E', 'T' };
+          const uint32_t header[2] = { uint32_t(sizeof(MetricsRecord)), 0 };
+          out->write(magic, sizeof(magic));
+          out->write(reinterpret_cast<const char*>(header), sizeof(header));
+        }
+        else
+          (*out) << "kind,episode,timeStep,end,R,Z,msPerStep" << std::endl;
+        writer = new std::thread(&MetricsSink::write, this);
+      }
+
+      virtual ~MetricsSink()
+      {
+        close();
+      }
+
+      // Episode records, and step records when steps is set
+      void attach(RLRunner<T>* runner, const bool& steps = false)
+      {
+        runner->onEpisodeEnd.push_back(&episodeEvent);
+        if (steps)
+          runner->onStep.push_back(&stepEvent);
+      }
+
+      // Writes the records still in the queue, and closes the file
+      void close()
+      {
+        if (!writer)
+          return;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          done = true;
+        }
+        wakeup.notify_one();
+        writer->join();
+        delete writer;
+        writer = 0;
+        out->close();
+        delete out;
+        out = 0;
+      }
+
+      // Runner thread
+      void push(const MetricsRecord& record)
+      {
+        if (record.kind == MetricsRecord::EPISODE)
+        {
+          lengths.add(T(record.timeStep));
+          returns.add(T(record.episodeR));
+          medianReturn.add(T(record.episodeR));
+        }
+        if (!writer)
+          return;
+        if (queue.push(record))
+        {
+          // Pairs with the fence of the writer before it goes to sleep
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          if (queue.size() >= highWater && writerWaiting.load(std::memory_order_relaxed))
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            wakeup.notify_one();
+          }
+        }
+        else
+        {
+          ++nbStalls;
+          std::unique_lock<std::mutex> lock(mutex);
+          producerWaiting = true;
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          wakeup.notify_one();
+          while (!queue.push(record))
+            room.wait(lock);
+          producerWaiting = false;
+        }
+        ++nbRecords;
+      }
+
+      bool isOpen() const
+      {
+        return writer != 0;
+      }
+
+      long getNbRecords() const
+      {
+        return nbRecords;
+      }
+
+      long getNbStalls() const
+      {
+        return nbStalls;
+      }
+
+      const RunningStatistics<T>* getLengths() const
+      {
+        return &lengths;
+      }
+
+      const RunningStatistics<T>* getReturns() const
+      {
+        return &returns;
+      }
+
+      T getMedianReturn() const
+      {
+        return medianReturn.value();
+      }
+
+    protected:
+      void write()
+      {
+        MetricsRecord record;
+        for (;;)
+        {
+          // done is read before the queue, so that nothing pushed before close() is lost
+          const bool last = done.load();
+          while (queue.pop(record))
+          {
+            // Pairs with the producer setting producerWaiting before it retries; the producer
+            // resumes once the queue is back to half full, not at every record
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (producerWaiting.load(std::memory_order_relaxed) && queue.size() <= highWater)
+            {
+              std::lock_guard<std::mutex> lock(mutex);
+              room.notify_one();
+            }
+            if (format == BINARY)
+              out->write(reinterpret_cast<const char*>(&record), sizeof(record));
+            else
+              (*out) << record.kind << "," << record.episode << "," << record.timeStep << ","
+                  << record.endingOfEpisode << "," << record.episodeR << "," << record.episodeZ
+                  << "," << record.averageTimePerStep << "\n";
+          }
+          if (last)
+            break;
+          std::unique_lock<std::mutex> lock(mutex);
+          writerWaiting = true;
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          while (!done && !producerWaiting && queue.size() < highWater)
+          {
+            if (wakeup.wait_for(lock, std::chrono::milliseconds(100)) == std::cv_status::timeout)
+              break;
+          }
+          writerWaiting = false;
+        }
+        out->flush();
+      }
+  };
+
+} // namespace RLLib
+
+#endif /* METRICS_H_ */
@@ -0,0 +1,356 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * MultiAgent.h
+ */
+
+#ifndef MULTIAGENT_H_
+#define MULTIAGENT_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "RL.h"
+#include "StateToStateAction.h"
+
+namespace RLLib
+{
+
+  /**
+   * The state-action features of one agent of a team, in buffers of its own but from the
+   * projector, hence the hashing and its tables, of the team: the MultiAgentRunner projects the
+   * observations of all the agents, one agent after the other, before their controls ask for
+   * them. Other vectors (e.g., the value function surfaces) are projected under the lock of the
+   * team.
+   */
+  template<typename T>
+  class TeamStateToStateAction: public StateToStateAction<T>
+  {
+    protected:
+      StateActionTilings<T>* tilings;
+      std::mutex* sharedMutex;
+      const Representations<T>* phis;
+      // The observation phis holds, or null
+      const Vector<T>* projected;
+
+    public:
+      TeamStateToStateAction(Projector<T>* projector, Actions<T>* actions, std::mutex* sharedMutex) :
+          tilings(new StateActionTilings<T>(projector, actions)), sharedMutex(sharedMutex), //
+          phis(0), projected(0)
+      {
+      }
+
+      virtual ~TeamStateToStateAction()
+      {
+        delete tilings;
+      }
+
+      // Under the lock of the team
+      void project(const Vector<T>* x)
+      {
+        phis = tilings->stateActions(x);
+        projected = x;
+      }
+
+      // x is about to change
+      void invalidate()
+      {
+        projected = 0;
+      }
+
+      const Vector<T>* stateAction(const Vector<T>* x, const Action<T>* a)
+      {
+        return stateActions(x)->at(a);
+      }
+
+      const Representations<T>* stateActions(const Vector<T>* x)
+      {
+        if (x == projected)
+          return phis;
+        projected = 0;
+        // The absorbing state does not go through the projector
+        if (x->empty())
+          return tilings->stateActions(x);
+        std::lock_guard<std::mutex> lock(*sharedMutex);
+        return tilings->stateActions(x);
+      }
+
+      const Actions<T>* getActions() const
+      {
+        return tilings->getActions();
+      }
+
+      T vectorNorm() const
+      {
+        return tilings->vectorNorm();
+      }
+
+      int dimension() const
+      {
+        return tilings->dimension();
+      }
+  };
+
+  /**
+   * One tile coding projector for a whole team; at(k) is what the control of agent k projects
+   * with.
+   */
+  template<typename T>
+  class TeamProjection
+  {
+    protected:
+      std::mutex mutex;
+      std::vector<TeamStateToStateAction<T>*> agents;
+
+    public:
+      TeamProjection(Projector<T>* projector, Actions<T>* actions, const int& nbAgents)
+      {
+        for (int k = 0; k < nbAgents; k++)
+          agents.push_back(new TeamStateToStateAction<T>(projector, actions, &mutex));
+      }
+
+      ~TeamProjection()
+      {
+        for (size_t k = 0; k < agents.size(); k++)
+          delete agents[k];
+      }
+
+      int getNbAgents() const
+      {
+        return int(agents.size());
+      }
+
+      TeamStateToStateAction<T>* at(const int& k) const
+      {
+        return agents[k];
+      }
+
+      // Agent major: the features of agent k, then those of agent k + 1, ...
+      void project(const std::vector<const Vector<T>*>& observations)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t k = 0; k < agents.size(); k++)
+          agents[k]->project(observations[k]);
+      }
+  };
+
+  /**
+   * Steps a team of agents, each with its own problem, in lockstep; e.g., the 11 to 22 players of
+   * a team server with the same feature pipeline. Every step has three stages:
+   * - the workers step the problems of their slices of agents;
+   * - the caller's thread projects the observations of all the agents through the TeamProjection,
+   *   whose controls were built on the TeamStateToStateAction of their agent;
+   * - the workers run the controls of their slices, i.e., the action selection and the learner
+   *   updates, on the features of the previous stage.
+   * The last stage of a step and the first one of the next run in the same pass. The slices are
+   * contiguous, and so are the weights of a slice once pack() has moved them into one allocation,
+   * agent after agent. The workers are kept for the lifetime of the runner, since a stage is far
+   * shorter than a thread start; the caller's thread is the first worker.
+   *
+   * The destructor copies the packed weights back into storage of their own, so the agents must
+   * outlive the runner.
+   */
+  template<typename T>
+  class MultiAgentRunner
+  {
+    protected:
+      enum Stage
+      {
+        ADVANCE = 1, ACT = 2
+      };
+
+      std::vector<RLRunner<T>*> runners;
+      std::vector<RLProblem<T>*> problems;
+      TeamProjection<T>* projection;
+      std::vector<const Vector<T>*> observations;
+      int nbWorkers;
+      // Packed weights
+      T* block;
+      std::vector<int> offsets;
+      std::vector<DenseVector<T>*> packed;
+      // Workers
+      std::vector<std::thread*> workerThreads;
+      std::mutex mutex;
+      std::condition_variable startCondition;
+      std::condition_variable doneCondition;
+      int generation;
+      int nbDone;
+      int stages;
+      bool stopping;
+
+    public:
+      MultiAgentRunner(const std::vector<RLAgent<T>*>& agents,
+          const std::vector<RLProblem<T>*>& problems, TeamProjection<T>* projection,
+          const int& maxEpisodeTimeSteps, const int& nbWorkers = 1) :
+          problems(problems), projection(projection), observations(agents.size()), //
+          nbWorkers(std::max(1, std::min(nbWorkers, int(agents.size())))), block(0), //
+          generation(0), nbDone(0), stages(0), stopping(false)
+      {
+        ASSERT(!agents.empty() && agents.size() == problems.size());
+        ASSERT(projection->getNbAgents() == int(agents.size()));
+        for (size_t k = 0; k < agents.size(); k++)
+        {
+          runners.push_back(new RLRunner<T>(agents[k], problems[k], maxEpisodeTimeSteps));
+          runners.back()->setVerbose(false);
+        }
+        for (int w = 1; w < this->nbWorkers; w++)
+          workerThreads.push_back(new std::thread(&MultiAgentRunner::work, this, w));
+      }
+
+      virtual ~MultiAgentRunner()
+      {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          stopping = true;
+        }
+        startCondition.notify_all();
+        for (size_t w = 0; w < workerThreads.size(); w++)
+        {
+          workerThreads[w]->join();
+          delete workerThreads[w];
+        }
+        for (size_t k = 0; k < runners.size(); k++)
+          delete runners[k];
+        for (size_t k = 0; k < packed.size(); k++)
+          packed[k]->release();
+        if (block)
+          delete[] block;
+      }
+
+      /**
+       * weights[k] is a dense vector of agent k, e.g., control->predictor()->weights(); its
+       * values are copied into the block, which backs it until the runner is deleted.
+       */
+      void pack(const std::vector<Vector<T>*>& weights)
+      {
+        ASSERT(!block && weights.size() == runners.size());
+        offsets.assign(1, 0);
+        for (size_t k = 0; k < weights.size(); k++)
+        {
+          ASSERT(RTTI<T>::denseVector(weights[k]));
+          offsets.push_back(offsets.back() + weights[k]->dimension());
+        }
+        block = new T[offsets.back()];
+        for (size_t k = 0; k < weights.size(); k++)
+        {
+          packed.push_back(RTTI<T>::denseVector(weights[k]));
+          packed.back()->bind(block + offsets[k]);
+        }
+      }
+
+      // nbSteps steps of every agent
+      void step(const int& nbSteps = 1)
+      {
+        if (nbSteps <= 0)
+          return;
+        run(ADVANCE);
+        for (int s = 0; s < nbSteps; s++)
+        {
+          for (size_t k = 0; k < problems.size(); k++)
+            observations[k] = problems[k]->getTRStep()->o_tp1;
+          projection->project(observations);
+          run(s < nbSteps - 1 ? ACT | ADVANCE : ACT);
+        }
+      }
+
+      int getNbAgents() const
+      {
+        return int(runners.size());
+      }
+
+      int getNbWorkers() const
+      {
+        return nbWorkers;
+      }
+
+      RLRunner<T>* getRunner(const int& k) const
+      {
+        return runners[k];
+      }
+
+      // The packed weights of agent k, or null before pack()
+      T* getWeights(const int& k) const
+      {
+        return block ? block + offsets[k] : 0;
+      }
+
+    protected:
+      void run(const int& stages)
+      {
+        if (nbWorkers == 1)
+        {
+          runSlice(0, stages);
+          return;
+        }
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          this->stages = stages;
+          nbDone = 0;
+          ++generation;
+        }
+        startCondition.notify_all();
+        runSlice(0, stages);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (nbDone < nbWorkers - 1)
+          doneCondition.wait(lock);
+      }
+
+      void runSlice(const int& w, const int& stages)
+      {
+        const int nbAgents = int(runners.size());
+        const int begin = (w * nbAgents) / nbWorkers;
+        const int end = ((w + 1) * nbAgents) / nbWorkers;
+        for (int k = begin; k < end; k++)
+        {
+          if (stages & ACT)
+          {
+            runners[k]->act();
+            projection->at(k)->invalidate();
+          }
+          if (stages & ADVANCE)
+            runners[k]->advance();
+        }
+      }
+
+      void work(const int w)
+      {
+        int seen = 0;
+        for (;;)
+        {
+          int current;
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopping && generation == seen)
+              startCondition.wait(lock);
+            if (stopping)
+              return;
+            seen = generation;
+            current = stages;
+          }
+          runSlice(w, current);
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++nbDone;
+          }
+          doneCondition.notify_one();
+        }
+      }
+  };
+
+} // namespace RLLib
+
+#endif /* MULTIAGENT_H_ */
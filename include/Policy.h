@@ -25,6 +25,7 @@
 #include "Vector.h"
 #include "Action.h"
 #include "Mathema.h"
+#include "Trace.h"
 #include "Predictor.h"
 #include "StateToStateAction.h"
 
@@ -81,6 +82,28 @@ namespace RLLib
       virtual const Vectors<T>* computeGradLog(const Representations<T>* phis,
           const Action<T>* action) =0;
       virtual Vectors<T>* parameters() const =0;
+
+      /**
+       * Fused actor kernels: addGradLog does u_i += factor * gradLog_i(a|s), and updateTraces
+       * does e_i = lambda e_i + gradLog_i(a|s). Distributions whose gradient is a scaled copy of
+       * the active features override them to update in one sparse pass, without materializing
+       * the gradient.
+       */
+      virtual void addGradLog(const Representations<T>* phis, const Action<T>* action,
+          const T& factor, Vectors<T>* u)
+      {
+        const Vectors<T>* gradLog = computeGradLog(phis, action);
+        for (int i = 0; i < gradLog->dimension(); i++)
+          u->getEntry(i)->addToSelf(factor, gradLog->getEntry(i));
+      }
+
+      virtual void updateTraces(const Representations<T>* phis, const Action<T>* action,
+          const T& lambda, Traces<T>* e)
+      {
+        const Vectors<T>* gradLog = computeGradLog(phis, action);
+        for (int i = 0; i < gradLog->dimension(); i++)
+          e->getEntry(i)->update(lambda, gradLog->getEntry(i));
+      }
   };
 
   template<typename T>
@@ -95,7 +118,6 @@ namespace RLLib
       Vector<T>* u_stddev;
       Vector<T>* gradMean;
       Vector<T>* gradStddev;
-      Vector<T>* x;
       Vectors<T>* multiu;
       Vectors<T>* multigrad;
       const int defaultAction;
@@ -108,7 +130,7 @@ namespace RLLib
           sigma2(0), mean(0), stddev(0), meanStep(0), stddevStep(0), //
           u_mean(new PVector<T>(nbFeatures)), u_stddev(new PVector<T>(nbFeatures)), //
           gradMean(new SVector<T>(u_mean->dimension())), //
-          gradStddev(new SVector<T>(u_stddev->dimension())), x(new SVector<T>(nbFeatures)), //
+          gradStddev(new SVector<T>(u_stddev->dimension())), //
           multiu(new Vectors<T>()), multigrad(new Vectors<T>()), defaultAction(0)
       {
         multiu->push_back(u_mean);
@@ -123,7 +145,6 @@ namespace RLLib
         delete u_stddev;
         delete gradMean;
         delete gradStddev;
-        delete x;
         delete multiu;
         delete multigrad;
       }
@@ -133,7 +154,7 @@ namespace RLLib
       {
         // N(mu,var) for single action, single representation only
         ASSERT((phi->dimension() == 1) && (actions->dimension() == 1));
-        x->set(phi->at(actions->getEntry(defaultAction)));
+        const Vector<T>* x = phi->at(actions->getEntry(defaultAction));
         mean = u_mean->dot(x) + initialMean;
         stddev = exp(u_stddev->dot(x)) * initialStddev + 10e-8;
         ASSERT(Boundedness::checkValue(stddev));
@@ -170,12 +191,33 @@ namespace RLLib
       {
         ASSERT((phi->dimension() == 1) && (actions->dimension() == 1));
         updateStep(action);
-        x->set(phi->at(actions->getEntry(defaultAction)));
+        const Vector<T>* x = phi->at(actions->getEntry(defaultAction));
         gradMean->set(x)->mapMultiplyToSelf(meanStep);
         gradStddev->set(x)->mapMultiplyToSelf(stddevStep);
         return multigrad;
       }
 
+      // The gradients of the mean and of the stddev are both scaled copies of x
+      void addGradLog(const Representations<T>* phi, const Action<T>* action, const T& factor,
+          Vectors<T>* u)
+      {
+        ASSERT((phi->dimension() == 1) && (actions->dimension() == 1) && (u->dimension() == 2));
+        updateStep(action);
+        const Vector<T>* x = phi->at(actions->getEntry(defaultAction));
+        u->getEntry(0)->addToSelf(factor * meanStep, x);
+        u->getEntry(1)->addToSelf(factor * stddevStep, x);
+      }
+
+      void updateTraces(const Representations<T>* phi, const Action<T>* action, const T& lambda,
+          Traces<T>* e)
+      {
+        ASSERT((phi->dimension() == 1) && (actions->dimension() == 1) && (e->dimension() == 2));
+        updateStep(action);
+        const Vector<T>* x = phi->at(actions->getEntry(defaultAction));
+        e->getEntry(0)->update(lambda, x, meanStep);
+        e->getEntry(1)->update(lambda, x, stddevStep);
+      }
+
       Vectors<T>* parameters() const
       {
         return multiu;
@@ -314,6 +356,18 @@ namespace RLLib
         return policy->computeGradLog(phis, problemToPolicy(action->getEntry(0)));
       }
 
+      void addGradLog(const Representations<T>* phis, const Action<T>* action, const T& factor,
+          Vectors<T>* u)
+      {
+        policy->addGradLog(phis, problemToPolicy(action->getEntry(0)), factor, u);
+      }
+
+      void updateTraces(const Representations<T>* phis, const Action<T>* action, const T& lambda,
+          Traces<T>* e)
+      {
+        policy->updateTraces(phis, problemToPolicy(action->getEntry(0)), lambda, e);
+      }
+
       Vectors<T>* parameters() const
       {
         return policy->parameters();
@@ -327,17 +381,51 @@ namespace RLLib
       Random<T>* random;
       Actions<T>* actions;
       PVector<T>* distribution;
+      T* actionValues;
+      CumulativeTable<T>* cumulativeTable;
+      AliasTable<T>* aliasTable;
+      bool enableAliasSampling;
     public:
       StochasticPolicy(Random<T>* random, Actions<T>* actions) :
-          random(random), actions(actions), distribution(new PVector<T>(actions->dimension()))
+          random(random), actions(actions), distribution(new PVector<T>(actions->dimension())), //
+          actionValues(new T[actions->dimension()]), //
+          cumulativeTable(new CumulativeTable<T>(actions->dimension())), aliasTable(0), //
+          enableAliasSampling(false)
       {
       }
 
       virtual ~StochasticPolicy()
       {
         delete distribution;
+        delete[] actionValues;
+        delete cumulativeTable;
+        if (aliasTable)
+          delete aliasTable;
       }
 
+      /**
+       * The alias table costs more to build than the cumulative table, but samples in O(1).
+       * It pays off when the distribution is sampled many times between updates.
+       */
+      void setEnableAliasSampling(const bool& enableAliasSampling)
+      {
+        this->enableAliasSampling = enableAliasSampling;
+        if (enableAliasSampling && !aliasTable)
+          aliasTable = new AliasTable<T>(actions->dimension());
+        updateSampler();
+      }
+
+    protected:
+      // Needs to be called every time the distribution changes
+      void updateSampler()
+      {
+        if (enableAliasSampling)
+          aliasTable->update(distribution->getValues());
+        else
+          cumulativeTable->update(distribution->getValues());
+      }
+
+    public:
       T pi(const Action<T>* action)
       {
         return distribution->at(action->id());
@@ -346,15 +434,9 @@ namespace RLLib
       const Action<T>* sampleAction()
       {
         ASSERT(Boundedness::checkDistribution(distribution));
-        T rand = random->nextReal();
-        T sum = T(0);
-        for (typename Actions<T>::const_iterator a = actions->begin(); a != actions->end(); ++a)
-        {
-          sum += distribution->at((*a)->id());
-          if (sum >= rand)
-            return *a;
-        }
-        return actions->getEntry(actions->dimension() - 1);
+        if (enableAliasSampling)
+          return actions->getEntry(aliasTable->sample(random));
+        return actions->getEntry(cumulativeTable->sample(random));
       }
 
       const Action<T>* sampleBestAction()
@@ -396,39 +478,19 @@ namespace RLLib
       void update(const Representations<T>* phi)
       {
         ASSERT(Base::actions->dimension() == phi->dimension());
-        Base::distribution->clear();
         avg->clear();
-        T sum = T(0);
-        // The exponential function may become very large and overflow.
-        // Therefore, we multiply top and bottom of the hypothesis by the same
-        // constant without changing the output.
-        T maxValue = T(0);
-        for (typename Actions<T>::const_iterator a = Base::actions->begin();
-            a != Base::actions->end(); ++a)
-        {
-          T tmp = u->dot(phi->at(*a));
-          if (tmp > maxValue)
-            maxValue = tmp;
-        }
-        ASSERT(Boundedness::checkValue(maxValue));
+        Predictors::predictAll(u, phi, Base::actionValues);
+        ActionValues::boltzmann(Base::actionValues, phi->dimension(), T(1),
+            Base::distribution->getValues());
         for (typename Actions<T>::const_iterator a = Base::actions->begin();
             a != Base::actions->end(); ++a)
         {
-          const int id = (*a)->id();
-          Base::distribution->at(id) = exp(u->dot(phi->at(*a)) - maxValue);
-          ASSERT(Boundedness::checkValue(Base::distribution->at(id)));
-          sum += Base::distribution->at(id);
-          avg->addToSelf(Base::distribution->at(id), phi->at(*a));
+          const T pi = Base::distribution->at((*a)->id());
+          ASSERT(Boundedness::checkValue(pi));
+          if (pi != T(0))
+            avg->addToSelf(pi, phi->at(*a));
         }
-
-        for (typename Actions<T>::const_iterator a = Base::actions->begin();
-            a != Base::actions->end(); ++a)
-        {
-          const int id = (*a)->id();
-          Base::distribution->at(id) /= sum;
-          ASSERT(Boundedness::checkValue(Base::distribution->at(id)));
-        }
-        avg->mapMultiplyToSelf(1.0 / sum);
+        Base::updateSampler();
       }
 
       const Vectors<T>* computeGradLog(const Representations<T>* phi, const Action<T>* action)
@@ -438,6 +500,15 @@ namespace RLLib
         return multigrad;
       }
 
+      // u += factor * (phi(s,a) - sum_b pi(b|s) phi(s,b)); avg is computed in update()
+      void addGradLog(const Representations<T>* phi, const Action<T>* action, const T& factor,
+          Vectors<T>* u)
+      {
+        ASSERT(u->dimension() == 1);
+        u->getEntry(0)->addToSelf(factor, phi->at(action));
+        u->getEntry(0)->addToSelf(-factor, avg);
+      }
+
       Vectors<T>* parameters() const
       {
         return multiu;
@@ -480,37 +551,10 @@ namespace RLLib
       void update(const Representations<T>* phi)
       {
         ASSERT(Base::actions->dimension() == phi->dimension());
-        Base::distribution->clear();
-        T sum = T(0);
-        // The exponential function may become very large and overflow.
-        // Therefore, we multiply top and bottom of the hypothesis by the same
-        // constant without changing the output.
-        T maxValue = T(0);
-        for (typename Actions<T>::const_iterator a = Base::actions->begin();
-            a != Base::actions->end(); ++a)
-        {
-          T tmp = predictor->predict(phi->at(*a));
-          if (tmp > maxValue)
-            maxValue = tmp;
-        }
-
-        for (typename Actions<T>::const_iterator a = Base::actions->begin();
-            a != Base::actions->end(); ++a)
-        {
-          const int id = (*a)->id();
-          Base::distribution->at(id) = exp(
-              (predictor->predict(phi->at(*a)) - maxValue) / temperature);
-          ASSERT(Boundedness::checkValue(Base::distribution->at(id)));
-          sum += Base::distribution->at(id);
-        }
-
-        for (typename Actions<T>::const_iterator a = Base::actions->begin();
-            a != Base::actions->end(); ++a)
-        {
-          const int id = (*a)->id();
-          Base::distribution->at(id) /= sum;
-          ASSERT(Boundedness::checkValue(Base::distribution->at(id)));
-        }
+        predictor->predictAll(phi, Base::actionValues);
+        ActionValues::boltzmann(Base::actionValues, phi->dimension(), temperature,
+            Base::distribution->getValues());
+        Base::updateSampler();
       }
   };
 
@@ -561,16 +605,19 @@ namespace RLLib
       Actions<T>* actions;
       const Action<T>* previousAction;
       PVector<T>* distribution;
+      CumulativeTable<T>* cumulativeTable;
     public:
       RandomBiasPolicy(Random<T>* random, Actions<T>* actions) :
           random(random), actions(actions), previousAction(actions->getEntry(0)), //
-          distribution(new PVector<T>(actions->dimension()))
+          distribution(new PVector<T>(actions->dimension())), //
+          cumulativeTable(new CumulativeTable<T>(actions->dimension()))
       {
       }
 
       virtual ~RandomBiasPolicy()
       {
         delete distribution;
+        delete cumulativeTable;
       }
 
       void update(const Representations<T>* phi)
@@ -591,19 +638,8 @@ namespace RLLib
           }
         }
         // chose an action
-        T rand = random->nextReal();
-        T sum = T(0);
-        for (typename Actions<T>::const_iterator a = actions->begin(); a != actions->end(); ++a)
-        {
-          sum += distribution->at((*a)->id());
-          if (sum >= rand)
-          {
-            previousAction = *a;
-            return;
-          }
-        }
-
-        previousAction = actions->getEntry(actions->dimension() - 1);
+        cumulativeTable->update(distribution->getValues());
+        previousAction = actions->getEntry(cumulativeTable->sample(random));
       }
 
       T pi(const Action<T>* action)
@@ -649,26 +685,15 @@ namespace RLLib
 
       void updateActionValues(const Representations<T>* phi_tp1)
       {
-        for (typename Actions<T>::const_iterator iter = actions->begin(); iter != actions->end();
-            ++iter)
-        {
-          const int id = (*iter)->id();
-          actionValues[id] = predictor->predict(phi_tp1->at(*iter));
-        }
+        ASSERT(actions->dimension() == phi_tp1->dimension());
+        predictor->predictAll(phi_tp1, actionValues);
       }
 
       void findBestAction()
       {
-        bestValue = actionValues[0];
-        bestAction = actions->getEntry(0);
-        for (int i = 1; i < actions->dimension(); i++)
-        {
-          if (actionValues[i] > actionValues[bestAction->id()])
-          {
-            bestValue = actionValues[i];
-            bestAction = actions->getEntry(i);
-          }
-        }
+        const int best = ActionValues::argmax(actionValues, actions->dimension());
+        bestValue = actionValues[best];
+        bestAction = actions->getEntry(best);
       }
 
     public:
@@ -739,6 +764,8 @@ namespace RLLib
       Actions<T>* actions;
       Vector<T>* u;
       PVector<T>* distribution;
+      T* actionValues;
+      CumulativeTable<T>* cumulativeTable;
       T epsilon;
       T perturbation;
 
@@ -746,7 +773,8 @@ namespace RLLib
       BoltzmannDistributionPerturbed(Random<T>* random, Actions<T>* actions, Vector<T>* u,
           const T& epsilon, const T& perturbation) :
           random(random), actions(actions), u(u), distribution(
-              new PVector<T>(actions->dimension())), //
+              new PVector<T>(actions->dimension())), actionValues(new T[actions->dimension()]), //
+          cumulativeTable(new CumulativeTable<T>(actions->dimension())), //
           epsilon(epsilon), perturbation(perturbation)
       {
       }
@@ -754,40 +782,21 @@ namespace RLLib
       virtual ~BoltzmannDistributionPerturbed()
       {
         delete distribution;
+        delete[] actionValues;
+        delete cumulativeTable;
       }
 
       void update(const Representations<T>* phis)
       {
         ASSERT(actions->dimension() == phis->dimension());
-        distribution->clear();
-        T sum = T(0);
-        // The exponential function may become very large and overflow.
-        // Therefore, we multiply top and bottom of the hypothesis by the same
-        // constant without changing the output.
-        T maxValue = T(0);
+        Predictors::predictAll(u, phis, actionValues);
         for (typename Actions<T>::const_iterator a = actions->begin(); a != actions->end(); ++a)
         {
-          T tmp = u->dot(phis->at(*a));
-          if (tmp > maxValue)
-            maxValue = tmp;
+          if (random->nextReal() < epsilon)
+            actionValues[(*a)->id()] += perturbation;
         }
-
-        for (typename Actions<T>::const_iterator a = actions->begin(); a != actions->end(); ++a)
-        {
-          const int id = (*a)->id();
-          T perturb = random->nextReal() < epsilon ? perturbation : T(0);
-          distribution->at(id) = exp(u->dot(phis->at(*a)) + perturb - maxValue);
-          ASSERT(Boundedness::checkValue(distribution->at(id)));
-          sum += distribution->at(id);
-        }
-
-        for (typename Actions<T>::const_iterator a = actions->begin(); a != actions->end(); ++a)
-        {
-          const int id = (*a)->id();
-          distribution->at(id) /= sum;
-          ASSERT(Boundedness::checkValue(distribution->at(id)));
-        }
-
+        ActionValues::boltzmann(actionValues, phis->dimension(), T(1), distribution->getValues());
+        cumulativeTable->update(distribution->getValues());
       }
 
       T pi(const Action<T>* action)
@@ -797,15 +806,7 @@ namespace RLLib
 
       const Action<T>* sampleAction()
       {
-        T rand = random->nextReal();
-        T sum = T(0);
-        for (typename Actions<T>::const_iterator a = actions->begin(); a != actions->end(); ++a)
-        {
-          sum += distribution->at((*a)->id());
-          if (sum >= rand)
-            return *a;
-        }
-        return actions->getEntry(actions->dimension() - 1);
+        return actions->getEntry(cumulativeTable->sample(random));
       }
 
       const Action<T>* sampleBestAction()
@@ -859,6 +860,7 @@ namespace RLLib
         ASSERT(actions->dimension() == distribution->dimension());
         for (int i = 0; i < distribution->dimension(); i++)
           Base::distribution->at(i) = distribution->getEntry(i);
+        Base::updateSampler();
       }
 
       virtual ~ConstantPolicy()
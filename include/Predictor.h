@@ -22,8 +22,11 @@
 #ifndef PREDICTOR_H_
 #define PREDICTOR_H_
 
+#include <functional>
+
 #include "Vector.h"
 #include "Function.h"
+#include "StateToStateAction.h"
 
 namespace RLLib
 {
@@ -37,6 +40,159 @@ namespace RLLib
       }
       virtual T predict(const Vector<T>* x) const =0;
       virtual Vector<T>* weights() const =0;
+
+      // Evaluates all the action representations in one call; out[a.id()] = predict(phis[a]).
+      virtual void predictAll(const Representations<T>* phis, T* out) const
+      {
+        for (int i = 0; i < phis->dimension(); i++)
+          out[i] = predict(phis->at(i));
+      }
+  };
+
+  class Predictors
+  {
+    public:
+      /**
+       * Batched dot product of the same weight vector with all the action representations. The
+       * weight vector type is resolved once, and each tile-coded representation is reduced
+       * directly against the raw dense weights.
+       */
+      template<typename T>
+      static void predictAll(const Vector<T>* weights, const Representations<T>* phis, T* out)
+      {
+        const DenseVector<T>* dense = RTTI<T>::constDenseVector(weights);
+        if (!dense)
+        {
+          for (int i = 0; i < phis->dimension(); i++)
+            out[i] = weights->dot(phis->at(i));
+          return;
+        }
+        const T* data = dense->getValues();
+        for (int i = 0; i < phis->dimension(); i++)
+        {
+          const SparseVector<T>* phi = RTTI<T>::constSparseVector(phis->at(i));
+          out[i] = phi ? phi->dotProduct(data) : weights->dot(phis->at(i));
+        }
+      }
+  };
+
+  /**
+   * v.x_t of an update, carried forward from v.x_tp1 of the previous one: the changes of v in
+   * between, v += factor * u, are added as factor * u.x_tp1, over the common support of u and
+   * x_tp1 only; a change along x_tp1 itself adds factor * ||x_tp1||^2, from the active entries of
+   * x_tp1 (hashed tile coders lose entries on collisions). Exact only when x_t is the previous
+   * x_tp1, hence off by default; e.g., not with the expected features of ExpectedSarsaControl, nor
+   * with GQ behind GreedyGQ. follows() checks it in debug builds.
+   */
+  template<typename T>
+  class PredictionCache
+  {
+    protected:
+      bool enabled;
+      bool valid;
+      T v_tp1;
+#if !defined(NDEBUG)
+      size_t x_tp1;
+#endif
+
+    public:
+      PredictionCache() :
+          enabled(false), valid(false), v_tp1(0)
+      {
+      }
+
+      void setEnabled(const bool& enabled)
+      {
+        this->enabled = enabled;
+        valid = false;
+      }
+
+      bool isEnabled() const
+      {
+        return enabled;
+      }
+
+      // Once v changes otherwise, or x_t is not the previous x_tp1
+      void invalidate()
+      {
+        valid = false;
+      }
+
+      // v.x_t
+      T dot(const Vector<T>* v, const Vector<T>* x_t) const
+      {
+        return valid ? v_tp1 : v->dot(x_t);
+      }
+
+      // v.x_tp1, before the changes of v
+      void carry(const T& v_tp1, const Vector<T>* x_tp1)
+      {
+        this->v_tp1 = v_tp1;
+        valid = enabled;
+#if !defined(NDEBUG)
+        if (valid)
+          this->x_tp1 = fingerprint(x_tp1);
+#endif
+      }
+
+      // After v += factor * u
+      void correct(const T& factor, const Vector<T>* u, const Vector<T>* x_tp1)
+      {
+        if (valid)
+          v_tp1 += factor * u->dot(x_tp1);
+      }
+
+      // After v += factor * x_tp1; O(active entries), without reading v
+      void correct(const T& factor, const Vector<T>* x_tp1)
+      {
+        if (!valid)
+          return;
+        T squaredNorm = T(0);
+        const SparseVector<T>* sparse = RTTI<T>::constSparseVector(x_tp1);
+        if (sparse)
+        {
+          const T* values = sparse->getValues();
+          for (int k = 0; k < sparse->nonZeroElements(); k++)
+            squaredNorm += values[k] * values[k];
+        }
+        else
+        {
+          for (int i = 0; i < x_tp1->dimension(); i++)
+            squaredNorm += x_tp1->getEntry(i) * x_tp1->getEntry(i);
+        }
+        v_tp1 += factor * squaredNorm;
+      }
+
+      // Whether x_t is the x_tp1 carried forward; always true in release builds
+      bool follows(const Vector<T>* x_t) const
+      {
+#if !defined(NDEBUG)
+        return !valid || fingerprint(x_t) == x_tp1;
+#else
+        return true;
+#endif
+      }
+
+    private:
+      // Independent of the order of the active entries
+      static size_t fingerprint(const Vector<T>* x)
+      {
+        size_t result = 0;
+        const SparseVector<T>* sparse = RTTI<T>::constSparseVector(x);
+        if (sparse)
+        {
+          for (int k = 0; k < sparse->nonZeroElements(); k++)
+            result += (size_t(sparse->nonZeroIndexes()[k]) + 1) * size_t(2654435761u)
+                ^ std::hash<T>()(sparse->getValues()[k]);
+          return result;
+        }
+        for (int i = 0; i < x->dimension(); i++)
+        {
+          if (x->getEntry(i) != T(0))
+            result += (size_t(i) + 1) * size_t(2654435761u) ^ std::hash<T>()(x->getEntry(i));
+        }
+        return result;
+      }
   };
 
   template<typename T>
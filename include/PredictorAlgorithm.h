@@ -22,10 +22,18 @@
 #ifndef PREDICTORALGORITHM_H_
 #define PREDICTORALGORITHM_H_
 
+#include <map>
+#include <queue>
+#include <vector>
+
 #include "Predictor.h"
 #include "Vector.h"
 #include "Trace.h"
 
+#if !defined(EMBEDDED_MODE)
+#include "Timer.h"
+#endif
+
 namespace RLLib
 {
 
@@ -39,6 +47,7 @@ namespace RLLib
       T gamma;
       Vector<T>* v;
       bool initialized;
+      PredictionCache<T> cache;
     public:
       TD(const T& alpha_v, const T& gamma, const int& nbFeatures) :
           delta_t(0), alpha_v(alpha_v), gamma(gamma), v(new PVector<T>(nbFeatures)), //
@@ -56,6 +65,7 @@ namespace RLLib
       {
         initialized = true;
         delta_t = 0;
+        cache.invalidate();
         return delta_t;
       }
 
@@ -77,6 +87,7 @@ namespace RLLib
       void reset()
       {
         v->clear();
+        cache.invalidate();
       }
 
       T predict(const Vector<T>* x) const
@@ -84,6 +95,11 @@ namespace RLLib
         return v->dot(x);
       }
 
+      void predictAll(const Representations<T>* phis, T* out) const
+      {
+        Predictors::predictAll(v, phis, out);
+      }
+
       void persist(const char* f) const
       {
         v->persist(f);
@@ -92,6 +108,7 @@ namespace RLLib
       void resurrect(const char* f)
       {
         v->resurrect(f);
+        cache.invalidate();
       }
 
       Vector<T>* weights() const
@@ -151,13 +168,22 @@ namespace RLLib
       {
       }
 
+      // v.x_t carried forward from the previous update; see PredictionCache
+      void setIncremental(const bool& incremental)
+      {
+        TD<T>::cache.setEnabled(incremental);
+      }
+
     public:
       T update(const Vector<T>* x_t, const Vector<T>* x_tp1, const T& r_tp1, const T& gamma_tp1)
       {
         ASSERT(TD<T>::initialized);
-        TD<T>::delta_t = r_tp1 + gamma_tp1 * TD<T>::v->dot(x_tp1) - TD<T>::v->dot(x_t);
+        const T v_tp1 = TD<T>::v->dot(x_tp1);
+        TD<T>::delta_t = r_tp1 + gamma_tp1 * v_tp1 - TD<T>::cache.dot(TD<T>::v, x_t);
         Base::e->update(Base::lambda * Base::gamma_t, x_t, TD<T>::alpha_v);
         TD<T>::v->addToSelf(TD<T>::delta_t, Base::e->vect());
+        TD<T>::cache.carry(v_tp1, x_tp1);
+        TD<T>::cache.correct(TD<T>::delta_t, Base::e->vect(), x_tp1);
         Base::gamma_t = gamma_tp1;
         return TD<T>::delta_t;
       }
@@ -213,18 +239,15 @@ namespace RLLib
   {
     private:
       typedef TDLambdaAbstract<T> Base;
-      Vector<T>* gammaXtp1MinusX;
 
     public:
       TDLambdaAlphaBound(const T& alpha, const T& gamma, const T& lambda, Trace<T>* e) :
-          TDLambdaAbstract<T>(alpha, gamma, lambda, e), //
-          gammaXtp1MinusX(new SVector<T>(e->vect()->dimension()))
+          TDLambdaAbstract<T>(alpha, gamma, lambda, e)
       {
       }
 
       virtual ~TDLambdaAlphaBound()
       {
-        delete gammaXtp1MinusX;
       }
 
       void reset()
@@ -236,10 +259,8 @@ namespace RLLib
     private:
       void updateAlpha(const Vector<T>* x_t, const Vector<T>* x_tp1, const T& gamma_tp1)
       {
-        // Update the adaptive step-size
-        T b = std::abs(
-            Base::e->vect()->dot(
-                gammaXtp1MinusX->set(x_tp1)->mapMultiplyToSelf(gamma_tp1)->subtractToSelf(x_t)));
+        // Update the adaptive step-size; e.(gamma x_tp1 - x_t), without the difference vector
+        T b = std::abs(gamma_tp1 * Base::e->vect()->dot(x_tp1) - Base::e->vect()->dot(x_t));
         if (b > 0.0f)
           TD<T>::alpha_v = std::min(TD<T>::alpha_v, 1.0f / b);
       }
@@ -258,6 +279,639 @@ namespace RLLib
 
   };
 
+  /**
+   * LSTD(lambda) (Boyan, 2002) with the inverse of A maintained by Sherman-Morrison rank one
+   * updates: A_t = epsilon * I + sum z_k (x_k - gamma x_kp1)^T, b_t = sum z_k r_kp1, and
+   * v = A_t^-1 b_t. Each step is O(n^2) in time and memory, without any step size; hence it is
+   * meant for small feature sets where samples are expensive.
+   */
+  template<typename T>
+  class LSTDLambda: public OnPolicyTD<T>
+  {
+    protected:
+      T gamma, lambda, epsilon, gamma_t;
+      int nbFeatures;
+      T delta_t;
+      Trace<T>* e;
+      Vector<T>* v;
+      Vector<T>* b;
+      Vector<T>* d;
+      T* C;
+      T* Cz;
+      T* dC;
+      bool initialized;
+
+    public:
+      LSTDLambda(const T& gamma, const T& lambda, Trace<T>* e, const T& epsilon = T(1e-3)) :
+          gamma(gamma), lambda(lambda), epsilon(epsilon), gamma_t(gamma), //
+          nbFeatures(e->vect()->dimension()), delta_t(0), e(e), //
+          v(new PVector<T>(nbFeatures)), b(new PVector<T>(nbFeatures)), //
+          d(new SVector<T>(nbFeatures)), C(new T[nbFeatures * nbFeatures]), //
+          Cz(new T[nbFeatures]), dC(new T[nbFeatures]), initialized(false)
+      {
+        reset();
+      }
+
+      virtual ~LSTDLambda()
+      {
+        delete v;
+        delete b;
+        delete d;
+        delete[] C;
+        delete[] Cz;
+        delete[] dC;
+      }
+
+      T initialize()
+      {
+        initialized = true;
+        e->clear();
+        gamma_t = gamma;
+        delta_t = 0;
+        return delta_t;
+      }
+
+      void reset()
+      {
+        e->clear();
+        v->clear();
+        b->clear();
+        gamma_t = gamma;
+        initialized = false;
+        // A_0 = epsilon * I
+        std::fill(C, C + nbFeatures * nbFeatures, T(0));
+        for (int i = 0; i < nbFeatures; i++)
+          C[i * nbFeatures + i] = T(1) / epsilon;
+      }
+
+      T update(const Vector<T>* x_t, const Vector<T>* x_tp1, const T& r_tp1, const T& gamma_tp1)
+      {
+        ASSERT(initialized);
+        const bool terminal = x_tp1->empty();
+        delta_t = r_tp1 + (terminal ? T(0) : gamma_tp1 * v->dot(x_tp1)) - v->dot(x_t);
+        e->update(lambda * gamma_t, x_t);
+        d->set(x_t);
+        if (!terminal)
+          d->addToSelf(-gamma_tp1, x_tp1);
+
+        const SparseVector<T>* z = RTTI<T>::constSparseVector(e->vect());
+        const SparseVector<T>* sd = RTTI<T>::constSparseVector(d);
+        ASSERT(z && sd);
+        // Cz = C z and dC = d^T C, over the active entries only
+        for (int i = 0; i < nbFeatures; i++)
+          Cz[i] = z->dotProduct(C + i * nbFeatures);
+        std::fill(dC, dC + nbFeatures, T(0));
+        for (int k = 0; k < sd->nonZeroElements(); k++)
+        {
+          const T d_k = sd->getValues()[k];
+          const T* C_k = C + sd->nonZeroIndexes()[k] * nbFeatures;
+          for (int j = 0; j < nbFeatures; j++)
+            dC[j] += d_k * C_k[j];
+        }
+        const T denominator = T(1) + z->dotProduct(dC);
+        ASSERT(Boundedness::checkValue(denominator));
+        if (std::abs(denominator) > std::numeric_limits<T>::epsilon())
+        {
+          // C <- C - (C z)(d^T C) / (1 + d^T C z)
+          for (int i = 0; i < nbFeatures; i++)
+          {
+            const T factor = Cz[i] / denominator;
+            T* C_i = C + i * nbFeatures;
+            for (int j = 0; j < nbFeatures; j++)
+              C_i[j] -= factor * dC[j];
+          }
+        }
+        b->addToSelf(r_tp1, e->vect());
+        // v = C b
+        const T* b_values = b->getValues();
+        T* v_values = v->getValues();
+        for (int i = 0; i < nbFeatures; i++)
+        {
+          const T* C_i = C + i * nbFeatures;
+          T sum = T(0);
+          for (int j = 0; j < nbFeatures; j++)
+            sum += C_i[j] * b_values[j];
+          v_values[i] = sum;
+        }
+        gamma_t = gamma_tp1;
+        return delta_t;
+      }
+
+      T update(const Vector<T>* x_t, const Vector<T>* x_tp1, const T& r_tp1)
+      {
+        return update(x_t, x_tp1, r_tp1, gamma);
+      }
+
+      T predict(const Vector<T>* x) const
+      {
+        return v->dot(x);
+      }
+
+      void predictAll(const Representations<T>* phis, T* out) const
+      {
+        Predictors::predictAll(v, phis, out);
+      }
+
+      void persist(const char* f) const
+      {
+        v->persist(f);
+      }
+
+      void resurrect(const char* f)
+      {
+        v->resurrect(f);
+      }
+
+      Vector<T>* weights() const
+      {
+        return v;
+      }
+  };
+
+  /**
+   * iLSTD(lambda) (Geramifard, Bowling and Sutton, 2006). A and b are accumulated as in LSTD,
+   * but A is kept as sparse columns and, instead of solving the system, the residual
+   * mu = b - A v is tracked incrementally. At each step only the nbDimensions components with
+   * the largest residuals are updated: v_j += alpha_t * mu_j, mu -= alpha_t * mu_j * A e_j, with
+   * alpha_t = alpha / t since A and mu are sums over the t samples seen so far. The residuals
+   * are kept in a max-heap of (|mu_j|, j) that is only pushed at the entries the sparse updates
+   * change; entries that no longer match |mu_j| are dropped when they reach the top, and the heap
+   * is compacted once they outnumber the live ones. The cost per step is proportional to the
+   * active features and the selected columns, times the log of the heap size, which suits large
+   * tile-coded feature sets.
+   */
+  template<typename T>
+  class ILSTDLambda: public OnPolicyTD<T>
+  {
+    protected:
+      typedef std::map<int, T> Column;
+      typedef std::pair<T, int> Priority;
+      T alpha, gamma, lambda, gamma_t;
+      int nbFeatures;
+      int nbDimensions;
+      int nbSamples;
+      T delta_t;
+      Trace<T>* e;
+      Vector<T>* v;
+      Vector<T>* d;
+      PVector<T>* mu;
+      std::vector<Column> A;
+      std::vector<Priority> heap;
+      T* queued; // |mu_j| of the live heap entry of j, or 0 when j is not in the heap
+      int nbQueued;
+      bool initialized;
+
+    public:
+      ILSTDLambda(const T& alpha, const T& gamma, const T& lambda, Trace<T>* e,
+          const int& nbDimensions = 1) :
+          alpha(alpha), gamma(gamma), lambda(lambda), gamma_t(gamma), //
+          nbFeatures(e->vect()->dimension()), nbDimensions(std::min(nbDimensions, nbFeatures)), //
+          nbSamples(0), delta_t(0), e(e), v(new PVector<T>(nbFeatures)), //
+          d(new SVector<T>(nbFeatures)), mu(new PVector<T>(nbFeatures)), A(nbFeatures), //
+          queued(new T[nbFeatures]), nbQueued(0), initialized(false)
+      {
+        std::fill(queued, queued + nbFeatures, T(0));
+      }
+
+      virtual ~ILSTDLambda()
+      {
+        delete v;
+        delete d;
+        delete mu;
+        delete[] queued;
+      }
+
+    protected:
+      // After mu_j has changed
+      void enqueue(const int& j)
+      {
+        const T priority = std::abs(mu->getValues()[j]);
+        if (priority == queued[j])
+          return;
+        if (queued[j] == T(0))
+          ++nbQueued;
+        else if (priority == T(0))
+          --nbQueued;
+        queued[j] = priority;
+        if (priority == T(0))
+          return;
+        heap.push_back(Priority(priority, j));
+        std::push_heap(heap.begin(), heap.end());
+      }
+
+      // The feature with the largest residual, or -1 when every residual is zero
+      int dequeue()
+      {
+        while (!heap.empty())
+        {
+          const Priority top = heap.front();
+          std::pop_heap(heap.begin(), heap.end());
+          heap.pop_back();
+          if (top.first == queued[top.second])
+          {
+            queued[top.second] = T(0);
+            --nbQueued;
+            return top.second;
+          }
+        }
+        return -1;
+      }
+
+      // Drops the stale entries once they are the majority
+      void compact()
+      {
+        if (int(heap.size()) <= 2 * nbQueued + 1024)
+          return;
+        typename std::vector<Priority>::iterator last = heap.begin();
+        for (typename std::vector<Priority>::const_iterator iter = heap.begin();
+            iter != heap.end(); ++iter)
+        {
+          if (iter->first == queued[iter->second])
+            *last++ = *iter;
+        }
+        heap.erase(last, heap.end());
+        std::make_heap(heap.begin(), heap.end());
+      }
+
+    public:
+
+      T initialize()
+      {
+        initialized = true;
+        e->clear();
+        gamma_t = gamma;
+        delta_t = 0;
+        return delta_t;
+      }
+
+      void reset()
+      {
+        e->clear();
+        v->clear();
+        mu->clear();
+        for (typename std::vector<Column>::iterator iter = A.begin(); iter != A.end(); ++iter)
+          iter->clear();
+        heap.clear();
+        std::fill(queued, queued + nbFeatures, T(0));
+        nbQueued = 0;
+        nbSamples = 0;
+        gamma_t = gamma;
+        initialized = false;
+      }
+
+      T update(const Vector<T>* x_t, const Vector<T>* x_tp1, const T& r_tp1, const T& gamma_tp1)
+      {
+        ASSERT(initialized);
+        const bool terminal = x_tp1->empty();
+        delta_t = r_tp1 + (terminal ? T(0) : gamma_tp1 * v->dot(x_tp1)) - v->dot(x_t);
+        e->update(lambda * gamma_t, x_t);
+        d->set(x_t);
+        if (!terminal)
+          d->addToSelf(-gamma_tp1, x_tp1);
+
+        const SparseVector<T>* z = RTTI<T>::constSparseVector(e->vect());
+        const SparseVector<T>* sd = RTTI<T>::constSparseVector(d);
+        ASSERT(z && sd);
+        // A += z d^T, mu += z r - z (d^T v)
+        for (int k = 0; k < sd->nonZeroElements(); k++)
+        {
+          Column& column = A[sd->nonZeroIndexes()[k]];
+          const T d_k = sd->getValues()[k];
+          for (int i = 0; i < z->nonZeroElements(); i++)
+            column[z->nonZeroIndexes()[i]] += z->getValues()[i] * d_k;
+        }
+        mu->addToSelf(r_tp1 - d->dot(v), z);
+        for (int i = 0; i < z->nonZeroElements(); i++)
+          enqueue(z->nonZeroIndexes()[i]);
+        ++nbSamples;
+
+        // Descent on the dimensions with the largest residuals
+        T* mu_values = mu->getValues();
+        T* v_values = v->getValues();
+        for (int k = 0; k < nbDimensions; k++)
+        {
+          const int j = dequeue();
+          if (j < 0)
+            break;
+          const T step = alpha * mu_values[j] / nbSamples;
+          v_values[j] += step;
+          const Column& column = A[j];
+          for (typename Column::const_iterator iter = column.begin(); iter != column.end(); ++iter)
+          {
+            mu_values[iter->first] -= step * iter->second;
+            enqueue(iter->first);
+          }
+          enqueue(j);
+        }
+        compact();
+        gamma_t = gamma_tp1;
+        return delta_t;
+      }
+
+      T update(const Vector<T>* x_t, const Vector<T>* x_tp1, const T& r_tp1)
+      {
+        return update(x_t, x_tp1, r_tp1, gamma);
+      }
+
+      T predict(const Vector<T>* x) const
+      {
+        return v->dot(x);
+      }
+
+      void predictAll(const Representations<T>* phis, T* out) const
+      {
+        Predictors::predictAll(v, phis, out);
+      }
+
+      void persist(const char* f) const
+      {
+        v->persist(f);
+      }
+
+      void resurrect(const char* f)
+      {
+        v->resurrect(f);
+      }
+
+      Vector<T>* weights() const
+      {
+        return v;
+      }
+  };
+
+  /**
+   * Linear Dyna (Sutton, Szepesvari, Geramifard and Bowling, 2008) with prioritized sweeping.
+   * Alongside TD(lambda) on the real transitions, a linear expectation model is learned over the
+   * same features: phi_tp1 ~ F phi_t and r_tp1 ~ b^T phi_t, with F kept as sparse columns. The
+   * features touched by a real update are queued with priority |delta * phi_i|; a planning step
+   * pops the feature i with the highest priority and backs up every feature j that leads to it
+   * (F_ij != 0) with the simulated transition e_j -> (b_j, F e_j), queueing j in turn. The
+   * planning stops after nbPlanningSteps backups, or when the time budget of the step is spent,
+   * so the spare cycles of a control step are turned into extra updates.
+   */
+  template<typename T>
+  class LinearDyna: public OnPolicyTD<T>
+  {
+    protected:
+      typedef std::map<int, T> Column;
+      typedef std::pair<T, int> Priority;
+      T alpha_v, alpha_m, gamma, lambda, gamma_t;
+      int nbFeatures;
+      int nbPlanningSteps;
+      double planningTimeBudgetInMilliseconds;
+      T priorityThreshold;
+      T delta_t;
+      bool initialized;
+      Trace<T>* e;
+      Vector<T>* v;
+      Vector<T>* b;
+      Vector<T>* phi_t;
+      Vector<T>* phi_tp1;
+      std::vector<Column> F;
+      std::vector<std::vector<int> > predecessors;
+      std::priority_queue<Priority> queue;
+      T* queued; // current priority of the queued features, older entries are skipped
+      T* modelError;
+      bool* touched;
+      std::vector<int> touchedIndexes;
+      int nbPlanningUpdates;
+#if !defined(EMBEDDED_MODE)
+      Timer timer;
+#endif
+
+    public:
+      LinearDyna(const T& alpha_v, const T& alpha_m, const T& gamma, const T& lambda,
+          Trace<T>* e, const int& nbPlanningSteps = 10) :
+          alpha_v(alpha_v), alpha_m(alpha_m), gamma(gamma), lambda(lambda), gamma_t(gamma), //
+          nbFeatures(e->vect()->dimension()), nbPlanningSteps(nbPlanningSteps), //
+          planningTimeBudgetInMilliseconds(0), priorityThreshold(0), delta_t(0), //
+          initialized(false), e(e), v(new PVector<T>(nbFeatures)), b(new PVector<T>(nbFeatures)), //
+          phi_t(new SVector<T>(nbFeatures)), phi_tp1(new SVector<T>(nbFeatures)), F(nbFeatures), //
+          predecessors(nbFeatures), queued(new T[nbFeatures]), modelError(new T[nbFeatures]), //
+          touched(new bool[nbFeatures]), nbPlanningUpdates(0)
+      {
+        std::fill(queued, queued + nbFeatures, T(0));
+        std::fill(modelError, modelError + nbFeatures, T(0));
+        std::fill(touched, touched + nbFeatures, false);
+      }
+
+      virtual ~LinearDyna()
+      {
+        delete v;
+        delete b;
+        delete phi_t;
+        delete phi_tp1;
+        delete[] queued;
+        delete[] modelError;
+        delete[] touched;
+      }
+
+      void setNbPlanningSteps(const int& nbPlanningSteps)
+      {
+        this->nbPlanningSteps = nbPlanningSteps;
+      }
+
+      // Upper bound on the planning time of a step; 0 leaves only the number of planning steps
+      void setPlanningTimeBudget(const double& planningTimeBudgetInMilliseconds)
+      {
+        this->planningTimeBudgetInMilliseconds = planningTimeBudgetInMilliseconds;
+      }
+
+      void setPriorityThreshold(const T& priorityThreshold)
+      {
+        this->priorityThreshold = priorityThreshold;
+      }
+
+      // Number of planning backups done during the last step
+      int getNbPlanningUpdates() const
+      {
+        return nbPlanningUpdates;
+      }
+
+      T initialize()
+      {
+        initialized = true;
+        e->clear();
+        gamma_t = gamma;
+        delta_t = 0;
+        return delta_t;
+      }
+
+      void reset()
+      {
+        e->clear();
+        v->clear();
+        b->clear();
+        for (int i = 0; i < nbFeatures; i++)
+        {
+          F[i].clear();
+          predecessors[i].clear();
+        }
+        queue = std::priority_queue<Priority>();
+        std::fill(queued, queued + nbFeatures, T(0));
+        gamma_t = gamma;
+        initialized = false;
+      }
+
+      T update(const Vector<T>* x_t, const Vector<T>* x_tp1, const T& r_tp1, const T& gamma_tp1)
+      {
+        ASSERT(initialized);
+        const bool terminal = x_tp1->empty();
+        phi_t->set(x_t);
+        if (terminal)
+          phi_tp1->clear();
+        else
+          phi_tp1->set(x_tp1);
+        // TD(lambda) on the real transition
+        delta_t = r_tp1 + gamma_tp1 * v->dot(phi_tp1) - v->dot(phi_t);
+        e->update(lambda * gamma_t, phi_t, alpha_v);
+        v->addToSelf(delta_t, e->vect());
+        gamma_t = gamma_tp1;
+
+        updateModel(r_tp1);
+
+        const SparseVector<T>* sphi_t = RTTI<T>::constSparseVector(phi_t);
+        for (int k = 0; k < sphi_t->nonZeroElements(); k++)
+          enqueue(sphi_t->nonZeroIndexes()[k], std::abs(delta_t * sphi_t->getValues()[k]));
+        plan();
+        return delta_t;
+      }
+
+      T update(const Vector<T>* x_t, const Vector<T>* x_tp1, const T& r_tp1)
+      {
+        return update(x_t, x_tp1, r_tp1, gamma);
+      }
+
+      T predict(const Vector<T>* x) const
+      {
+        return v->dot(x);
+      }
+
+      void predictAll(const Representations<T>* phis, T* out) const
+      {
+        Predictors::predictAll(v, phis, out);
+      }
+
+      void persist(const char* f) const
+      {
+        v->persist(f);
+      }
+
+      void resurrect(const char* f)
+      {
+        v->resurrect(f);
+      }
+
+      Vector<T>* weights() const
+      {
+        return v;
+      }
+
+    protected:
+      // F += alpha_m (phi_tp1 - F phi_t) phi_t^T, b += alpha_m (r_tp1 - b^T phi_t) phi_t
+      void updateModel(const T& r_tp1)
+      {
+        const SparseVector<T>* sphi_t = RTTI<T>::constSparseVector(phi_t);
+        const SparseVector<T>* sphi_tp1 = RTTI<T>::constSparseVector(phi_tp1);
+        for (int k = 0; k < sphi_tp1->nonZeroElements(); k++)
+          touch(sphi_tp1->nonZeroIndexes()[k], sphi_tp1->getValues()[k]);
+        for (int k = 0; k < sphi_t->nonZeroElements(); k++)
+        {
+          const Column& column = F[sphi_t->nonZeroIndexes()[k]];
+          const T phi_j = sphi_t->getValues()[k];
+          for (typename Column::const_iterator iter = column.begin(); iter != column.end(); ++iter)
+            touch(iter->first, -phi_j * iter->second);
+        }
+        for (int k = 0; k < sphi_t->nonZeroElements(); k++)
+        {
+          const int j = sphi_t->nonZeroIndexes()[k];
+          const T step = alpha_m * sphi_t->getValues()[k];
+          Column& column = F[j];
+          for (std::vector<int>::const_iterator i = touchedIndexes.begin();
+              i != touchedIndexes.end(); ++i)
+          {
+            typename Column::iterator iter = column.find(*i);
+            if (iter == column.end())
+            {
+              column.insert(std::make_pair(*i, step * modelError[*i]));
+              predecessors[*i].push_back(j);
+            }
+            else
+              iter->second += step * modelError[*i];
+          }
+        }
+        for (std::vector<int>::const_iterator i = touchedIndexes.begin();
+            i != touchedIndexes.end(); ++i)
+        {
+          modelError[*i] = T(0);
+          touched[*i] = false;
+        }
+        touchedIndexes.clear();
+        b->addToSelf(alpha_m * (r_tp1 - b->dot(phi_t)), phi_t);
+      }
+
+      void touch(const int& i, const T& value)
+      {
+        if (!touched[i])
+        {
+          touched[i] = true;
+          touchedIndexes.push_back(i);
+        }
+        modelError[i] += value;
+      }
+
+      void enqueue(const int& i, const T& priority)
+      {
+        if (priority <= priorityThreshold || priority <= queued[i])
+          return;
+        queued[i] = priority;
+        queue.push(std::make_pair(priority, i));
+      }
+
+      void plan()
+      {
+        nbPlanningUpdates = 0;
+#if !defined(EMBEDDED_MODE)
+        if (planningTimeBudgetInMilliseconds > 0)
+          timer.start();
+#endif
+        T* v_values = RTTI<T>::denseVector(v)->getValues();
+        const T* b_values = RTTI<T>::constDenseVector(b)->getValues();
+        while (!queue.empty() && nbPlanningUpdates < nbPlanningSteps)
+        {
+          const Priority top = queue.top();
+          queue.pop();
+          const int i = top.second;
+          if (top.first != queued[i])
+            continue; // superseded by a higher priority
+          queued[i] = T(0);
+          const std::vector<int>& predecessors_i = predecessors[i];
+          for (std::vector<int>::const_iterator j = predecessors_i.begin();
+              j != predecessors_i.end() && nbPlanningUpdates < nbPlanningSteps; ++j)
+          {
+            // Simulated transition from e_j: r = b_j, phi_tp1 = F e_j
+            const Column& column = F[*j];
+            T v_tp1 = T(0);
+            for (typename Column::const_iterator iter = column.begin(); iter != column.end();
+                ++iter)
+              v_tp1 += iter->second * v_values[iter->first];
+            const T delta = b_values[*j] + gamma * v_tp1 - v_values[*j];
+            v_values[*j] += alpha_v * delta;
+            ++nbPlanningUpdates;
+            enqueue(*j, std::abs(delta));
+          }
+#if !defined(EMBEDDED_MODE)
+          if (planningTimeBudgetInMilliseconds > 0)
+          {
+            timer.stop();
+            if (timer.getElapsedTimeInMilliSec() >= planningTimeBudgetInMilliseconds)
+              break;
+          }
+#endif
+        }
+      }
+  };
+
   template<typename T>
   class Sarsa: public Predictor<T>, public LinearLearner<T>
   {
@@ -267,6 +921,7 @@ namespace RLLib
       T alpha, gamma, lambda;
       Trace<T>* e;
       Vector<T>* q;
+      PredictionCache<T> cache;
 
     public:
       Sarsa(const T& alpha, const T& gamma, const T& lambda, Trace<T>* e) :
@@ -285,17 +940,26 @@ namespace RLLib
       {
         e->clear();
         initialized = true;
+        cache.invalidate();
         return T(0);
       }
 
+      // q.phi_t carried forward from the previous update; see PredictionCache
+      void setIncremental(const bool& incremental)
+      {
+        cache.setEnabled(incremental);
+      }
+
       virtual T update(const Vector<T>* phi_t, const Vector<T>* phi_tp1, const T& r_tp1)
       {
         ASSERT(initialized);
-        v_t = q->dot(phi_t);
+        v_t = cache.dot(q, phi_t);
         v_tp1 = q->dot(phi_tp1);
         e->update(gamma * lambda, phi_t, alpha);
         delta = r_tp1 + gamma * v_tp1 - v_t;
         q->addToSelf(delta, e->vect());
+        cache.carry(v_tp1, phi_tp1);
+        cache.correct(delta, e->vect(), phi_tp1);
         return delta;
       }
 
@@ -304,6 +968,7 @@ namespace RLLib
         e->clear();
         q->clear();
         initialized = false;
+        cache.invalidate();
       }
 
       T predict(const Vector<T>* phi_sa) const
@@ -311,6 +976,11 @@ namespace RLLib
         return q->dot(phi_sa);
       }
 
+      void predictAll(const Representations<T>* phis, T* out) const
+      {
+        Predictors::predictAll(q, phis, out);
+      }
+
       void persist(const char* f) const
       {
         q->persist(f);
@@ -319,6 +989,7 @@ namespace RLLib
       void resurrect(const char* f)
       {
         q->resurrect(f);
+        cache.invalidate();
       }
 
       Vector<T>* weights() const
@@ -333,6 +1004,8 @@ namespace RLLib
     private:
       typedef Sarsa<T> Base;
       T v_old;
+      // Would take two corrections for the one q.phi_t it saves
+      using Base::setIncremental;
 
     public:
       SarsaTrue(const T& alpha, const T& gamma, const T& lambda, Trace<T>* e) :
@@ -375,19 +1048,16 @@ namespace RLLib
   {
     private:
       typedef Sarsa<T> Base;
-      Vector<T>* gammaXtp1MinusX;
       T alpha_0;
+      using Base::setIncremental;
     public:
       SarsaAlphaBound(const T& alpha, const T& gamma, const T& lambda, Trace<T>* e) :
-          Sarsa<T>(alpha, gamma, lambda, e), gammaXtp1MinusX(
-              new SVector<T>(e->vect()->dimension())), //
-          alpha_0(alpha)
+          Sarsa<T>(alpha, gamma, lambda, e), alpha_0(alpha)
       {
       }
 
       virtual ~SarsaAlphaBound()
       {
-        delete gammaXtp1MinusX;
       }
 
       void reset()
@@ -399,11 +1069,9 @@ namespace RLLib
     private:
       void updateAlpha(const Vector<T>* phi_t, const Vector<T>* phi_tp1)
       {
-        // Update the adaptive step-size
+        // Update the adaptive step-size; e.(gamma phi_tp1 - phi_t), without the difference vector
         T b = std::abs(
-            Base::e->vect()->dot(
-                gammaXtp1MinusX->set(phi_tp1)->mapMultiplyToSelf(Base::gamma)->subtractToSelf(
-                    phi_t)));
+            Base::gamma * Base::e->vect()->dot(phi_tp1) - Base::e->vect()->dot(phi_t));
         if (b > 0.0f)
           Base::alpha = std::min(Base::alpha, 1.0f / b);
       }
@@ -435,6 +1103,7 @@ namespace RLLib
       Trace<T>* e;
       Vector<T>* v;
       Vector<T>* w;
+      PredictionCache<T> cache;
 
     public:
       GQ(const T& alpha_v, const T& alpha_w, const T& gamma_tp1, const T& lambda_t, Trace<T>* e) :
@@ -454,21 +1123,33 @@ namespace RLLib
       {
         e->clear();
         initialized = true;
+        cache.invalidate();
         return T(0);
       }
 
+      // v.phi_t carried forward from the previous update, when phi_t is the previous phi_bar_tp1
+      void setIncremental(const bool& incremental)
+      {
+        cache.setEnabled(incremental);
+      }
+
       T update(const Vector<T>* phi_t, const Vector<T>* phi_bar_tp1, const T& gamma_tp1,
           const T& lambda_tp1, const T& rho_t, const T& r_tp1, const T& z_tp1)
       {
         ASSERT(initialized);
-        delta_t = //
-            r_tp1 + (T(1) - gamma_tp1) * z_tp1 + gamma_tp1 * v->dot(phi_bar_tp1) - v->dot(phi_t);
+        ASSERT(cache.follows(phi_t));
+        const T v_tp1 = v->dot(phi_bar_tp1);
+        delta_t = r_tp1 + (T(1) - gamma_tp1) * z_tp1 + gamma_tp1 * v_tp1 - cache.dot(v, phi_t);
         e->update(gamma_t * lambda_t * rho_t, phi_t);
         // v
         // part 1
         v->addToSelf(alpha_v * delta_t, e->vect());
         // part 2
-        v->addToSelf(-alpha_v * gamma_tp1 * (T(1) - lambda_tp1) * w->dot(e->vect()), phi_bar_tp1);
+        const T alpha_phi = -alpha_v * gamma_tp1 * (T(1) - lambda_tp1) * w->dot(e->vect());
+        v->addToSelf(alpha_phi, phi_bar_tp1);
+        cache.carry(v_tp1, phi_bar_tp1);
+        cache.correct(alpha_v * delta_t, e->vect(), phi_bar_tp1);
+        cache.correct(alpha_phi, phi_bar_tp1);
 
         // w
         // part 2
@@ -499,6 +1180,7 @@ namespace RLLib
         v->clear();
         w->clear();
         initialized = false;
+        cache.invalidate();
       }
 
       T predict(const Vector<T>* phi_sa) const
@@ -506,6 +1188,11 @@ namespace RLLib
         return v->dot(phi_sa);
       }
 
+      void predictAll(const Representations<T>* phis, T* out) const
+      {
+        Predictors::predictAll(v, phis, out);
+      }
+
       void persist(const char* f) const
       {
         v->persist(f);
@@ -513,6 +1200,7 @@ namespace RLLib
       void resurrect(const char* f)
       {
         v->resurrect(f);
+        cache.invalidate();
       }
 
       Vector<T>* weights() const
@@ -542,6 +1230,7 @@ namespace RLLib
       Trace<T>* e;
       Vector<T>* v;
       Vector<T>* w;
+      PredictionCache<T> cache;
 
       GTDLambdaAbstract(const T& alpha_v, const T& alpha_w, const T& gamma_t, const T& lambda_t,
           Trace<T>* e) :
@@ -561,6 +1250,7 @@ namespace RLLib
       {
         e->clear();
         initialized = true;
+        cache.invalidate();
         return T(0);
       }
 
@@ -584,6 +1274,7 @@ namespace RLLib
         v->clear();
         w->clear();
         initialized = false;
+        cache.invalidate();
       }
 
       T predict(const Vector<T>* phi) const
@@ -591,6 +1282,11 @@ namespace RLLib
         return v->dot(phi);
       }
 
+      void predictAll(const Representations<T>* phis, T* out) const
+      {
+        Predictors::predictAll(v, phis, out);
+      }
+
       void persist(const char* f) const
       {
         v->persist(f);
@@ -599,6 +1295,7 @@ namespace RLLib
       void resurrect(const char* f)
       {
         v->resurrect(f);
+        cache.invalidate();
       }
 
       Vector<T>* weights() const
@@ -622,11 +1319,18 @@ namespace RLLib
       {
       }
 
+      // v.x_t carried forward from the previous update
+      void setIncremental(const bool& incremental)
+      {
+        Base::cache.setEnabled(incremental);
+      }
+
       T update(const Vector<T>* phi_t, const Vector<T>* phi_tp1, const T& gamma_tp1,
           const T& lambda_tp1, const T& rho_t, const T& r_tp1, const T& z_tp1)
       {
-        Base::delta_t = r_tp1 + (T(1) - gamma_tp1) * z_tp1 + gamma_tp1 * Base::v->dot(phi_tp1)
-            - Base::v->dot(phi_t);
+        const T v_tp1 = Base::v->dot(phi_tp1);
+        Base::delta_t = r_tp1 + (T(1) - gamma_tp1) * z_tp1 + gamma_tp1 * v_tp1
+            - Base::cache.dot(Base::v, phi_t);
         Base::e->update(Base::gamma_t * Base::lambda_t, phi_t);
         Base::e->vect()->mapMultiplyToSelf(rho_t);
 
@@ -634,9 +1338,12 @@ namespace RLLib
         // part 1
         Base::v->addToSelf(Base::alpha_v * Base::delta_t, Base::e->vect());
         // part2
-        Base::v->addToSelf(
-            -Base::alpha_v * gamma_tp1 * (T(1) - lambda_tp1) * Base::w->dot(Base::e->vect()),
-            phi_tp1);
+        const T alpha_phi = -Base::alpha_v * gamma_tp1 * (T(1) - lambda_tp1)
+            * Base::w->dot(Base::e->vect());
+        Base::v->addToSelf(alpha_phi, phi_tp1);
+        Base::cache.carry(v_tp1, phi_tp1);
+        Base::cache.correct(Base::alpha_v * Base::delta_t, Base::e->vect(), phi_tp1);
+        Base::cache.correct(alpha_phi, phi_tp1);
 
         // w
         // part 2
@@ -0,0 +1,332 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Quantization.h
+ */
+
+#ifndef QUANTIZATION_H_
+#define QUANTIZATION_H_
+
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <stdint.h>
+#if !defined(EMBEDDED_MODE)
+#include <fstream>
+#include <iostream>
+#endif
+
+#include "Control.h"
+#include "Policy.h"
+
+namespace RLLib
+{
+
+  /**
+   * The values of a vector as integers Q (int8_t, int16_t), with one scale per block of
+   * consecutive values: value = q * scale, where scale = max |value| of the block / max Q. A block
+   * of 64 int8_t values and their scale take 72 bytes, against 512 bytes of doubles. Read only,
+   * but for resurrect(), which reads back the integers and the scales as persist() wrote them.
+   */
+  template<typename T, typename Q>
+  class QuantizedVector
+  {
+    protected:
+      int capacity;
+      int blockShift;
+      std::vector<T> scales;
+      std::vector<Q> values;
+      T maxError;
+
+    public:
+      // blockSize is rounded up to a power of two
+      QuantizedVector(const Vector<T>* v, const int& blockSize = 64) :
+          capacity(v->dimension()), blockShift(0), maxError(0)
+      {
+        while ((1 << blockShift) < blockSize)
+          ++blockShift;
+        const int size = 1 << blockShift;
+        const T qmax = T(std::numeric_limits<Q>::max());
+        scales.resize((capacity + size - 1) / size);
+        values.resize(capacity);
+        for (int b = 0; b < int(scales.size()); b++)
+        {
+          const int begin = b * size;
+          const int end = std::min(capacity, begin + size);
+          T maxAbs = T(0);
+          for (int i = begin; i < end; i++)
+            maxAbs = std::max(maxAbs, std::abs(v->getEntry(i)));
+          scales[b] = maxAbs / qmax;
+          for (int i = begin; i < end; i++)
+          {
+            const T value = v->getEntry(i);
+            const T q = scales[b] > T(0) ? std::floor(value / scales[b] + T(0.5)) : T(0);
+            values[i] = Q(std::max(-qmax, std::min(qmax, q)));
+            maxError = std::max(maxError, std::abs(value - getEntry(i)));
+          }
+        }
+      }
+
+      int dimension() const
+      {
+        return capacity;
+      }
+
+      T getEntry(const int& index) const
+      {
+        return T(values[index]) * scales[index >> blockShift];
+      }
+
+      // Dequantizes the entries of the active features only
+      T dot(const Vector<T>* x) const
+      {
+        ASSERT(x->dimension() == capacity);
+        const SparseVector<T>* sparse = RTTI<T>::constSparseVector(x);
+        T result = T(0);
+        if (sparse)
+        {
+          const int* indexes = sparse->nonZeroIndexes();
+          const T* xs = sparse->getValues();
+          for (int position = 0; position < sparse->nonZeroElements(); position++)
+            result += xs[position] * getEntry(indexes[position]);
+          return result;
+        }
+        for (int i = 0; i < capacity; i++)
+          result += x->getEntry(i) * getEntry(i);
+        return result;
+      }
+
+      void dequantize(Vector<T>* v) const
+      {
+        ASSERT(v->dimension() == capacity);
+        for (int i = 0; i < capacity; i++)
+          v->setEntry(i, getEntry(i));
+      }
+
+      // max_i |value_i - getEntry(i)|
+      T getMaxError() const
+      {
+        return maxError;
+      }
+
+      size_t bytes() const
+      {
+        return values.size() * sizeof(Q) + scales.size() * sizeof(T);
+      }
+
+      // sizeof(Q), the capacity, the block shift, the max error, then the scales and the values
+      void persist(const char* f) const
+      {
+#if !defined(EMBEDDED_MODE)
+        std::ofstream of(f, std::ofstream::out | std::ofstream::binary);
+        if (!of.is_open())
+        {
+          std::cerr << "ERROR! (persist) file=" << f << std::endl;
+          return;
+        }
+        const int qsize = sizeof(Q);
+        write(of, &qsize, 1);
+        write(of, &capacity, 1);
+        write(of, &blockShift, 1);
+        write(of, &maxError, 1);
+        write(of, &scales[0], scales.size());
+        write(of, &values[0], values.size());
+        of.close();
+        std::cout << "## QuantizedVector (capacity=" << capacity << ", bytes=" << bytes()
+            << ") persisted=" << f << std::endl;
+#endif
+      }
+
+      void resurrect(const char* f)
+      {
+#if !defined(EMBEDDED_MODE)
+        std::ifstream ifs(f, std::ifstream::in | std::ifstream::binary);
+        if (!ifs.is_open())
+        {
+          std::cerr << "ERROR! (resurrect) file=" << f << std::endl;
+          return;
+        }
+        int qsize;
+        read(ifs, &qsize, 1);
+        // The integers of another width can not be read back
+        ASSERT(qsize == int(sizeof(Q)));
+        read(ifs, &capacity, 1);
+        read(ifs, &blockShift, 1);
+        read(ifs, &maxError, 1);
+        const int size = 1 << blockShift;
+        scales.resize((capacity + size - 1) / size);
+        values.resize(capacity);
+        read(ifs, &scales[0], scales.size());
+        read(ifs, &values[0], values.size());
+        ASSERT(ifs.good());
+        ifs.close();
+        std::cout << "## QuantizedVector (capacity=" << capacity << ", bytes=" << bytes()
+            << ") resurrected=" << f << std::endl;
+#endif
+      }
+
+#if !defined(EMBEDDED_MODE)
+    private:
+      template<class U> static void write(std::ostream& o, const U* u, const size_t& n)
+      {
+        o.write(reinterpret_cast<const char*>(u), n * sizeof(U));
+      }
+
+      template<class U> static void read(std::istream& i, U* u, const size_t& n)
+      {
+        i.read(reinterpret_cast<char*>(u), n * sizeof(U));
+      }
+#endif
+  };
+
+  /**
+   * A read-only Predictor from the weights of a trained one, quantized once; e.g., to deploy a
+   * policy on a robot with little memory, or to keep many policies per server. The trained
+   * predictor is not used afterwards. persist() saves the quantized weights, a fraction of the
+   * size of the trained ones, and resurrect() reads them back in a predictor of the same Q.
+   */
+  template<typename T, typename Q>
+  class QuantizedPredictor: public Predictor<T>, public ParameterizedFunction<T>
+  {
+    protected:
+      QuantizedVector<T, Q> quantized;
+      mutable PVector<T>* dequantized;
+
+    public:
+      QuantizedPredictor(const Predictor<T>* predictor, const int& blockSize = 64) :
+          quantized(predictor->weights(), blockSize), dequantized(0)
+      {
+      }
+
+      virtual ~QuantizedPredictor()
+      {
+        if (dequantized)
+          delete dequantized;
+      }
+
+      T predict(const Vector<T>* x) const
+      {
+        return quantized.dot(x);
+      }
+
+      // A dequantized copy, made on the first call; it takes the memory saved
+      Vector<T>* weights() const
+      {
+        if (!dequantized)
+        {
+          dequantized = new PVector<T>(quantized.dimension());
+          quantized.dequantize(dequantized);
+        }
+        return dequantized;
+      }
+
+      const QuantizedVector<T, Q>* getQuantized() const
+      {
+        return &quantized;
+      }
+
+      void persist(const char* f) const
+      {
+        quantized.persist(f);
+      }
+
+      void resurrect(const char* f)
+      {
+        quantized.resurrect(f);
+        // The dequantized copy is stale
+        if (dequantized)
+        {
+          delete dequantized;
+          dequantized = 0;
+        }
+      }
+  };
+
+  /**
+   * Greedy actions of a predictor over state-action features, without learning; e.g., a
+   * QuantizedPredictor deployed with a ControlAgent. The predictor is also the
+   * ParameterizedFunction that persist() and resurrect() forward to, e.g., a QuantizedPredictor or
+   * a Sarsa.
+   */
+  template<typename T>
+  class GreedyControl: public Control<T>
+  {
+    protected:
+      Predictor<T>* predictor_;
+      ParameterizedFunction<T>* parameters;
+      StateToStateAction<T>* toStateAction;
+      Greedy<T>* greedy;
+
+    public:
+      template<class P>
+      GreedyControl(Actions<T>* actions, StateToStateAction<T>* toStateAction, P* predictor) :
+          predictor_(predictor), parameters(predictor), toStateAction(toStateAction), //
+          greedy(new Greedy<T>(actions, predictor))
+      {
+      }
+
+      virtual ~GreedyControl()
+      {
+        delete greedy;
+      }
+
+      const Action<T>* initialize(const Vector<T>* x)
+      {
+        return proposeAction(x);
+      }
+
+      void reset()
+      {
+      }
+
+      const Action<T>* proposeAction(const Vector<T>* x)
+      {
+        return Policies::sampleBestAction(greedy, toStateAction->stateActions(x));
+      }
+
+      const Action<T>* step(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1,
+          const T& r_tp1, const T& z_tp1)
+      {
+        return proposeAction(x_tp1);
+      }
+
+      // max_a Q(x, a)
+      T computeValueFunction(const Vector<T>* x) const
+      {
+        const Representations<T>* phis = toStateAction->stateActions(x);
+        std::vector<T> values(phis->dimension());
+        predictor_->predictAll(phis, &values[0]);
+        return *std::max_element(values.begin(), values.end());
+      }
+
+      const Predictor<T>* predictor() const
+      {
+        return predictor_;
+      }
+
+      void persist(const char* f) const
+      {
+        parameters->persist(f);
+      }
+
+      void resurrect(const char* f)
+      {
+        parameters->resurrect(f);
+      }
+  };
+
+} // namespace RLLib
+
+#endif /* QUANTIZATION_H_ */
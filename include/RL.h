@@ -33,6 +33,8 @@
 
 #if !defined(EMBEDDED_MODE)
 #include "Timer.h"
+#include "Statistics.h"
+#include "ValueFunctionSurface.h"
 #endif
 
 namespace RLLib
@@ -147,6 +149,285 @@ namespace RLLib
       }
   };
 
+#if !defined(EMBEDDED_MODE)
+  /**
+   * Deadline-aware (anytime) learner for hard real-time control loops. The action a_tp1 is
+   * sampled from the behavior policy first, with the current weights, and the transition is
+   * queued with pi_b(a_t), so that the importance sampling ratio of a transition learned late
+   * does not depend on the weights at learning time. The queued transitions are then learned in
+   * order, a whole update at a time: the next one is only started when the running average of the
+   * update time fits in what remains of the budget of the step (a step that learns nothing lowers
+   * the estimate, so that slow updates are tried again); the remaining ones are carried over to
+   * the next steps, and to the next episode. The learner is initialized (i.e., its traces are
+   * cleared) only when it reaches the first transition of an episode, or one whose predecessor
+   * was dropped: when the queue is full, the oldest transition is dropped. The first step of an
+   * episode is budgeted and timed as the others. A step that takes longer than the budget is a
+   * deadline miss. Learners with their own budget (e.g., the planning of LinearDyna) should be
+   * given a share of the budget of the step.
+   */
+  template<typename T>
+  class AnytimeLearnerAgent: public RLAgent<T>
+  {
+      typedef RLAgent<T> Base;
+    protected:
+      struct Transition
+      {
+          Vector<T>* x_t;
+          const Action<T>* a_t;
+          T pi_b_t;
+          Vector<T>* x_tp1;
+          T r_tp1;
+          T z_tp1;
+          bool endOfEpisode;
+          bool startsEpisode;
+          bool followsDrop;
+      };
+
+      OffPolicyControlLearner<T>* learner;
+      double budgetInMilliSec;
+      int capacity;
+      Transition* transitions;
+      int head;
+      int nbPending;
+      const Action<T>* a_t;
+      T pi_b_t;
+      bool startsEpisode;
+      Vector<T>* absorbingState;
+      Vector<T>* x_t;
+      Timer timer;
+      int nbEpisodes;
+      int nbSteps;
+      int nbDeadlineMisses;
+      int nbLearned;
+      int nbDropped;
+      int nbRestarts;
+      double learnTimeInMilliSec; // running average of an update
+      double maxStepTimeInMilliSec;
+      double totalStepTimeInMilliSec;
+
+    public:
+      AnytimeLearnerAgent(OffPolicyControlLearner<T>* learner, const double& budgetInMilliSec,
+          const int& capacity = 64) :
+          RLAgent<T>(learner), learner(learner), budgetInMilliSec(budgetInMilliSec), //
+          capacity(capacity), transitions(new Transition[capacity]), head(0), nbPending(0), //
+          a_t(0), pi_b_t(1), startsEpisode(false), absorbingState(new PVector<T>(0)), x_t(0), //
+          learnTimeInMilliSec(0)
+      {
+        ASSERT(capacity > 0);
+        for (int i = 0; i < capacity; i++)
+        {
+          transitions[i].x_t = 0;
+          transitions[i].x_tp1 = 0;
+        }
+        resetStatistics();
+      }
+
+      virtual ~AnytimeLearnerAgent()
+      {
+        for (int i = 0; i < capacity; i++)
+        {
+          if (transitions[i].x_t)
+            delete transitions[i].x_t;
+          if (transitions[i].x_tp1)
+            delete transitions[i].x_tp1;
+        }
+        delete[] transitions;
+        delete absorbingState;
+        if (x_t)
+          delete x_t;
+      }
+
+      const Action<T>* initialize(const TRStep<T>* step)
+      {
+        timer.start();
+        // The traces are cleared when the first transition of the episode is learned, not now:
+        // the pending transitions of the previous episode are still to be learned with them
+        a_t = sample(step->o_tp1, pi_b_t);
+        startsEpisode = true;
+        Vectors<T>::bufferedCopy(step->o_tp1, x_t);
+        ++nbEpisodes;
+        learnWithinBudget();
+        return a_t;
+      }
+
+      const Action<T>* getAtp1(const TRStep<T>* step)
+      {
+        timer.start();
+        T pi_b_tp1;
+        const Action<T>* a_tp1 = sample(step->endOfEpisode ? absorbingState : step->o_tp1,
+            pi_b_tp1);
+        push(step);
+        a_t = a_tp1;
+        pi_b_t = pi_b_tp1;
+        Vectors<T>::bufferedCopy(step->o_tp1, x_t);
+        learnWithinBudget();
+        return a_t;
+      }
+
+      void reset()
+      {
+        head = nbPending = 0;
+        startsEpisode = false;
+        learner->reset();
+      }
+
+      // Learns all the pending transitions, regardless of the budget
+      void flush()
+      {
+        while (nbPending > 0)
+          learnOldest();
+      }
+
+      void setBudget(const double& budgetInMilliSec)
+      {
+        this->budgetInMilliSec = budgetInMilliSec;
+      }
+
+      double getBudget() const
+      {
+        return budgetInMilliSec;
+      }
+
+      int getNbPending() const
+      {
+        return nbPending;
+      }
+
+      int getNbEpisodes() const
+      {
+        return nbEpisodes;
+      }
+
+      // Including the first step of each episode, which queues no transition
+      int getNbSteps() const
+      {
+        return nbSteps;
+      }
+
+      int getNbDeadlineMisses() const
+      {
+        return nbDeadlineMisses;
+      }
+
+      double getDeadlineMissRate() const
+      {
+        return nbSteps > 0 ? double(nbDeadlineMisses) / nbSteps : 0.0;
+      }
+
+      int getNbLearned() const
+      {
+        return nbLearned;
+      }
+
+      int getNbDropped() const
+      {
+        return nbDropped;
+      }
+
+      // Initializations of the learner after dropped transitions
+      int getNbRestarts() const
+      {
+        return nbRestarts;
+      }
+
+      double getMaxStepTimeInMilliSec() const
+      {
+        return maxStepTimeInMilliSec;
+      }
+
+      double getAverageStepTimeInMilliSec() const
+      {
+        return nbSteps > 0 ? totalStepTimeInMilliSec / nbSteps : 0.0;
+      }
+
+      void resetStatistics()
+      {
+        nbEpisodes = nbSteps = nbDeadlineMisses = nbLearned = nbDropped = nbRestarts = 0;
+        maxStepTimeInMilliSec = totalStepTimeInMilliSec = 0.0;
+      }
+
+    private:
+      // Samples the next action from the behavior policy, with pi_b of it
+      const Action<T>* sample(const Vector<T>* x, T& pi_b)
+      {
+        const Action<T>* a = learner->sampleAction(x);
+        pi_b = learner->behaviorProbability(a);
+        return a;
+      }
+
+      // Learns the pending transitions while the step is on time, then closes the step
+      void learnWithinBudget()
+      {
+        double elapsedInMilliSec = timer.getElapsedTimeInMilliSec();
+        bool learned = false;
+        while (nbPending > 0 && elapsedInMilliSec + learnTimeInMilliSec < budgetInMilliSec)
+        {
+          learnOldest();
+          const double now = timer.getElapsedTimeInMilliSec();
+          // A preempted update counts as one that takes the whole budget
+          learnTimeInMilliSec += 0.1
+              * (std::min(now - elapsedInMilliSec, budgetInMilliSec) - learnTimeInMilliSec);
+          elapsedInMilliSec = now;
+          learned = true;
+        }
+        // Tries again once the estimate has decayed
+        if (nbPending > 0 && !learned)
+          learnTimeInMilliSec *= 0.99;
+        timer.stop();
+        const double stepTimeInMilliSec = timer.getElapsedTimeInMilliSec();
+        ++nbSteps;
+        if (stepTimeInMilliSec > budgetInMilliSec)
+          ++nbDeadlineMisses;
+        maxStepTimeInMilliSec = std::max(maxStepTimeInMilliSec, stepTimeInMilliSec);
+        totalStepTimeInMilliSec += stepTimeInMilliSec;
+      }
+
+      void push(const TRStep<T>* step)
+      {
+        bool followsDrop = false;
+        if (nbPending == capacity)
+        {
+          // Drops the oldest transition; the traces would join two transitions that do not
+          // follow each other
+          head = (head + 1) % capacity;
+          --nbPending;
+          ++nbDropped;
+          if (nbPending > 0)
+            transitions[head].followsDrop = true;
+          else
+            followsDrop = true;
+        }
+        Transition& transition = transitions[(head + nbPending) % capacity];
+        Vectors<T>::bufferedCopy(x_t, transition.x_t);
+        Vectors<T>::bufferedCopy(step->o_tp1, transition.x_tp1);
+        transition.a_t = a_t;
+        transition.pi_b_t = pi_b_t;
+        transition.r_tp1 = step->r_tp1;
+        transition.z_tp1 = step->z_tp1;
+        transition.endOfEpisode = step->endOfEpisode;
+        transition.startsEpisode = startsEpisode;
+        transition.followsDrop = followsDrop;
+        startsEpisode = false;
+        ++nbPending;
+      }
+
+      void learnOldest()
+      {
+        const Transition& transition = transitions[head];
+        if (transition.startsEpisode || transition.followsDrop)
+          learner->initialize(transition.x_t);
+        if (transition.followsDrop)
+          ++nbRestarts;
+        learner->learnDeferred(transition.x_t, transition.a_t,
+            transition.endOfEpisode ? absorbingState : transition.x_tp1, transition.r_tp1,
+            transition.z_tp1, transition.pi_b_t);
+        head = (head + 1) % capacity;
+        --nbPending;
+        ++nbLearned;
+      }
+  };
+#endif
+
   template<typename T>
   class ControlAgent: public RLAgent<T>
   {
@@ -270,10 +551,13 @@ namespace RLLib
           T averageTimePerStep;
           T episodeR;
           T episodeZ;
+          // onStep events: the totals so far; set on the last step of the episode
+          bool endingOfEpisode;
 
         public:
           Event() :
-              nbTotalTimeSteps(0), nbEpisodeDone(0), averageTimePerStep(0), episodeR(0), episodeZ(0)
+              nbTotalTimeSteps(0), nbEpisodeDone(0), averageTimePerStep(0), episodeR(0), //
+              episodeZ(0), endingOfEpisode(false)
           {
           }
 
@@ -302,31 +586,37 @@ namespace RLLib
       T totalTimeInMilliseconds;
 
 #if !defined(EMBEDDED_MODE)
-      std::vector<T> statistics;
+      // Episode lengths, in constant memory
+      RunningStatistics<T> statistics;
+      P2Quantile<T> medianStatistics;
 #endif
       bool enableStatistics;
 
       bool enableTestEpisodesAfterEachRun;
       int maxTestEpisodesAfterEachRun;
+      bool inclusiveValueFunction;
     public:
       int timeStep;
       T episodeR;
       T episodeZ;
       std::vector<Event*> onEpisodeEnd;
+      // After every step but the first of each episode
+      std::vector<Event*> onStep;
 
       RLRunner(RLAgent<T>* agent, RLProblem<T>* problem, const int& maxEpisodeTimeSteps,
           const int nbEpisodes = -1, const int nbRuns = -1) :
           agent(agent), problem(problem), agentAction(0), maxEpisodeTimeSteps(maxEpisodeTimeSteps), //
           nbEpisodes(nbEpisodes), nbRuns(nbRuns), nbEpisodeDone(0), endingOfEpisode(false), //
           verbose(true), totalTimeInMilliseconds(0), enableStatistics(false), //
-          enableTestEpisodesAfterEachRun(false), maxTestEpisodesAfterEachRun(20), timeStep(0), //
-          episodeR(0), episodeZ(0)
+          enableTestEpisodesAfterEachRun(false), maxTestEpisodesAfterEachRun(20), //
+          inclusiveValueFunction(false), timeStep(0), episodeR(0), episodeZ(0)
       {
       }
 
       ~RLRunner()
       {
         onEpisodeEnd.clear();
+        onStep.clear();
       }
 
       void setVerbose(const bool& verbose)
@@ -354,27 +644,37 @@ namespace RLLib
         this->enableTestEpisodesAfterEachRun = enableTestEpisodesAfterEachRun;
       }
 
+      // The value function grid ends at 10, i.e., 101 x 101 values instead of 100 x 100
+      void setInclusiveValueFunction(const bool& inclusiveValueFunction)
+      {
+        this->inclusiveValueFunction = inclusiveValueFunction;
+      }
+
       void benchmark()
       {
 #if !defined(EMBEDDED_MODE)
-        T xbar = std::accumulate(statistics.begin(), statistics.end(), 0.0f)
-            / (T(statistics.size()));
+        const T n = T(statistics.count());
+        T xbar = statistics.mean();
         std::cout << std::endl;
-        std::cout << "## Average: length=" << xbar;
+        std::cout << "## Average: length=" << xbar << " median=" << medianStatistics.value();
         std::cout << std::endl;
-        T sigmabar = T(0);
-        for (typename std::vector<T>::const_iterator x = statistics.begin(); x != statistics.end();
-            ++x)
-          sigmabar += pow((*x - xbar), 2);
-        sigmabar = sqrt(sigmabar) / T(statistics.size());
-        T se/*standard error*/= sigmabar / sqrt(T(statistics.size()));
+        T sigmabar = sqrt(statistics.sumOfSquaredDeviations()) / n;
+        T se/*standard error*/= sigmabar / sqrt(n);
         std::cout << "## (+- 95%) =" << (se * 2);
         std::cout << std::endl;
         statistics.clear();
+        medianStatistics.clear();
 #endif
       }
 
       void step()
+      {
+        advance();
+        act();
+      }
+
+      // The problem half of step(): starts an episode, or applies the last action
+      void advance()
       {
         if (!agentAction)
         {
@@ -399,7 +699,11 @@ namespace RLLib
           /*Update the state variables*/
           problem->updateTuple();
         }
+      }
 
+      // The agent half of step(): the next action, and the end of the episode
+      void act()
+      {
         if (!agentAction)
         {
           /*Initialize the control agent and get the first action*/
@@ -421,6 +725,7 @@ namespace RLLib
           timer.stop();
           totalTimeInMilliseconds += timer.getElapsedTimeInMilliSec();
 #endif
+          fire(onStep);
         }
 
         if (endingOfEpisode/*The episode is just ended*/)
@@ -436,27 +741,32 @@ namespace RLLib
           }
 
           if (enableStatistics)
-            statistics.push_back(timeStep);
+          {
+            statistics.add(timeStep);
+            medianStatistics.add(timeStep);
+          }
 #endif
           ++nbEpisodeDone;
           /*Set the initial marker*/
           agentAction = 0;
           // Fire the events
-          for (typename std::vector<Event*>::iterator iter = onEpisodeEnd.begin();
-              iter != onEpisodeEnd.end(); ++iter)
-          {
-            Event* e = *iter;
-            e->nbTotalTimeSteps = timeStep;
-            e->nbEpisodeDone = nbEpisodeDone;
-            e->averageTimePerStep = (totalTimeInMilliseconds / timeStep);
-            e->episodeR = episodeR;
-            e->episodeZ = episodeZ;
-            e->update();
-          }
+          fire(onEpisodeEnd);
         }
 
       }
 
+      // A new run: the agent is reset, and the next step() starts an episode
+      void reset()
+      {
+        agent->reset();
+        agentAction = 0;
+        nbEpisodeDone = 0;
+        endingOfEpisode = false;
+        timeStep = 0;
+        episodeR = 0;
+        episodeZ = 0;
+      }
+
       void runEpisodes()
       {
         do
@@ -487,7 +797,10 @@ namespace RLLib
           if (verbose)
             std::cout << "\n@@ Run=" << run << std::endl;
           if (enableStatistics)
+          {
             statistics.clear();
+            medianStatistics.clear();
+          }
           nbEpisodeDone = 0;
           // For each run
           agent->reset();
@@ -531,30 +844,72 @@ namespace RLLib
         return maxEpisodeTimeSteps;
       }
 
-      void computeValueFunction(const char* outFile = "visualization/valueFunction.txt") const
+      void computeValueFunction(const char* outFile = "visualization/valueFunction.txt",
+          const bool& binary = false) const
       {
 #if !defined(EMBEDDED_MODE)
+        // The agent is not thread-safe, hence a single worker
+        AgentValueEvaluator evaluator(agent);
+        computeValueFunction(std::vector<ValueEvaluator<T>*>(1, &evaluator), outFile, binary);
+#endif
+      }
+
+#if !defined(EMBEDDED_MODE)
+      // The grid 0, 0.1, ..., 9.9 of both variables (up to 10 when inclusive), split among the
+      // evaluators, one per worker
+      void computeValueFunction(const std::vector<ValueEvaluator<T>*>& evaluators,
+          const char* outFile, const bool& binary = false) const
+      {
         if (problem->dimension() == 2) // only for two state variables
         {
-          std::ofstream out(outFile);
-          PVector<T> x_t(2);
-          for (T x = 0; x <= 10; x += 0.1f)
-          {
-            for (T y = 0; y <= 10; y += 0.1f)
-            {
-              x_t.at(0) = x;
-              x_t.at(1) = y;
-              out << agent->computeValueFunction(&x_t) << " ";
-            }
-            out << std::endl;
-          }
-          out.close();
+          const int nbPoints = inclusiveValueFunction ? 101 : 100;
+          ValueFunctionSurface<T> surface(evaluators, 2, nbPoints, nbPoints);
+          surface.setInclusive(inclusiveValueFunction);
+          Range<T> range(0, 10);
+          surface.evaluateGrid(&range, &range);
+          surface.persist(outFile, binary);
         }
 
         // draw
         problem->draw();
+      }
 #endif
+
+    protected:
+      void fire(std::vector<Event*>& events)
+      {
+        for (typename std::vector<Event*>::iterator iter = events.begin(); iter != events.end();
+            ++iter)
+        {
+          Event* e = *iter;
+          e->nbTotalTimeSteps = timeStep;
+          e->nbEpisodeDone = nbEpisodeDone;
+          e->averageTimePerStep = (totalTimeInMilliseconds / timeStep);
+          e->episodeR = episodeR;
+          e->episodeZ = episodeZ;
+          e->endingOfEpisode = endingOfEpisode;
+          e->update();
+        }
       }
+
+    private:
+#if !defined(EMBEDDED_MODE)
+      class AgentValueEvaluator: public ValueEvaluator<T>
+      {
+        private:
+          const RLAgent<T>* agent;
+        public:
+          AgentValueEvaluator(const RLAgent<T>* agent) :
+              agent(agent)
+          {
+          }
+
+          T value(const Vector<T>* x)
+          {
+            return agent->computeValueFunction(x);
+          }
+      };
+#endif
   };
 
 }  // namespace RLLib
@@ -0,0 +1,329 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Replay.h
+ */
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <stdint.h>
+#include <algorithm>
+
+#include "Vector.h"
+#include "Action.h"
+#include "Mathema.h"
+#include "StateToStateAction.h"
+
+namespace RLLib
+{
+
+  /**
+   * Binary tree over n priorities where every node holds the sum (and the minimum) of its
+   * children. Updating a priority and finding the leaf that holds a given prefix mass are both
+   * O(log n), which makes proportional sampling independent of the size of the buffer.
+   */
+  template<typename T>
+  class SumTree
+  {
+    protected:
+      int capacity;
+      int nbLeaves;
+      T* sums;
+      T* mins;
+      T maxPriority;
+
+    public:
+      SumTree(const int& capacity) :
+          capacity(capacity), nbLeaves(1), sums(0), mins(0), maxPriority(T(1))
+      {
+        while (nbLeaves < capacity)
+          nbLeaves <<= 1;
+        sums = new T[2 * nbLeaves];
+        mins = new T[2 * nbLeaves];
+        clear();
+      }
+
+      ~SumTree()
+      {
+        delete[] sums;
+        delete[] mins;
+      }
+
+      void clear()
+      {
+        std::fill(sums, sums + 2 * nbLeaves, T(0));
+        std::fill(mins, mins + 2 * nbLeaves, std::numeric_limits<T>::max());
+        maxPriority = T(1);
+      }
+
+      void update(const int& index, const T& priority)
+      {
+        ASSERT(index >= 0 && index < capacity && priority >= T(0));
+        int node = nbLeaves + index;
+        sums[node] = mins[node] = priority;
+        maxPriority = std::max(maxPriority, priority);
+        // Parents are recomputed from their children, so that no rounding error accumulates
+        for (node >>= 1; node > 0; node >>= 1)
+        {
+          sums[node] = sums[2 * node] + sums[2 * node + 1];
+          mins[node] = std::min(mins[2 * node], mins[2 * node + 1]);
+        }
+      }
+
+      T priority(const int& index) const
+      {
+        return sums[nbLeaves + index];
+      }
+
+      T total() const
+      {
+        return sums[1];
+      }
+
+      T min() const
+      {
+        return mins[1];
+      }
+
+      // Priority given to the new entries, such that they are replayed at least once
+      T max() const
+      {
+        return maxPriority;
+      }
+
+      // Leaf such that the sum of the priorities of the leaves before it is <= mass
+      int find(T mass) const
+      {
+        int node = 1;
+        while (node < nbLeaves)
+        {
+          const int left = 2 * node;
+          if (mass < sums[left] || sums[left + 1] == T(0))
+            node = left;
+          else
+          {
+            mass -= sums[left];
+            node = left + 1;
+          }
+        }
+        return std::min(node - nbLeaves, capacity - 1);
+      }
+
+      int sample(Random<T>* random) const
+      {
+        return find(random->nextReal() * total());
+      }
+  };
+
+  /**
+   * Ring buffer of transitions. The transitions are kept column wise in a single allocation:
+   * the observations and the rewards as floats, the action ids as 32-bit ints and the terminal
+   * flags as bytes. Optionally, the buffer also stores the active features of phi_t(s_t,a_t)
+   * and of phi_tp1(s_tp1,.) for all the actions, as 32-bit indexes. These features must be
+   * binary (e.g., tile coding), which is what allows dropping their values. With the features,
+   * the observations are not needed at all and the observation dimension can be 0.
+   */
+  template<typename T>
+  class ReplayBuffer
+  {
+    protected:
+      int capacity;
+      int observationDimension;
+      int nbActions;
+      int maxActiveFeatures;
+      int featuresStride;
+      int head;
+      int nbTransitions;
+      size_t memorySize;
+      char* memory;
+      float* observations;
+      float* rewards;
+      int32_t* actions;
+      int32_t* features;
+      uint8_t* terminals;
+
+    public:
+      ReplayBuffer(const int& capacity, const int& observationDimension, const int& nbActions = 0,
+          const int& maxActiveFeatures = 0) :
+          capacity(capacity), observationDimension(observationDimension), nbActions(nbActions), //
+          maxActiveFeatures(maxActiveFeatures), featuresStride(
+              maxActiveFeatures > 0 ? (1 + nbActions) * (1 + maxActiveFeatures) : 0), //
+          head(0), nbTransitions(0), memorySize(0), memory(0), observations(0), rewards(0), //
+          actions(0), features(0), terminals(0)
+      {
+        ASSERT(capacity > 0 && (maxActiveFeatures == 0 || nbActions > 0));
+        const size_t nbObservations = size_t(capacity) * 2 * observationDimension;
+        const size_t nbFeatures = size_t(capacity) * featuresStride;
+        memorySize = (nbObservations + capacity) * sizeof(float)
+            + (capacity + nbFeatures) * sizeof(int32_t) + capacity * sizeof(uint8_t);
+        memory = new char[memorySize];
+        observations = reinterpret_cast<float*>(memory);
+        rewards = observations + nbObservations;
+        actions = reinterpret_cast<int32_t*>(rewards + capacity);
+        features = actions + capacity;
+        terminals = reinterpret_cast<uint8_t*>(features + nbFeatures);
+      }
+
+      ~ReplayBuffer()
+      {
+        delete[] memory;
+      }
+
+      int getCapacity() const
+      {
+        return capacity;
+      }
+
+      int size() const
+      {
+        return nbTransitions;
+      }
+
+      int getObservationDimension() const
+      {
+        return observationDimension;
+      }
+
+      bool empty() const
+      {
+        return nbTransitions == 0;
+      }
+
+      size_t memoryUsage() const
+      {
+        return memorySize;
+      }
+
+      bool storesObservations() const
+      {
+        return observationDimension > 0;
+      }
+
+      bool storesFeatures() const
+      {
+        return maxActiveFeatures > 0;
+      }
+
+      void clear()
+      {
+        head = 0;
+        nbTransitions = 0;
+      }
+
+      // Returns the slot of the transition; an empty x_tp1 marks the end of an episode
+      int push(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1, const T& r_tp1)
+      {
+        const int slot = head;
+        head = (head + 1) % capacity;
+        if (nbTransitions < capacity)
+          ++nbTransitions;
+        float* o = observations + size_t(slot) * 2 * observationDimension;
+        for (int i = 0; i < observationDimension; i++)
+          o[i] = float(x_t->getEntry(i));
+        const bool terminal = x_tp1->empty();
+        for (int i = 0; i < observationDimension; i++)
+          o[observationDimension + i] = terminal ? 0.0f : float(x_tp1->getEntry(i));
+        rewards[slot] = float(r_tp1);
+        actions[slot] = a_t->id();
+        terminals[slot] = terminal;
+        return slot;
+      }
+
+      void setFeatures_t(const int& slot, const Vector<T>* phi_sa_t)
+      {
+        setFeatures(row(slot, 0), phi_sa_t);
+      }
+
+      void setFeatures_tp1(const int& slot, const Representations<T>* phi_tp1)
+      {
+        ASSERT(phi_tp1->dimension() == nbActions);
+        for (int a = 0; a < nbActions; a++)
+          setFeatures(row(slot, 1 + a), phi_tp1->at(a));
+      }
+
+      // phi_t(s_t,a_t) of slot is phi_tp1(s_tp1,a_t) of from, when s_t is the s_tp1 of from
+      void copyFeatures_t(const int& slot, const int& from, const int& action)
+      {
+        const int32_t* source = row(from, 1 + action);
+        std::copy(source, source + 1 + source[0], row(slot, 0));
+      }
+
+      int action(const int& slot) const
+      {
+        return actions[slot];
+      }
+
+      T reward(const int& slot) const
+      {
+        return T(rewards[slot]);
+      }
+
+      bool terminal(const int& slot) const
+      {
+        return terminals[slot] != 0;
+      }
+
+      void observation_t(const int& slot, Vector<T>* x_t) const
+      {
+        const float* o = observations + size_t(slot) * 2 * observationDimension;
+        for (int i = 0; i < observationDimension; i++)
+          x_t->setEntry(i, T(o[i]));
+      }
+
+      void observation_tp1(const int& slot, Vector<T>* x_tp1) const
+      {
+        const float* o = observations + (size_t(slot) * 2 + 1) * observationDimension;
+        for (int i = 0; i < observationDimension; i++)
+          x_tp1->setEntry(i, T(o[i]));
+      }
+
+      // Active features of phi_t(s_t,a_t); the first element is their number
+      const int32_t* features_t(const int& slot) const
+      {
+        return row(slot, 0);
+      }
+
+      // Active features of phi_tp1(s_tp1,a); the first element is their number
+      const int32_t* features_tp1(const int& slot, const int& action) const
+      {
+        return row(slot, 1 + action);
+      }
+
+    private:
+      int32_t* row(const int& slot, const int& index) const
+      {
+        ASSERT(storesFeatures() && slot >= 0 && slot < capacity);
+        return features + size_t(slot) * featuresStride + index * (1 + maxActiveFeatures);
+      }
+
+      void setFeatures(int32_t* row, const Vector<T>* phi)
+      {
+        const SparseVector<T>* sphi = RTTI<T>::constSparseVector(phi);
+        ASSERT(sphi && sphi->nonZeroElements() <= maxActiveFeatures);
+        const int nbActive = std::min(sphi->nonZeroElements(), maxActiveFeatures);
+        const int* indexes = sphi->nonZeroIndexes();
+        row[0] = nbActive;
+        for (int i = 0; i < nbActive; i++)
+        {
+          ASSERT(sphi->getValues()[i] == T(1));
+          row[1 + i] = indexes[i];
+        }
+      }
+  };
+
+} // namespace RLLib
+
+#endif /* REPLAY_H_ */
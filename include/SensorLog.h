@@ -0,0 +1,524 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SensorLog.h
+ */
+
+#ifndef SENSORLOG_H_
+#define SENSORLOG_H_
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "RL.h"
+
+/**
+ * Offline replay of recorded sensor logs. The binary format is columnar by blocks: the rows are
+ * grouped into blocks of blockSize rows, and each block stores its columns one after the other
+ * as float32. A 64 byte header holds the magic, the number of columns, the block size and the
+ * number of rows. The logs are read through mmap, hence they are never loaded fully.
+ * This header depends on POSIX, hence it is not included by the rest of the library.
+ */
+namespace RLLib
+{
+
+  class SensorLogs
+  {
+    public:
+      enum
+      {
+        HEADER_SIZE = 64
+      };
+
+      static const char* magic()
+      {
+        return "RLLIBLOG";
+      }
+
+      /**
+       * Converts a text log, one row of white space separated values per line, to the binary
+       * format. Empty lines are skipped; all the rows must have the same number of values. The
+       * text is read one line at a time, and one block is buffered.
+       */
+      static bool convert(const char* textFile, const char* binaryFile,
+          const uint32_t& blockSize = 1024)
+      {
+#if !defined(EMBEDDED_MODE)
+        std::ifstream ifs(textFile);
+        if (!ifs.is_open())
+        {
+          std::cerr << "ERROR! (convert) file=" << textFile << std::endl;
+          return false;
+        }
+        std::ofstream ofs(binaryFile, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open())
+        {
+          std::cerr << "ERROR! (convert) file=" << binaryFile << std::endl;
+          return false;
+        }
+
+        uint32_t nbColumns = 0;
+        uint64_t nbRows = 0;
+        writeHeader(ofs, nbColumns, blockSize, nbRows);
+        std::vector<float> values;
+        std::vector<float> block; // Row major
+        std::vector<float> columns;
+        std::string str;
+        while (std::getline(ifs, str))
+        {
+          values.clear();
+          const char* begin = str.c_str();
+          char* end = 0;
+          for (double value = std::strtod(begin, &end); end != begin;
+              value = std::strtod(begin, &end))
+          {
+            values.push_back(float(value));
+            begin = end;
+          }
+          if (values.empty())
+            continue;
+          if (nbColumns == 0)
+            nbColumns = uint32_t(values.size());
+          if (values.size() != nbColumns)
+          {
+            std::cerr << "ERROR! (convert) row=" << nbRows << " has " << values.size()
+                << " values instead of " << nbColumns << std::endl;
+            return false;
+          }
+          block.insert(block.end(), values.begin(), values.end());
+          ++nbRows;
+          if (block.size() == size_t(blockSize) * nbColumns)
+            writeBlock(ofs, block, columns, nbColumns);
+        }
+        writeBlock(ofs, block, columns, nbColumns);
+        ofs.seekp(0);
+        writeHeader(ofs, nbColumns, blockSize, nbRows);
+        return ofs.good();
+#else
+        return false;
+#endif
+      }
+
+    private:
+      static void writeHeader(std::ofstream& ofs, const uint32_t& nbColumns,
+          const uint32_t& blockSize, const uint64_t& nbRows)
+      {
+        char header[HEADER_SIZE];
+        std::memset(header, 0, HEADER_SIZE);
+        std::memcpy(header, magic(), 8);
+        std::memcpy(header + 8, &nbColumns, sizeof(nbColumns));
+        std::memcpy(header + 12, &blockSize, sizeof(blockSize));
+        std::memcpy(header + 16, &nbRows, sizeof(nbRows));
+        ofs.write(header, HEADER_SIZE);
+      }
+
+      // Transposes the buffered rows into columns
+      static void writeBlock(std::ofstream& ofs, std::vector<float>& block,
+          std::vector<float>& columns, const uint32_t& nbColumns)
+      {
+        if (block.empty())
+          return;
+        const size_t nbRows = block.size() / nbColumns;
+        columns.resize(block.size());
+        for (size_t i = 0; i < nbRows; i++)
+          for (uint32_t c = 0; c < nbColumns; c++)
+            columns[c * nbRows + i] = block[i * nbColumns + c];
+        ofs.write(reinterpret_cast<const char*>(&columns[0]), columns.size() * sizeof(float));
+        block.clear();
+      }
+  };
+
+  /**
+   * Read-only mmap of a binary log. The values are read in place, and willNeed() lets a reader
+   * fault in the pages of the rows ahead.
+   */
+  class SensorLogReader
+  {
+    protected:
+      int fd;
+      char* data;
+      size_t size;
+      uint32_t nbColumns;
+      uint32_t blockSize;
+      uint64_t nbRows;
+      const float* values;
+
+    public:
+      SensorLogReader(const char* f) :
+          fd(-1), data(0), size(0), nbColumns(0), blockSize(0), nbRows(0), values(0)
+      {
+        fd = ::open(f, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || ::fstat(fd, &st) != 0
+            || size_t(st.st_size) < size_t(SensorLogs::HEADER_SIZE))
+        {
+          std::cerr << "ERROR! (SensorLogReader) file=" << f << std::endl;
+          close();
+          return;
+        }
+        size = size_t(st.st_size);
+        void* address = ::mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED || std::memcmp(address, SensorLogs::magic(), 8) != 0)
+        {
+          std::cerr << "ERROR! (SensorLogReader) not a log file=" << f << std::endl;
+          if (address != MAP_FAILED)
+            ::munmap(address, size);
+          close();
+          return;
+        }
+        data = static_cast<char*>(address);
+        std::memcpy(&nbColumns, data + 8, sizeof(nbColumns));
+        std::memcpy(&blockSize, data + 12, sizeof(blockSize));
+        std::memcpy(&nbRows, data + 16, sizeof(nbRows));
+        values = reinterpret_cast<const float*>(data + SensorLogs::HEADER_SIZE);
+        ASSERT(size >= SensorLogs::HEADER_SIZE + nbRows * nbColumns * sizeof(float));
+        ::madvise(data, size, MADV_SEQUENTIAL);
+      }
+
+      virtual ~SensorLogReader()
+      {
+        close();
+      }
+
+      bool isOpen() const
+      {
+        return data != 0;
+      }
+
+      uint64_t getNbRows() const
+      {
+        return nbRows;
+      }
+
+      int getNbColumns() const
+      {
+        return int(nbColumns);
+      }
+
+      uint32_t getBlockSize() const
+      {
+        return blockSize;
+      }
+
+      uint64_t getNbBlocks() const
+      {
+        return blockSize ? (nbRows + blockSize - 1) / blockSize : 0;
+      }
+
+      uint32_t getBlockNbRows(const uint64_t& block) const
+      {
+        return uint32_t(std::min(uint64_t(blockSize), nbRows - block * blockSize));
+      }
+
+      // The contiguous values of column c in the given block
+      const float* column(const uint64_t& block, const int& c) const
+      {
+        ASSERT(block < getNbBlocks() && c >= 0 && c < int(nbColumns));
+        return values + block * blockSize * nbColumns
+            + size_t(c) * getBlockNbRows(block);
+      }
+
+      float value(const uint64_t& row, const int& c) const
+      {
+        ASSERT(row < nbRows);
+        const uint64_t block = row / blockSize;
+        return column(block, c)[row - block * blockSize];
+      }
+
+      template<typename T>
+      void row(const uint64_t& row, T* out) const
+      {
+        ASSERT(row < nbRows);
+        const uint64_t block = row / blockSize;
+        const uint32_t blockNbRows = getBlockNbRows(block);
+        const float* v = values + block * blockSize * nbColumns + (row - block * blockSize);
+        for (uint32_t c = 0; c < nbColumns; c++)
+          out[c] = T(v[size_t(c) * blockNbRows]);
+      }
+
+      // Faults in the pages of the blocks that hold the rows [beginRow, endRow)
+      void willNeed(const uint64_t& beginRow, const uint64_t& endRow) const
+      {
+        if (!isOpen() || beginRow >= std::min(endRow, nbRows))
+          return;
+        const uint64_t firstBlock = beginRow / blockSize;
+        const uint64_t lastBlock = (std::min(endRow, nbRows) - 1) / blockSize;
+        const size_t pageSize = size_t(::sysconf(_SC_PAGESIZE));
+        const size_t begin = (SensorLogs::HEADER_SIZE
+            + firstBlock * blockSize * nbColumns * sizeof(float)) / pageSize * pageSize;
+        const size_t end = std::min(size,
+            size_t(SensorLogs::HEADER_SIZE
+                + std::min(nbRows, (lastBlock + 1) * blockSize) * nbColumns * sizeof(float)));
+        ::madvise(data + begin, end - begin, MADV_WILLNEED);
+        volatile char touch = 0;
+        for (size_t offset = begin; offset < end; offset += pageSize)
+          touch += data[offset];
+        (void) touch;
+      }
+
+    private:
+      void close()
+      {
+        if (data)
+          ::munmap(data, size);
+        if (fd >= 0)
+          ::close(fd);
+        data = 0;
+        fd = -1;
+        values = 0;
+      }
+  };
+
+  /**
+   * Replays a log one row per time step. The first nbVars columns are the observation; they are
+   * mapped to the unit interval when observationRanges holds one range per variable. The reward
+   * is the value of rewardColumn, and a row whose episodeColumn equals endOfEpisodeMarker ends
+   * the episode; the next episode starts at the following row. The end of the log also ends the
+   * episode, and the next initialize() rewinds.
+   */
+  template<typename T>
+  class SensorLogProblem: public RLProblem<T>
+  {
+    private:
+      typedef RLProblem<T> Base;
+    protected:
+      SensorLogReader* log;
+      int rewardColumn;
+      int episodeColumn;
+      T endOfEpisodeMarker;
+      uint64_t cursor;
+      std::vector<T> current;
+      bool endOfEpisodeReached;
+      bool endOfLogReached;
+
+    public:
+      SensorLogProblem(Random<T>* random, SensorLogReader* log, const int& nbVars,
+          const int& rewardColumn = -1, const int& episodeColumn = -1,
+          const T& endOfEpisodeMarker = T(2)) :
+          RLProblem<T>(random, nbVars, 1, 1), log(log), rewardColumn(rewardColumn), //
+          episodeColumn(episodeColumn), endOfEpisodeMarker(endOfEpisodeMarker), cursor(0), //
+          current(log->getNbColumns()), endOfEpisodeReached(false), endOfLogReached(false)
+      {
+        ASSERT(log->isOpen() && log->getNbRows() > 0);
+        ASSERT(nbVars <= log->getNbColumns() && rewardColumn < log->getNbColumns());
+        ASSERT(episodeColumn < log->getNbColumns());
+        Base::discreteActions->push_back(0, 0);
+        Base::continuousActions->push_back(0, 0);
+      }
+
+      virtual ~SensorLogProblem()
+      {
+      }
+
+      void initialize()
+      {
+        if (cursor >= log->getNbRows())
+          cursor = 0;
+        log->row(cursor, &current[0]);
+        endOfEpisodeReached = false;
+        endOfLogReached = false;
+      }
+
+      void step(const Action<T>* action)
+      {
+        ++cursor;
+        if (cursor >= log->getNbRows())
+        {
+          endOfEpisodeReached = endOfLogReached = true;
+          return;
+        }
+        log->row(cursor, &current[0]);
+        endOfEpisodeReached = episodeColumn >= 0 && current[episodeColumn] == endOfEpisodeMarker;
+        if (endOfEpisodeReached)
+          ++cursor; // Advance to the next episode
+      }
+
+      void updateTRStep()
+      {
+        const bool unit = Base::observationRanges->dimension() == Base::nbVars;
+        for (int i = 0; i < Base::nbVars; i++)
+        {
+          Base::output->observation_tp1->setEntry(i, current[i]);
+          Base::output->o_tp1->setEntry(i,
+              unit ? Base::observationRanges->at(i)->toUnit(current[i]) : current[i]);
+        }
+      }
+
+      bool endOfEpisode() const
+      {
+        return endOfEpisodeReached;
+      }
+
+      T r() const
+      {
+        return (rewardColumn >= 0 && !endOfLogReached) ? current[rewardColumn] : T(0);
+      }
+
+      T z() const
+      {
+        return T(0);
+      }
+
+      bool endOfLog() const
+      {
+        return endOfLogReached || cursor >= log->getNbRows();
+      }
+
+      uint64_t getCursor() const
+      {
+        return cursor;
+      }
+
+      void setCursor(const uint64_t& cursor)
+      {
+        this->cursor = cursor;
+      }
+
+      SensorLogReader* getLog() const
+      {
+        return log;
+      }
+  };
+
+  /**
+   * Feeds a log to an agent (a LearnerAgent, or an agent that updates a Horde) as fast as the
+   * agent allows: there is no time step limit and no per step timing. A readahead thread keeps
+   * the pages of the next readaheadRows rows resident, so the learners do not wait on the disk.
+   */
+  template<typename T>
+  class SensorLogReplay
+  {
+    protected:
+      RLAgent<T>* agent;
+      SensorLogProblem<T>* problem;
+      uint64_t readaheadRows;
+      std::atomic<uint64_t> cursor;
+      std::atomic<bool> running;
+      uint64_t nbSteps;
+      int nbEpisodes;
+      T episodeR;
+#if !defined(EMBEDDED_MODE)
+      Timer timer;
+#endif
+      T replayTimeInMilliseconds;
+
+    public:
+      SensorLogReplay(RLAgent<T>* agent, SensorLogProblem<T>* problem,
+          const uint64_t& readaheadRows = 1 << 16) :
+          agent(agent), problem(problem), readaheadRows(readaheadRows), cursor(0), //
+          running(false), nbSteps(0), nbEpisodes(0), episodeR(0), replayTimeInMilliseconds(0)
+      {
+      }
+
+      virtual ~SensorLogReplay()
+      {
+      }
+
+      // Replays the log from the current row to its end, or nbMaxEpisodes episodes
+      void run(const int& nbMaxEpisodes = -1)
+      {
+#if !defined(EMBEDDED_MODE)
+        timer.start();
+#endif
+        cursor = problem->getCursor();
+        running = true;
+        std::thread readahead(&SensorLogReplay::readaheadWorker, this);
+        const uint64_t publishMask = 255;
+        while (!problem->endOfLog() && (nbMaxEpisodes < 0 || nbEpisodes < nbMaxEpisodes))
+        {
+          problem->initialize();
+          problem->updateTuple();
+          const Action<T>* a_t = agent->initialize(problem->getTRStep());
+          episodeR = T(0);
+          for (;;)
+          {
+            problem->step(a_t);
+            problem->updateTuple();
+            const TRStep<T>* step = problem->getTRStep();
+            a_t = agent->getAtp1(step);
+            episodeR += step->r_tp1;
+            if ((++nbSteps & publishMask) == 0)
+              cursor.store(problem->getCursor(), std::memory_order_relaxed);
+            if (step->endOfEpisode)
+              break;
+          }
+          ++nbEpisodes;
+        }
+        running = false;
+        readahead.join();
+#if !defined(EMBEDDED_MODE)
+        timer.stop();
+        replayTimeInMilliseconds += timer.getElapsedTimeInMilliSec();
+#endif
+      }
+
+      uint64_t getNbSteps() const
+      {
+        return nbSteps;
+      }
+
+      int getNbEpisodes() const
+      {
+        return nbEpisodes;
+      }
+
+      T getLastEpisodeR() const
+      {
+        return episodeR;
+      }
+
+      T getReplayTimeInMilliseconds() const
+      {
+        return replayTimeInMilliseconds;
+      }
+
+    protected:
+      void readaheadWorker()
+      {
+        const SensorLogReader* log = problem->getLog();
+        uint64_t prefetched = cursor.load();
+        while (running)
+        {
+          const uint64_t target = std::min(log->getNbRows(),
+              cursor.load(std::memory_order_relaxed) + readaheadRows);
+          if (prefetched < target)
+          {
+            // Half a window at a time, so that the worker stays ahead of the learners
+            const uint64_t end = std::min(target,
+                prefetched + std::max(uint64_t(1), readaheadRows / 2));
+            log->willNeed(prefetched, end);
+            prefetched = end;
+          }
+          else if (prefetched >= log->getNbRows())
+            break;
+          else
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+      }
+  };
+
+} // namespace RLLib
+
+#endif /* SENSORLOG_H_ */
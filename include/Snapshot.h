@@ -0,0 +1,318 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Snapshot.h
+ */
+
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+#include "Vector.h"
+#include "Control.h"
+
+namespace RLLib
+{
+
+  // An immutable copy of the parameters of a learner, in the order of the channel's sources
+  template<typename T>
+  class ParametersSnapshot
+  {
+    public:
+      std::vector<PVector<T>*> vectors;
+      uint64_t version;
+      std::atomic<int> nbReaders;
+
+      ParametersSnapshot() :
+          version(0), nbReaders(0)
+      {
+      }
+
+      ~ParametersSnapshot()
+      {
+        for (typename std::vector<PVector<T>*>::iterator iter = vectors.begin();
+            iter != vectors.end(); ++iter)
+          delete *iter;
+      }
+
+      const Vector<T>* at(const int& i) const
+      {
+        return vectors[i];
+      }
+
+      int dimension() const
+      {
+        return int(vectors.size());
+      }
+
+      // Overwrites the reader's own parameters with the snapshot
+      void copyTo(const std::vector<Vector<T>*>& targets) const
+      {
+        ASSERT(targets.size() == vectors.size());
+        for (size_t i = 0; i < vectors.size(); i++)
+          targets[i]->set(vectors[i]);
+      }
+  };
+
+  /**
+   * Hands the parameters of a learner over to other threads without locks. The learner thread
+   * publish()es a copy of its sources into a buffer that is neither the latest one nor being
+   * read, then makes it the latest. The readers acquire() the latest buffer, which stays
+   * untouched until they release() it. With one reader, three buffers are enough for publish()
+   * to always find a free one; otherwise publish() skips the generation rather than wait, so the
+   * learner is never blocked by the readers. A publish() copies every source in full, so the
+   * learner calls publishIfDue() on every step instead: it publishes on a wall-clock period,
+   * stretched so that the copies never take more than maxOverhead of the learner's time.
+   */
+  template<typename T>
+  class SnapshotChannel
+  {
+    protected:
+      std::vector<const Vector<T>*> sources;
+      std::vector<ParametersSnapshot<T>*> buffers;
+      std::atomic<int> latest;
+      uint64_t version;
+      int nbSkipped;
+      double period;
+      double maxOverhead;
+      bool published;
+      std::chrono::steady_clock::time_point lastPublished;
+      double lastCost;
+      double publishingTime;
+
+    public:
+      SnapshotChannel(const int& nbBuffers = 3, const double& period = 0.1,
+          const double& maxOverhead = 0.05) :
+          latest(-1), version(0), nbSkipped(0), period(period), maxOverhead(maxOverhead), //
+          published(false), lastCost(0), publishingTime(0)
+      {
+        ASSERT(period >= 0 && maxOverhead > 0);
+        ASSERT(nbBuffers >= 2);
+        for (int b = 0; b < nbBuffers; b++)
+          buffers.push_back(new ParametersSnapshot<T>);
+      }
+
+      virtual ~SnapshotChannel()
+      {
+        for (typename std::vector<ParametersSnapshot<T>*>::iterator iter = buffers.begin();
+            iter != buffers.end(); ++iter)
+          delete *iter;
+      }
+
+      // Before the first publish()
+      void add(const Vector<T>* source)
+      {
+        ASSERT(latest.load() < 0);
+        sources.push_back(source);
+        for (typename std::vector<ParametersSnapshot<T>*>::iterator iter = buffers.begin();
+            iter != buffers.end(); ++iter)
+          (*iter)->vectors.push_back(new PVector<T>(source->dimension()));
+      }
+
+      void add(const Vectors<T>* sources)
+      {
+        for (typename Vectors<T>::const_iterator iter = sources->begin(); iter != sources->end();
+            ++iter)
+          add(*iter);
+      }
+
+      // Learner thread; false when every other buffer is being read
+      bool publish()
+      {
+        const int current = latest.load();
+        for (int b = 0; b < int(buffers.size()); b++)
+        {
+          ParametersSnapshot<T>* buffer = buffers[b];
+          if (b == current || buffer->nbReaders.load() > 0)
+            continue;
+          for (size_t i = 0; i < sources.size(); i++)
+            buffer->vectors[i]->set(sources[i]);
+          buffer->version = ++version;
+          latest.store(b);
+          return true;
+        }
+        ++nbSkipped;
+        return false;
+      }
+
+      // Learner thread, every step; true when a snapshot has been published
+      bool publishIfDue()
+      {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (published)
+        {
+          const double elapsed = std::chrono::duration<double>(now - lastPublished).count();
+          if (elapsed < std::max(period, lastCost / maxOverhead))
+            return false;
+        }
+        const bool result = publish();
+        lastPublished = std::chrono::steady_clock::now();
+        lastCost = std::chrono::duration<double>(lastPublished - now).count();
+        publishingTime += lastCost;
+        published = true;
+        return result;
+      }
+
+      // Reader threads; the latest snapshot, or null before the first publish()
+      const ParametersSnapshot<T>* acquire()
+      {
+        for (;;)
+        {
+          const int b = latest.load();
+          if (b < 0)
+            return 0;
+          ParametersSnapshot<T>* buffer = buffers[b];
+          ++buffer->nbReaders;
+          // The learner may have picked this buffer before it saw the reader
+          if (latest.load() == b)
+            return buffer;
+          --buffer->nbReaders;
+        }
+      }
+
+      void release(const ParametersSnapshot<T>* snapshot)
+      {
+        if (snapshot)
+          --const_cast<ParametersSnapshot<T>*>(snapshot)->nbReaders;
+      }
+
+      uint64_t getVersion() const
+      {
+        return version;
+      }
+
+      int getNbSkipped() const
+      {
+        return nbSkipped;
+      }
+
+      int getNbBuffers() const
+      {
+        return int(buffers.size());
+      }
+
+      // Seconds spent in publishIfDue() copies
+      double getPublishingTime() const
+      {
+        return publishingTime;
+      }
+  };
+
+  /**
+   * A control that only acts, for evaluation threads: the greedy action of its own policy with
+   * its own state-action projector, and V(x) = v' phi(x) with its own projector. refresh() copies
+   * the latest snapshot, when newer, into the policy parameters followed by v (when set).
+   */
+  template<typename T>
+  class SnapshotControl: public Control<T>
+  {
+    protected:
+      SnapshotChannel<T>* channel;
+      PolicyDistribution<T>* policy;
+      StateToStateAction<T>* toStateAction;
+      Projector<T>* projector;
+      PVector<T>* v;
+      std::vector<Vector<T>*> targets;
+      uint64_t version;
+
+    public:
+      SnapshotControl(SnapshotChannel<T>* channel, PolicyDistribution<T>* policy,
+          StateToStateAction<T>* toStateAction, Projector<T>* projector = 0) :
+          channel(channel), policy(policy), toStateAction(toStateAction), projector(projector), //
+          v(projector ? new PVector<T>(projector->dimension()) : 0), version(0)
+      {
+        const Vectors<T>* u = policy->parameters();
+        for (typename Vectors<T>::const_iterator iter = u->begin(); iter != u->end(); ++iter)
+          targets.push_back(*iter);
+        if (v)
+          targets.push_back(v);
+      }
+
+      virtual ~SnapshotControl()
+      {
+        if (v)
+          delete v;
+      }
+
+      // True when the parameters have changed
+      bool refresh()
+      {
+        const ParametersSnapshot<T>* snapshot = channel->acquire();
+        const bool changed = snapshot && snapshot->version != version;
+        if (changed)
+        {
+          snapshot->copyTo(targets);
+          version = snapshot->version;
+        }
+        channel->release(snapshot);
+        return changed;
+      }
+
+      uint64_t getVersion() const
+      {
+        return version;
+      }
+
+      // v, or null without a projector; changes only in refresh()
+      const Vector<T>* weights() const
+      {
+        return v;
+      }
+
+      const Action<T>* initialize(const Vector<T>* x)
+      {
+        return proposeAction(x);
+      }
+
+      void reset()
+      {
+      }
+
+      const Action<T>* proposeAction(const Vector<T>* x)
+      {
+        return Policies::sampleBestAction(policy, toStateAction->stateActions(x));
+      }
+
+      const Action<T>* step(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1,
+          const T& r_tp1, const T& z_tp1)
+      {
+        return proposeAction(x_tp1);
+      }
+
+      T computeValueFunction(const Vector<T>* x) const
+      {
+        return v ? v->dot(projector->project(x)) : T(0);
+      }
+
+      const Predictor<T>* predictor() const
+      {
+        return 0;
+      }
+
+      void persist(const char* f) const
+      {
+      }
+
+      void resurrect(const char* f)
+      {
+      }
+  };
+
+} // namespace RLLib
+
+#endif /* SNAPSHOT_H_ */
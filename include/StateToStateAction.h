@@ -78,6 +78,18 @@ namespace RLLib
         return phis[action->id()];
       }
 
+      Vector<T>* at(const int& index)
+      {
+        ASSERT(index < static_cast<int>(phis.size()));
+        return phis[index];
+      }
+
+      const Vector<T>* at(const int& index) const
+      {
+        ASSERT(index < static_cast<int>(phis.size()));
+        return phis[index];
+      }
+
       void clear()
       {
         for (typename std::vector<Vector<T>*>::iterator iter = phis.begin(); iter != phis.end();
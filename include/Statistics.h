@@ -0,0 +1,229 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Statistics.h
+ */
+
+#ifndef STATISTICS_H_
+#define STATISTICS_H_
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "Mathema.h"
+
+namespace RLLib
+{
+
+  // Count, mean, variance (Welford), min and max of a stream, in constant memory
+  template<typename T>
+  class RunningStatistics
+  {
+    protected:
+      long n;
+      T xbar;
+      T m2;
+      T xmin;
+      T xmax;
+
+    public:
+      RunningStatistics()
+      {
+        clear();
+      }
+
+      void clear()
+      {
+        n = 0;
+        xbar = m2 = T(0);
+        xmin = std::numeric_limits<T>::max();
+        xmax = -std::numeric_limits<T>::max();
+      }
+
+      void add(const T& x)
+      {
+        ++n;
+        const T delta = x - xbar;
+        xbar += delta / T(n);
+        m2 += delta * (x - xbar);
+        xmin = std::min(xmin, x);
+        xmax = std::max(xmax, x);
+      }
+
+      long count() const
+      {
+        return n;
+      }
+
+      T mean() const
+      {
+        return xbar;
+      }
+
+      // sum_i (x_i - mean)^2
+      T sumOfSquaredDeviations() const
+      {
+        return m2;
+      }
+
+      T variance() const
+      {
+        return n > 1 ? m2 / T(n - 1) : T(0);
+      }
+
+      T stddev() const
+      {
+        return std::sqrt(variance());
+      }
+
+      T min() const
+      {
+        return xmin;
+      }
+
+      T max() const
+      {
+        return xmax;
+      }
+  };
+
+  /**
+   * The p-quantile of a stream with five markers, the P^2 algorithm of Jain and Chlamtac, "The
+   * P^2 algorithm for dynamic calculation of quantiles and histograms without storing
+   * observations", 1985. Exact for the first five observations.
+   */
+  template<typename T>
+  class P2Quantile
+  {
+    protected:
+      T p;
+      long n;
+      T q[5];
+      T positions[5];
+      T desired[5];
+      T increments[5];
+
+    public:
+      P2Quantile(const T& p = T(0.5)) :
+          p(p)
+      {
+        ASSERT(p >= T(0) && p <= T(1));
+        clear();
+      }
+
+      void clear()
+      {
+        n = 0;
+        for (int i = 0; i < 5; i++)
+        {
+          q[i] = T(0);
+          positions[i] = T(i + 1);
+        }
+        desired[0] = T(1);
+        desired[1] = T(1) + T(2) * p;
+        desired[2] = T(1) + T(4) * p;
+        desired[3] = T(3) + T(2) * p;
+        desired[4] = T(5);
+        increments[0] = T(0);
+        increments[1] = p / T(2);
+        increments[2] = p;
+        increments[3] = (T(1) + p) / T(2);
+        increments[4] = T(1);
+      }
+
+      void add(const T& x)
+      {
+        if (n < 5)
+        {
+          q[n++] = x;
+          if (n == 5)
+            std::sort(q, q + 5);
+          return;
+        }
+        ++n;
+
+        int k;
+        if (x < q[0])
+        {
+          q[0] = x;
+          k = 0;
+        }
+        else if (x >= q[4])
+        {
+          q[4] = x;
+          k = 3;
+        }
+        else
+        {
+          k = 0;
+          while (x >= q[k + 1])
+            ++k;
+        }
+        for (int i = k + 1; i < 5; i++)
+          positions[i] += T(1);
+        for (int i = 0; i < 5; i++)
+          desired[i] += increments[i];
+
+        // Moves the middle markers towards their desired positions
+        for (int i = 1; i < 4; i++)
+        {
+          const T d = desired[i] - positions[i];
+          if ((d >= T(1) && positions[i + 1] - positions[i] > T(1))
+              || (d <= T(-1) && positions[i - 1] - positions[i] < T(-1)))
+          {
+            const int s = d > T(0) ? 1 : -1;
+            const T qp = parabolic(i, T(s));
+            if (q[i - 1] < qp && qp < q[i + 1])
+              q[i] = qp;
+            else
+              q[i] += T(s) * (q[i + s] - q[i]) / (positions[i + s] - positions[i]);
+            positions[i] += T(s);
+          }
+        }
+      }
+
+      T value() const
+      {
+        if (n >= 5)
+          return q[2];
+        if (n == 0)
+          return T(0);
+        T sorted[5];
+        std::copy(q, q + n, sorted);
+        std::sort(sorted, sorted + n);
+        return sorted[std::min(long(n - 1), long(p * n))];
+      }
+
+      long count() const
+      {
+        return n;
+      }
+
+    protected:
+      T parabolic(const int& i, const T& d) const
+      {
+        return q[i]
+            + d / (positions[i + 1] - positions[i - 1])
+                * ((positions[i] - positions[i - 1] + d) * (q[i + 1] - q[i])
+                    / (positions[i + 1] - positions[i])
+                    + (positions[i + 1] - positions[i] - d) * (q[i] - q[i - 1])
+                        / (positions[i] - positions[i - 1]));
+      }
+  };
+
+} // namespace RLLib
+
+#endif /* STATISTICS_H_ */
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Storage.h
+ */
+
+#ifndef STORAGE_H_
+#define STORAGE_H_
+
+#include <algorithm>
+
+namespace RLLib
+{
+
+  /**
+   * Where the values of a DenseVector live. allocate() returns capacity zeroed values, which only
+   * the same storage deallocates. The storages are shared by the vectors, and outlive them.
+   */
+  template<typename T>
+  class Storage
+  {
+    public:
+      virtual ~Storage()
+      {
+      }
+
+      virtual T* allocate(const int& capacity) =0;
+      virtual void deallocate(T* data, const int& capacity) =0;
+
+      // Sets the values to zero
+      virtual void clear(T* data, const int& capacity)
+      {
+        std::fill(data, data + capacity, T(0));
+      }
+
+      // The storage of the vectors constructed without one
+      static Storage<T>* getDefault();
+
+      // Process wide; set it before the learners are constructed
+      static void setDefault(Storage<T>* storage);
+
+    private:
+      static Storage<T>*& defaultStorage();
+  };
+
+  // new T[]; the storage of the vectors by default
+  template<typename T>
+  class HeapStorage: public Storage<T>
+  {
+    public:
+      T* allocate(const int& capacity)
+      {
+        T* data = new T[capacity];
+        std::fill(data, data + capacity, T(0));
+        return data;
+      }
+
+      void deallocate(T* data, const int& capacity)
+      {
+        delete[] data;
+      }
+
+      static HeapStorage<T>* getInstance()
+      {
+        static HeapStorage<T> instance;
+        return &instance;
+      }
+  };
+
+  template<typename T>
+  Storage<T>*& Storage<T>::defaultStorage()
+  {
+    static Storage<T>* storage = HeapStorage<T>::getInstance();
+    return storage;
+  }
+
+  template<typename T>
+  Storage<T>* Storage<T>::getDefault()
+  {
+    return defaultStorage();
+  }
+
+  template<typename T>
+  void Storage<T>::setDefault(Storage<T>* storage)
+  {
+    defaultStorage() = storage ? storage : HeapStorage<T>::getInstance();
+  }
+
+} // namespace RLLib
+
+#endif /* STORAGE_H_ */
@@ -0,0 +1,338 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ValueFunctionSurface.h
+ */
+
+#ifndef VALUEFUNCTIONSURFACE_H_
+#define VALUEFUNCTIONSURFACE_H_
+
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <limits>
+
+#include "Vector.h"
+#include "Projector.h"
+#include "StateToStateAction.h"
+#include "Control.h"
+
+namespace RLLib
+{
+
+  /**
+   * V(x) for one worker of a ValueFunctionSurface. The projectors and the policies of the
+   * library keep their output in member buffers, hence each worker owns its evaluator.
+   */
+  template<typename T>
+  class ValueEvaluator
+  {
+    public:
+      virtual ~ValueEvaluator()
+      {
+      }
+      virtual T value(const Vector<T>* x) =0;
+  };
+
+  // Control::computeValueFunction(); it updates the policies of the control, hence one worker
+  template<typename T>
+  class ControlValueEvaluator: public ValueEvaluator<T>
+  {
+    protected:
+      const Control<T>* control;
+
+    public:
+      ControlValueEvaluator(const Control<T>* control = 0) :
+          control(control)
+      {
+      }
+
+      virtual ~ControlValueEvaluator()
+      {
+      }
+
+      void setControl(const Control<T>* control)
+      {
+        this->control = control;
+      }
+
+      T value(const Vector<T>* x)
+      {
+        return control->computeValueFunction(x);
+      }
+  };
+
+  /**
+   * V(x) = w' phi(x), with the worker's own projector. The weights are only read: they are
+   * usually a snapshot of the critic, so that the learner keeps running during the evaluation.
+   */
+  template<typename T>
+  class LinearValueEvaluator: public ValueEvaluator<T>
+  {
+    protected:
+      Projector<T>* projector;
+      const Vector<T>* weights;
+
+    public:
+      LinearValueEvaluator(Projector<T>* projector, const Vector<T>* weights) :
+          projector(projector), weights(weights)
+      {
+      }
+
+      virtual ~LinearValueEvaluator()
+      {
+      }
+
+      T value(const Vector<T>* x)
+      {
+        return weights->dot(projector->project(x));
+      }
+  };
+
+  // V(x) = max_a w' phi(x, a), with the worker's own state-action projector and weights snapshot
+  template<typename T>
+  class LinearActionValueEvaluator: public ValueEvaluator<T>
+  {
+    protected:
+      StateToStateAction<T>* toStateAction;
+      const Vector<T>* weights;
+
+    public:
+      LinearActionValueEvaluator(StateToStateAction<T>* toStateAction, const Vector<T>* weights) :
+          toStateAction(toStateAction), weights(weights)
+      {
+      }
+
+      virtual ~LinearActionValueEvaluator()
+      {
+      }
+
+      T value(const Vector<T>* x)
+      {
+        T v = -std::numeric_limits<T>::max();
+        const Actions<T>* actions = toStateAction->getActions();
+        for (typename Actions<T>::const_iterator a = actions->begin(); a != actions->end(); ++a)
+          v = std::max(v, weights->dot(toStateAction->stateAction(x, *a)));
+        return v;
+      }
+  };
+
+  /**
+   * A dense nbRows x nbCols array (row major) of V over a grid of two observation variables, or
+   * over a list of observations. The cells are split among the evaluators, one thread each, and
+   * each thread writes its own rows; with a single evaluator, the caller's thread does all the
+   * work. Hence there should be no more evaluators than nbHardwareWorkers().
+   */
+  template<typename T>
+  class ValueFunctionSurface
+  {
+    protected:
+      std::vector<ValueEvaluator<T>*> evaluators;
+      int nbRows;
+      int nbCols;
+      std::vector<T> values;
+      // Per worker
+      std::vector<PVector<T>*> inputs;
+      // Grid
+      const Range<T>* rowRange;
+      const Range<T>* colRange;
+      bool toUnit;
+      bool inclusive;
+      int rowVar;
+      int colVar;
+      // List
+      const std::vector<const Vector<T>*>* observations;
+      T* out;
+
+    public:
+      ValueFunctionSurface(const std::vector<ValueEvaluator<T>*>& evaluators, const int& nbVars,
+          const int& nbRows = 100, const int& nbCols = 100) :
+          evaluators(evaluators), nbRows(nbRows), nbCols(nbCols), values(nbRows * nbCols), //
+          rowRange(0), colRange(0), toUnit(false), inclusive(false), rowVar(0), colVar(1), //
+          observations(0), out(0)
+      {
+        ASSERT(!evaluators.empty() && nbRows > 0 && nbCols > 0);
+        for (size_t k = 0; k < evaluators.size(); k++)
+          inputs.push_back(new PVector<T>(nbVars));
+      }
+
+      virtual ~ValueFunctionSurface()
+      {
+        for (size_t k = 0; k < inputs.size(); k++)
+          delete inputs[k];
+      }
+
+      // The threads the hardware runs at once, at least one
+      static int nbHardwareWorkers()
+      {
+        return std::max(1, int(std::thread::hardware_concurrency()));
+      }
+
+      // The last row and column of the grid at the maximum of the ranges
+      void setInclusive(const bool& inclusive)
+      {
+        this->inclusive = inclusive;
+      }
+
+      /**
+       * Cell (i, j) is V(x), with x[rowVar] = rowRange->length() * i / nbRows + rowRange->min(),
+       * (nbRows - 1 when inclusive), and x[colVar] likewise; the other variables are taken from
+       * base, or zero. When toUnit is set, the variables are mapped to the unit interval with
+       * their range.
+       */
+      const T* evaluateGrid(const Range<T>* rowRange, const Range<T>* colRange,
+          const bool& toUnit = false, const Vector<T>* base = 0, const int& rowVar = 0,
+          const int& colVar = 1)
+      {
+        this->rowRange = rowRange;
+        this->colRange = colRange;
+        this->toUnit = toUnit;
+        this->rowVar = rowVar;
+        this->colVar = colVar;
+        for (size_t k = 0; k < inputs.size(); k++)
+        {
+          if (base)
+            inputs[k]->set(base);
+          else
+            inputs[k]->clear();
+        }
+        runWorkers(&ValueFunctionSurface::gridWorker);
+        return &values[0];
+      }
+
+      // out[i] = V(observations[i])
+      void evaluate(const std::vector<const Vector<T>*>& observations, T* out)
+      {
+        this->observations = &observations;
+        this->out = out;
+        runWorkers(&ValueFunctionSurface::listWorker);
+        this->observations = 0;
+        this->out = 0;
+      }
+
+      const T* data() const
+      {
+        return &values[0];
+      }
+
+      T at(const int& i, const int& j) const
+      {
+        return values[i * nbCols + j];
+      }
+
+      int rows() const
+      {
+        return nbRows;
+      }
+
+      int cols() const
+      {
+        return nbCols;
+      }
+
+      int getNbWorkers() const
+      {
+        return int(evaluators.size());
+      }
+
+      /**
+       * Text: one row per line, as RLRunner::computeValueFunction() writes it.
+       * Binary: int32 nbRows, int32 nbCols, then the values as T, row major.
+       */
+      void persist(const char* f, const bool& binary = false) const
+      {
+#if !defined(EMBEDDED_MODE)
+        if (binary)
+        {
+          std::ofstream of(f, std::ios::binary);
+          if (!of.is_open())
+          {
+            std::cerr << "ERROR! (persist) file=" << f << std::endl;
+            return;
+          }
+          const int32_t header[2] = { nbRows, nbCols };
+          of.write(reinterpret_cast<const char*>(header), sizeof(header));
+          of.write(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(T));
+        }
+        else
+        {
+          std::ofstream of(f);
+          if (!of.is_open())
+          {
+            std::cerr << "ERROR! (persist) file=" << f << std::endl;
+            return;
+          }
+          for (int i = 0; i < nbRows; i++)
+          {
+            for (int j = 0; j < nbCols; j++)
+              of << values[i * nbCols + j] << " ";
+            of << std::endl;
+          }
+        }
+#endif
+      }
+
+    protected:
+      void gridWorker(const int& k, const int& nbWorkers)
+      {
+        ValueEvaluator<T>* evaluator = evaluators[k];
+        PVector<T>* x = inputs[k];
+        const int rowSteps = inclusive ? std::max(1, nbRows - 1) : nbRows;
+        const int colSteps = inclusive ? std::max(1, nbCols - 1) : nbCols;
+        for (int i = k; i < nbRows; i += nbWorkers)
+        {
+          const T r = rowRange->length() * i / rowSteps + rowRange->min();
+          x->setEntry(rowVar, toUnit ? rowRange->toUnit(r) : r);
+          T* row = &values[i * nbCols];
+          for (int j = 0; j < nbCols; j++)
+          {
+            const T c = colRange->length() * j / colSteps + colRange->min();
+            x->setEntry(colVar, toUnit ? colRange->toUnit(c) : c);
+            row[j] = evaluator->value(x);
+          }
+        }
+      }
+
+      void listWorker(const int& k, const int& nbWorkers)
+      {
+        const int size = int(observations->size());
+        const int block = (size + nbWorkers - 1) / nbWorkers;
+        const int end = std::min(size, (k + 1) * block);
+        for (int i = k * block; i < end; i++)
+          out[i] = evaluators[k]->value(observations->at(i));
+      }
+
+      void runWorkers(void (ValueFunctionSurface::*worker)(const int&, const int&))
+      {
+        const int nbWorkers = int(evaluators.size());
+        if (nbWorkers == 1)
+        {
+          (this->*worker)(0, 1);
+          return;
+        }
+        std::vector<std::thread*> workerThreads;
+        for (int k = 0; k < nbWorkers; k++)
+          workerThreads.push_back(new std::thread(worker, this, k, nbWorkers));
+        for (size_t k = 0; k < workerThreads.size(); k++)
+        {
+          workerThreads[k]->join();
+          delete workerThreads[k];
+        }
+      }
+  };
+
+} // namespace RLLib
+
+#endif /* VALUEFUNCTIONSURFACE_H_ */
@@ -23,6 +23,7 @@
 #define VECTOR_H_
 
 #include "Affirm.h"
+#include "Storage.h"
 
 #if !defined(EMBEDDED_MODE)
 #include <iostream>
@@ -151,23 +152,29 @@ namespace RLLib
     protected:
       int capacity;
       T* data;
+      // Null once bound to storage of the caller
+      Storage<T>* storage;
 
     public:
-      DenseVector(const int& capacity = 1) :
-          Vector<T>(Vector<T>::DENSE_VECTOR), capacity(capacity), data(new T[capacity])
+      DenseVector(const int& capacity = 1, Storage<T>* storage = 0) :
+          Vector<T>(Vector<T>::DENSE_VECTOR), capacity(capacity), data(0), //
+          storage(storage ? storage : Storage<T>::getDefault())
       {
-        std::fill(data, data + capacity, 0);
+        data = this->storage->allocate(capacity);
       }
 
       virtual ~DenseVector()
       {
-        delete[] data;
+        if (storage)
+          storage->deallocate(data, capacity);
       }
 
-      // Implementation details for copy constructor and operator
+      // Implementation details for copy constructor and operator; copies are in the default storage
       DenseVector(const DenseVector<T>& that) :
-          Vector<T>(Vector<T>::DENSE_VECTOR), capacity(that.capacity), data(new T[that.capacity])
+          Vector<T>(Vector<T>::DENSE_VECTOR), capacity(that.capacity), data(0), //
+          storage(Storage<T>::getDefault())
       {
+        data = storage->allocate(capacity);
         std::copy(that.data, that.data + that.capacity, data);
       }
 
@@ -175,14 +182,53 @@ namespace RLLib
       {
         if (this != &that)
         {
-          delete[] data; // delete old
+          if (storage)
+            storage->deallocate(data, capacity); // delete old
           capacity = that.capacity;
-          data = new T[capacity];
+          storage = Storage<T>::getDefault();
+          data = storage->allocate(capacity);
           std::copy(that.data, that.data + capacity, data);
         }
         return *this;
       }
 
+      /**
+       * Moves the values to storage, of capacity entries, which the caller keeps alive as long as
+       * this vector; e.g., the weights of many learners in one allocation. Without copy, the values
+       * are those of the storage; e.g., a weight file mapped in memory.
+       */
+      void bind(T* values, const bool& copy = true)
+      {
+        if (copy)
+          std::copy(data, data + capacity, values);
+        if (storage)
+          storage->deallocate(data, capacity);
+        data = values;
+        storage = 0;
+      }
+
+      // Copies the values of the storage of the caller back into the default storage
+      void release()
+      {
+        if (storage)
+          return;
+        storage = Storage<T>::getDefault();
+        T* values = storage->allocate(capacity);
+        std::copy(data, data + capacity, values);
+        data = values;
+      }
+
+      bool isOwner() const
+      {
+        return storage != 0;
+      }
+
+      // Null when bound
+      Storage<T>* getStorage() const
+      {
+        return storage;
+      }
+
     public:
       int dimension() const
       {
@@ -264,7 +310,10 @@ namespace RLLib
       // Mutable Vector<T>
       void clear()
       {
-        std::fill(data, data + capacity, 0);
+        if (storage)
+          storage->clear(data, capacity);
+        else
+          std::fill(data, data + capacity, 0);
       }
 
       void setEntry(const int& index, const T& value)
@@ -357,9 +406,15 @@ namespace RLLib
           int rcapacity;
           Vector<T>::read(ifs, rcapacity);
           //ASSERT(capacity == rcapacity);
-          delete[] data;
-          capacity = rcapacity;
-          data = new T[capacity];
+          if (capacity != rcapacity)
+          {
+            if (storage)
+              storage->deallocate(data, capacity);
+            else
+              storage = Storage<T>::getDefault();
+            capacity = rcapacity;
+            data = storage->allocate(capacity);
+          }
           clear();
           printf("vectorType=%i rcapacity=%i \n", vectorType, rcapacity);
           // Read data
@@ -400,30 +455,36 @@ namespace RLLib
       int* indexesPosition;
       int* activeIndexes;
       T* values;
+      // Of indexesPosition, the only array of the size of the capacity
+      Storage<int>* storage;
 
     public:
-      SparseVector(const int& capacity = 1, const int& activeIndexesLength = 10) :
+      SparseVector(const int& capacity = 1, const int& activeIndexesLength = 10,
+          Storage<int>* storage = 0) :
           Vector<T>(Vector<T>::SPARSE_VECTOR), indexesPositionLength(capacity), //
-          activeIndexesLength(activeIndexesLength), nbActive(0), //
-          indexesPosition(new int[indexesPositionLength]), //
-          activeIndexes(new int[activeIndexesLength]), values(new T[activeIndexesLength])
+          activeIndexesLength(activeIndexesLength), nbActive(0), indexesPosition(0), //
+          activeIndexes(new int[activeIndexesLength]), values(new T[activeIndexesLength]), //
+          storage(storage ? storage : Storage<int>::getDefault())
       {
+        indexesPosition = this->storage->allocate(indexesPositionLength);
         std::fill(indexesPosition, indexesPosition + capacity, -1);
       }
 
       virtual ~SparseVector()
       {
-        delete[] indexesPosition;
+        storage->deallocate(indexesPosition, indexesPositionLength);
         delete[] activeIndexes;
         delete[] values;
       }
 
+      // Copies are in the default storage
       SparseVector(const SparseVector<T>& that) :
           Vector<T>(Vector<T>::SPARSE_VECTOR), indexesPositionLength(that.indexesPositionLength), //
           activeIndexesLength(that.activeIndexesLength), nbActive(that.nbActive), //
-          indexesPosition(new int[that.indexesPositionLength]), //
-          activeIndexes(new int[that.activeIndexesLength]), values(new T[that.activeIndexesLength])
+          indexesPosition(0), activeIndexes(new int[that.activeIndexesLength]), //
+          values(new T[that.activeIndexesLength]), storage(Storage<int>::getDefault())
       {
+        indexesPosition = storage->allocate(indexesPositionLength);
         std::copy(that.indexesPosition, that.indexesPosition + that.indexesPositionLength,
             indexesPosition);
         std::copy(that.activeIndexes, that.activeIndexes + that.nbActive, activeIndexes);
@@ -433,13 +494,14 @@ namespace RLLib
       {
         if (this != &that)
         {
-          delete[] indexesPosition;
+          storage->deallocate(indexesPosition, indexesPositionLength);
           delete[] activeIndexes;
           delete[] values;
           indexesPositionLength = that.indexesPositionLength;
           activeIndexesLength = that.activeIndexesLength;
           nbActive = that.nbActive;
-          indexesPosition = new int[indexesPositionLength];
+          storage = Storage<int>::getDefault();
+          indexesPosition = storage->allocate(indexesPositionLength);
           activeIndexes = new int[activeIndexesLength];
           values = new T[activeIndexesLength];
 
@@ -576,6 +638,11 @@ namespace RLLib
         return indexesPosition;
       }
 
+      Storage<int>* getStorage() const
+      {
+        return storage;
+      }
+
       int nonZeroElements() const
       {
         return nbActive;
@@ -694,9 +761,9 @@ namespace RLLib
           int rnbActive;
           Vector<T>::read(ifs, rnbActive);
           //ASSERT(indexesPositionLength == rcapacity);
+          storage->deallocate(indexesPosition, indexesPositionLength);
           indexesPositionLength = rcapacity;
-          delete[] indexesPosition;
-          indexesPosition = new int[indexesPositionLength];
+          indexesPosition = storage->allocate(indexesPositionLength);
           std::fill(indexesPosition, indexesPosition + indexesPositionLength, -1);
           clear();
           // Verbose
@@ -776,8 +843,8 @@ namespace RLLib
     private:
       typedef DenseVector<T> Base;
     public:
-      PVector(const int& capacity = 1) :
-          DenseVector<T>(capacity)
+      PVector(const int& capacity = 1, Storage<T>* storage = 0) :
+          DenseVector<T>(capacity, storage)
       {
       }
 
@@ -957,8 +1024,9 @@ namespace RLLib
     private:
       typedef SparseVector<T> Base;
     public:
-      SVector(const int& capacity = 1, const int& activeIndexesLength = 10) :
-          SparseVector<T>(capacity, activeIndexesLength)
+      SVector(const int& capacity = 1, const int& activeIndexesLength = 10,
+          Storage<int>* storage = 0) :
+          SparseVector<T>(capacity, activeIndexesLength, storage)
       {
       }
 
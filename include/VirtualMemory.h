@@ -0,0 +1,595 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * VirtualMemory.h
+ */
+
+#ifndef VIRTUALMEMORY_H_
+#define VIRTUALMEMORY_H_
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <stdint.h>
+
+#include "Vector.h"
+
+#if !defined(EMBEDDED_MODE) && defined(__unix__)
+#define RLLIB_VIRTUAL_MEMORY
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#endif
+
+namespace RLLib
+{
+
+  // Resident set sizes, in bytes; zero where unknown
+  class ResidentMemory
+  {
+    public:
+      static size_t pageSize()
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        return size_t(sysconf(_SC_PAGESIZE));
+#else
+        return 4096;
+#endif
+      }
+
+      // Of the pages of [data, data + bytes); a page read but never written maps the zero page,
+      // and counts
+      static size_t of(const void* data, const size_t& bytes)
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        if (!data || !bytes)
+          return 0;
+        const size_t page = pageSize();
+        const uintptr_t begin = uintptr_t(data) & ~uintptr_t(page - 1);
+        const size_t length = uintptr_t(data) + bytes - begin;
+        std::vector<unsigned char> pages((length + page - 1) / page);
+        if (mincore(reinterpret_cast<void*>(begin), length, &pages[0]) != 0)
+          return 0;
+        size_t nbResident = 0;
+        for (size_t i = 0; i < pages.size(); i++)
+          nbResident += pages[i] & 1;
+        return nbResident * page;
+#else
+        return 0;
+#endif
+      }
+
+      template<typename T>
+      static size_t of(const DenseVector<T>* v)
+      {
+        return of(v->getValues(), v->dimension() * sizeof(T));
+      }
+
+      /**
+       * Of the pages of [data, data + bytes) this process wrote, which it alone maps; unlike of(),
+       * without the zero page, nor the pages of a file it only read. From /proc/self/pagemap, or
+       * else as of().
+       */
+      static size_t written(const void* data, const size_t& bytes)
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        if (!data || !bytes)
+          return 0;
+        const size_t page = pageSize();
+        const uintptr_t first = uintptr_t(data) / page;
+        const size_t nbPages = (uintptr_t(data) + bytes + page - 1) / page - first;
+        FILE* f = fopen("/proc/self/pagemap", "rb");
+        if (!f)
+          return of(data, bytes);
+        std::vector<uint64_t> entries(nbPages);
+        const bool read = fseek(f, long(first * sizeof(uint64_t)), SEEK_SET) == 0
+            && fread(&entries[0], sizeof(uint64_t), nbPages, f) == nbPages;
+        fclose(f);
+        if (!read)
+          return of(data, bytes);
+        size_t nbWritten = 0;
+        for (size_t i = 0; i < nbPages; i++)
+        {
+          // Bit 63: present; bit 56: exclusively mapped
+          if ((entries[i] >> 63) & (entries[i] >> 56) & 1)
+            ++nbWritten;
+        }
+        return nbWritten * page;
+#else
+        return 0;
+#endif
+      }
+
+      template<typename T>
+      static size_t written(const DenseVector<T>* v)
+      {
+        return written(v->getValues(), v->dimension() * sizeof(T));
+      }
+
+      // Of the process
+      static size_t process()
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        FILE* f = fopen("/proc/self/statm", "r");
+        if (!f)
+          return 0;
+        unsigned long size = 0, resident = 0;
+        const int n = fscanf(f, "%lu %lu", &size, &resident);
+        fclose(f);
+        return n == 2 ? resident * pageSize() : 0;
+#else
+        return 0;
+#endif
+      }
+
+      // Of the transparent huge pages of the process
+      static size_t hugePages()
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        FILE* f = fopen("/proc/self/smaps_rollup", "r");
+        if (!f)
+          return 0;
+        char line[256];
+        unsigned long kB = 0;
+        while (fgets(line, sizeof(line), f))
+        {
+          if (sscanf(line, "AnonHugePages: %lu kB", &kB) == 1)
+            break;
+        }
+        fclose(f);
+        return kB * 1024;
+#else
+        return 0;
+#endif
+      }
+  };
+
+  /**
+   * Anonymous private mappings: the pages are zero until first written, and only the written
+   * pages are committed; e.g., a hashed memory of 2^28 tiles where a run touches a few. clear()
+   * gives the pages back to the kernel, rather than writes every value. The capacity is reserved,
+   * not committed (MAP_NORESERVE), hence an overcommitted run fails on a write, not on allocate().
+   * Below a page, and where there is no mmap, the values are on the heap.
+   */
+  template<typename T>
+  class PagedStorage: public Storage<T>
+  {
+    public:
+      T* allocate(const int& capacity)
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        if (isPaged(capacity))
+        {
+          void* data = mmap(0, length(capacity), PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+          if (data != MAP_FAILED)
+          {
+#if defined(MADV_NOHUGEPAGE)
+            // A huge page would commit 2 MB per written tile
+            madvise(data, length(capacity), MADV_NOHUGEPAGE);
+#endif
+            return static_cast<T*>(data);
+          }
+          std::cerr << "ERROR! (mmap) capacity=" << capacity << std::endl;
+          exit(-1);
+        }
+#endif
+        return HeapStorage<T>::getInstance()->allocate(capacity);
+      }
+
+      void deallocate(T* data, const int& capacity)
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        if (isPaged(capacity))
+        {
+          munmap(data, length(capacity));
+          return;
+        }
+#endif
+        HeapStorage<T>::getInstance()->deallocate(data, capacity);
+      }
+
+      void clear(T* data, const int& capacity)
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        // The pages read as zero again
+        if (isPaged(capacity) && madvise(data, length(capacity), MADV_DONTNEED) == 0)
+          return;
+#endif
+        Storage<T>::clear(data, capacity);
+      }
+
+      static PagedStorage<T>* getInstance()
+      {
+        static PagedStorage<T> instance;
+        return &instance;
+      }
+
+    protected:
+      bool isPaged(const int& capacity) const
+      {
+        return capacity * sizeof(T) >= ResidentMemory::pageSize();
+      }
+
+      size_t length(const int& capacity) const
+      {
+        const size_t page = ResidentMemory::pageSize();
+        return ((capacity * sizeof(T) + page - 1) / page) * page;
+      }
+  };
+
+  /**
+   * Mappings aligned to 2 MB, in huge pages, so that a TLB entry covers 512 times the values of a
+   * small page; e.g., the weights of a hashed memory of hundreds of megabytes, read and written
+   * at random indexes. The huge pages are the transparent ones (MADV_HUGEPAGE), or the reserved
+   * ones of hugetlbfs when explicit is set and the kernel has them.
+   *
+   * allocate() writes nothing, hence a page is placed on the NUMA node of the thread that first
+   * writes it; e.g., the worker of a MultiAgentRunner that steps the agent. A node >= 0 prefers
+   * that node instead (mbind). clear() writes the values, so that the pages stay where they are.
+   * Below 2 MB, and where there is no mmap, the values are on the heap.
+   */
+  template<typename T>
+  class HugePageStorage: public Storage<T>
+  {
+    protected:
+      int node;
+      bool explicitHugePages;
+
+    public:
+      HugePageStorage(const int& node = -1, const bool& explicitHugePages = false) :
+          node(node), explicitHugePages(explicitHugePages)
+      {
+      }
+
+      T* allocate(const int& capacity)
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        if (isHuge(capacity))
+        {
+          void* data = map(length(capacity));
+          if (data)
+            return static_cast<T*>(data);
+          std::cerr << "ERROR! (mmap) capacity=" << capacity << std::endl;
+          exit(-1);
+        }
+#endif
+        return HeapStorage<T>::getInstance()->allocate(capacity);
+      }
+
+      void deallocate(T* data, const int& capacity)
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        if (isHuge(capacity))
+        {
+          munmap(data, length(capacity));
+          return;
+        }
+#endif
+        HeapStorage<T>::getInstance()->deallocate(data, capacity);
+      }
+
+      static size_t hugePageSize()
+      {
+        return size_t(1) << 21;
+      }
+
+      // Transparent huge pages, first touch
+      static HugePageStorage<T>* getInstance()
+      {
+        static HugePageStorage<T> instance;
+        return &instance;
+      }
+
+    protected:
+      bool isHuge(const int& capacity) const
+      {
+        return capacity * sizeof(T) >= hugePageSize();
+      }
+
+      size_t length(const int& capacity) const
+      {
+        const size_t page = hugePageSize();
+        return ((capacity * sizeof(T) + page - 1) / page) * page;
+      }
+
+#if defined(RLLIB_VIRTUAL_MEMORY)
+      void* map(const size_t& length) const
+      {
+        const int protection = PROT_READ | PROT_WRITE;
+        const int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+#if defined(MAP_HUGETLB)
+        if (explicitHugePages)
+        {
+          // hugetlbfs mappings are aligned to the huge page size
+          void* data = mmap(0, length, protection, flags | MAP_HUGETLB, -1, 0);
+          if (data != MAP_FAILED)
+            return place(data, length);
+        }
+#endif
+        // Over allocates by a huge page, then trims both ends to the alignment
+        const size_t page = hugePageSize();
+        char* mapped = static_cast<char*>(mmap(0, length + page, protection, flags, -1, 0));
+        if (mapped == MAP_FAILED)
+          return 0;
+        char* data = reinterpret_cast<char*>((uintptr_t(mapped) + page - 1)
+            & ~uintptr_t(page - 1));
+        if (data > mapped)
+          munmap(mapped, data - mapped);
+        munmap(data + length, (mapped + page) - data);
+#if defined(MADV_HUGEPAGE)
+        madvise(data, length, MADV_HUGEPAGE);
+#endif
+        return place(data, length);
+      }
+
+      void* place(void* data, const size_t& length) const
+      {
+#if defined(SYS_mbind)
+        if (node >= 0 && node < 64)
+        {
+          // MPOL_PREFERRED, without libnuma
+          const unsigned long mask = 1UL << node;
+          if (syscall(SYS_mbind, data, length, 1, &mask, 64, 0) != 0)
+            std::cerr << "WARNING! (mbind) node=" << node << " " << strerror(errno) << std::endl;
+        }
+#endif
+        return data;
+      }
+#endif
+  };
+
+  /**
+   * A weight file, in the format of DenseVector::persist(), mapped in memory: the values are read
+   * from the file on demand, hence a model larger than memory, and a start from a checkpoint
+   * without reading it. Shared, the values written are the file's, and flush() makes them durable
+   * (msync). Private, the values written are copies, and the file is left as is.
+   *
+   * A new file is created with capacity zeros. An existing file must have the given capacity, or a
+   * capacity of 0 takes the file's.
+   */
+  template<typename T>
+  class MappedFile
+  {
+    protected:
+      std::string path;
+      bool shared;
+      int fd;
+      int capacity;
+      size_t length;
+      char* base;
+
+    public:
+      MappedFile(const char* f, const int& capacity = 0, const bool& shared = true) :
+          path(f), shared(shared), fd(-1), capacity(capacity), length(0), base(0)
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        fd = open(f, O_RDWR | O_CREAT, 0644);
+        if (fd < 0 && !shared)
+          fd = open(f, O_RDONLY);
+        if (fd < 0)
+          error("open");
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+          error("stat");
+        const int header[2] = { 0 /*DenseVector*/, capacity };
+        if (st.st_size == 0)
+        {
+          if (capacity <= 0 || ftruncate(fd, dataOffset() + capacity * sizeof(T)) != 0
+              || pwrite(fd, header, sizeof(header), 0) != ssize_t(sizeof(header)))
+            error("create");
+        }
+        else
+        {
+          int rheader[2];
+          if (pread(fd, rheader, sizeof(rheader), 0) != ssize_t(sizeof(rheader))
+              || rheader[0] != header[0] || (capacity > 0 && rheader[1] != capacity)
+              || size_t(st.st_size) != dataOffset() + rheader[1] * sizeof(T))
+            error("format");
+          this->capacity = rheader[1];
+        }
+        length = dataOffset() + this->capacity * sizeof(T);
+        void* mapped = mmap(0, length, PROT_READ | PROT_WRITE,
+            shared ? MAP_SHARED : MAP_PRIVATE | MAP_NORESERVE, fd, 0);
+        if (mapped == MAP_FAILED)
+          error("mmap");
+        base = static_cast<char*>(mapped);
+#else
+        error("mmap");
+#endif
+      }
+
+      virtual ~MappedFile()
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        if (base)
+          munmap(base, length);
+        if (fd >= 0)
+          close(fd);
+#endif
+      }
+
+    private:
+      MappedFile(const MappedFile<T>&);
+      MappedFile<T>& operator=(const MappedFile<T>&);
+
+    public:
+      T* getValues()
+      {
+        return reinterpret_cast<T*>(base + dataOffset());
+      }
+
+      int dimension() const
+      {
+        return capacity;
+      }
+
+      bool isShared() const
+      {
+        return shared;
+      }
+
+      const char* getPath() const
+      {
+        return path.c_str();
+      }
+
+      // Whether f names this file, under any path
+      bool isFile(const char* f) const
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        struct stat that, st;
+        return stat(f, &that) == 0 && fstat(fd, &st) == 0 && that.st_dev == st.st_dev
+            && that.st_ino == st.st_ino;
+#else
+        return false;
+#endif
+      }
+
+      // The values written so far are on disk; a no-op when private
+      void flush()
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        if (shared && msync(base, length, MS_SYNC) != 0)
+          std::cerr << "ERROR! (msync) file=" << path << std::endl;
+#endif
+      }
+
+      /**
+       * Shared, the pages of the file are deallocated, which reads as zeros, rather than written;
+       * private, the copies are written, since dropping them would read the file again.
+       */
+      void clear()
+      {
+#if defined(RLLIB_VIRTUAL_MEMORY) && defined(FALLOC_FL_PUNCH_HOLE)
+        if (shared)
+        {
+          // Whole pages only; the header shares the first page
+          const size_t page = ResidentMemory::pageSize();
+          const size_t begin = ((dataOffset() + page - 1) / page) * page;
+          const size_t end = (length / page) * page;
+          if (end > begin
+              && fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, begin, end - begin) == 0)
+          {
+            std::fill(getValues(), reinterpret_cast<T*>(base + begin), T(0));
+            std::fill(reinterpret_cast<T*>(base + end), getValues() + capacity, T(0));
+            return;
+          }
+        }
+#endif
+        std::fill(getValues(), getValues() + capacity, T(0));
+      }
+
+    protected:
+      static size_t dataOffset()
+      {
+        return 2 * sizeof(int);
+      }
+
+      void error(const char* what) const
+      {
+        std::cerr << "ERROR! (" << what << ") file=" << path << std::endl;
+        exit(-1);
+      }
+  };
+
+  /**
+   * A PVector of a MappedFile; e.g., the weights of tens of thousands of GVFs that do not fit in
+   * memory. The weights of a learner map a file with weights()->bind(file.getValues(), false).
+   *
+   * persist(f) to the mapped file is flush() when shared; any other f, or a private mapping, is
+   * written to a new file, renamed to f, so that the mapped pages never see a truncated file.
+   * resurrect(f) maps f in place of the current file, in the same mode, with f's capacity; a no-op
+   * on the file of a shared mapping, and a private mapping of the same file drops its copies.
+   */
+  template<typename T>
+  class MappedPVector: public PVector<T>
+  {
+    private:
+      typedef PVector<T> Base;
+      MappedFile<T>* file;
+
+    public:
+      MappedPVector(const char* f, const int& capacity = 0, const bool& shared = true) :
+          PVector<T>(0), file(0)
+      {
+        map(f, capacity, shared);
+      }
+
+      virtual ~MappedPVector()
+      {
+        delete file;
+      }
+
+    private:
+      MappedPVector(const MappedPVector<T>&);
+      MappedPVector<T>& operator=(const MappedPVector<T>&);
+
+    public:
+      MappedFile<T>* getFile() const
+      {
+        return file;
+      }
+
+      void flush()
+      {
+        file->flush();
+      }
+
+      void clear()
+      {
+        file->clear();
+      }
+
+      void persist(const char* f) const
+      {
+        if (file->isShared() && file->isFile(f))
+        {
+          file->flush();
+          return;
+        }
+#if defined(RLLIB_VIRTUAL_MEMORY)
+        const std::string tmp = std::string(f) + ".tmp";
+        Base::persist(tmp.c_str());
+        if (rename(tmp.c_str(), f) != 0)
+          std::cerr << "ERROR! (persist) file=" << f << std::endl;
+#endif
+      }
+
+      void resurrect(const char* f)
+      {
+        if (!file->isShared() || !file->isFile(f))
+          map(f, 0, file->isShared());
+      }
+
+    protected:
+      void map(const char* f, const int& capacity, const bool& shared)
+      {
+        MappedFile<T>* mapped = new MappedFile<T>(f, capacity, shared);
+        Base::bind(mapped->getValues(), false);
+        Base::capacity = mapped->dimension();
+        delete file;
+        file = mapped;
+      }
+  };
+
+} // namespace RLLib
+
+#endif /* VIRTUALMEMORY_H_ */
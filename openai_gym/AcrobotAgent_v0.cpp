@@ -51,3 +51,13 @@ const RLLib::Action<double>* AcrobotAgent_v0::step()
   return simulator->getAgentAction();
 }
 
+void AcrobotAgent_v0::reset()
+{
+  simulator->reset();
+}
+
+void AcrobotAgent_v0::resurrect(const char* f)
+{
+  control->resurrect(f);
+}
+
@@ -73,6 +73,8 @@ class AcrobotAgent_v0: public AcrobotAgent_v0Base
     AcrobotAgent_v0();
     virtual ~AcrobotAgent_v0();
     const RLLib::Action<double>* step();
+    void reset();
+    void resurrect(const char* f);
 };
 
 #endif /* OPENAI_GYM_ACROBOTAGENT_V0_H_ */
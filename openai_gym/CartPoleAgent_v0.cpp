@@ -56,3 +56,14 @@ const RLLib::Action<double>* CartPoleAgent_v0::step()
   simulator->step();
   return simulator->getAgentAction();
 }
+
+void CartPoleAgent_v0::reset()
+{
+  simulator->reset();
+}
+
+void CartPoleAgent_v0::resurrect(const char* f)
+{
+  control->resurrect(f);
+}
+
@@ -54,3 +54,13 @@ const RLLib::Action<double>* LunarLanderAgent_v2::step()
   return simulator->getAgentAction();
 }
 
+void LunarLanderAgent_v2::reset()
+{
+  simulator->reset();
+}
+
+void LunarLanderAgent_v2::resurrect(const char* f)
+{
+  control->resurrect(f);
+}
+
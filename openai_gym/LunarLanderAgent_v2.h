@@ -203,6 +203,8 @@ class LunarLanderAgent_v2: public LunarLanderAgent_v2Base
     virtual ~LunarLanderAgent_v2();
 
     const RLLib::Action<double>* step();
+    void reset();
+    void resurrect(const char* f);
 
 };
 
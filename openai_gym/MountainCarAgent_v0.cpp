@@ -50,3 +50,13 @@ const RLLib::Action<double>* MountainCarAgent_v0::step()
   return simulator->getAgentAction();
 }
 
+void MountainCarAgent_v0::reset()
+{
+  simulator->reset();
+}
+
+void MountainCarAgent_v0::resurrect(const char* f)
+{
+  control->resurrect(f);
+}
+
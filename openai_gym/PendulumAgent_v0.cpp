@@ -72,3 +72,14 @@ const RLLib::Action<double>* PendulumAgent_v0::step()
   simulator->step();
   return simulator->getAgentAction();
 }
+
+void PendulumAgent_v0::reset()
+{
+  simulator->reset();
+}
+
+void PendulumAgent_v0::resurrect(const char* f)
+{
+  control->resurrect(f);
+}
+
@@ -8,12 +8,15 @@
 #ifndef OPENAI_GYM_RLLIBOPENAIGYMAGENT_H_
 #define OPENAI_GYM_RLLIBOPENAIGYMAGENT_H_
 
+#include <string>
+
 #include "OpenAiGymRLProblem.h"
 
 class RLLibOpenAiGymAgent
 {
   public:
     OpenAiGymRLProblem* problem; //<< interface between OpenAi and RLLib
+    std::string env; //<< set by the registry, to pool the agent
 
     RLLibOpenAiGymAgent() :
         problem(nullptr)
@@ -25,6 +28,10 @@ class RLLibOpenAiGymAgent
     }
 
     virtual const RLLib::Action<double>* step() =0;
+    // A new run, as a new agent would start, without allocations
+    virtual void reset() =0;
+    // The learner from a checkpoint of its control
+    virtual void resurrect(const char* f) =0;
 };
 
 #endif /* OPENAI_GYM_RLLIBOPENAIGYMAGENT_H_ */
@@ -7,7 +7,8 @@
 
 #include "RLLibOpenAiGymAgentRegistry.h"
 
-RLLibOpenAiGymAgentRegistry::RLLibOpenAiGymAgentRegistry()
+RLLibOpenAiGymAgentRegistry::RLLibOpenAiGymAgentRegistry() :
+    maxPoolSize(4)
 {
 }
 
@@ -15,6 +16,8 @@ RLLibOpenAiGymAgentRegistry::~RLLibOpenAiGymAgentRegistry()
 {
   for (auto iter = registry.begin(); iter != registry.end(); ++iter)
   {
+    for (auto agent = iter->second->pool.begin(); agent != iter->second->pool.end(); ++agent)
+      delete *agent;
     delete iter->second;
   }
 }
@@ -30,16 +33,82 @@ RLLibOpenAiGymAgent* RLLibOpenAiGymAgentRegistry::make(const std::string& env)
   // Register OpenAI Gym agents here
   std::cout << "env: [" << env << "]" << std::endl;
 
+  RLLibOpenAiGymAgent* agent = nullptr;
+  std::string checkpoint;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<std::string, Entry*>::iterator iter = registry.find(env);
+    if (iter == registry.end())
+      return nullptr;
+    Entry* entry = iter->second;
+    checkpoint = entry->checkpoint;
+    if (!entry->pool.empty())
+    {
+      agent = entry->pool.back();
+      entry->pool.pop_back();
+    }
+    else
+    {
+      agent = entry->factory->make();
+      agent->env = env;
+    }
+  }
+
+  // Outside of the lock: the other sessions keep going
+  agent->reset();
+  if (!checkpoint.empty())
+    agent->resurrect(checkpoint.c_str());
+  return agent;
+}
+
+void RLLibOpenAiGymAgentRegistry::release(RLLibOpenAiGymAgent* agent)
+{
+  if (!agent)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<std::string, Entry*>::iterator iter = registry.find(agent->env);
+    if (iter != registry.end() && iter->second->pool.size() < maxPoolSize)
+    {
+      iter->second->pool.push_back(agent);
+      return;
+    }
+  }
+  delete agent;
+}
+
+void RLLibOpenAiGymAgentRegistry::prewarm(const std::string& env, const int& nbAgents)
+{
+  std::lock_guard<std::mutex> lock(mutex);
   std::unordered_map<std::string, Entry*>::iterator iter = registry.find(env);
-  if (iter != RLLibOpenAiGymAgentRegistry::getInstance().registry.end())
+  if (iter == registry.end())
   {
-    return iter->second->factory->make();
+    std::cerr << "ERROR! (prewarm) env=" << env << std::endl;
+    return;
   }
-  else
+  Entry* entry = iter->second;
+  for (int i = 0; i < nbAgents && entry->pool.size() < maxPoolSize; ++i)
   {
-    return nullptr;
+    RLLibOpenAiGymAgent* agent = entry->factory->make();
+    agent->env = env;
+    entry->pool.push_back(agent);
   }
+  std::cout << "prewarmed: env: " << env << " agents: " << entry->pool.size() << std::endl;
+}
+
+void RLLibOpenAiGymAgentRegistry::setCheckpoint(const std::string& env,
+    const std::string& checkpoint)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  std::unordered_map<std::string, Entry*>::iterator iter = registry.find(env);
+  if (iter != registry.end())
+    iter->second->checkpoint = checkpoint;
+}
 
+void RLLibOpenAiGymAgentRegistry::setMaxPoolSize(const size_t& maxPoolSize)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  this->maxPoolSize = maxPoolSize;
 }
 
 void RLLibOpenAiGymAgentRegistry::registerInstance(const std::string& name, const std::string& env,
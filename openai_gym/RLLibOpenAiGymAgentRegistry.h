@@ -12,6 +12,8 @@
 #include "RLLibOpenAiGymAgentFactory.h"
 
 #include <iostream>
+#include <vector>
+#include <mutex>
 #include <unordered_map>
 
 class RLLibOpenAiGymAgentRegistry
@@ -23,6 +25,8 @@ class RLLibOpenAiGymAgentRegistry
         std::string name;
         std::string env;
         RLLibOpenAiGymAgentFactory* factory;
+        std::vector<RLLibOpenAiGymAgent*> pool; // released agents, ready to be reset
+        std::string checkpoint;
 
         Entry(const std::string& name, const std::string& env, RLLibOpenAiGymAgentFactory* factory) :
             name(name), env(env), factory(factory)
@@ -31,12 +35,22 @@ class RLLibOpenAiGymAgentRegistry
 
     };
     std::unordered_map<std::string, Entry*> registry; // env, entry
+    std::mutex mutex; // one session per thread
+    size_t maxPoolSize;
 
   public:
 
     static RLLibOpenAiGymAgentRegistry& getInstance();
 
+    // A pooled agent after reset(), or else a new one; restored from the checkpoint, if any
     RLLibOpenAiGymAgent* make(const std::string& env);
+    // Back to the pool of its env, instead of delete
+    void release(RLLibOpenAiGymAgent* agent);
+    // Constructs nbAgents agents ahead of the sessions
+    void prewarm(const std::string& env, const int& nbAgents = 1);
+    // A file persisted by the control of an agent of env; empty to start from scratch
+    void setCheckpoint(const std::string& env, const std::string& checkpoint);
+    void setMaxPoolSize(const size_t& maxPoolSize);
     void registerInstance(const std::string& name, const std::string& env,
         RLLibOpenAiGymAgentFactory* factory);
 
@@ -20,10 +20,8 @@ RLLibOpenAiGymProxy::RLLibOpenAiGymProxy() :
 
 RLLibOpenAiGymProxy::~RLLibOpenAiGymProxy()
 {
-  if (!agent)
-  {
-    delete agent;
-  }
+  // The next session of the same env reuses it
+  RLLibOpenAiGymAgentRegistry::getInstance().release(agent);
 }
 
 std::string RLLibOpenAiGymProxy::toRLLib(const std::string& str)
@@ -35,11 +33,8 @@ std::string RLLibOpenAiGymProxy::toRLLib(const std::string& str)
   {
     if ((cmdIdx = str.find("__I__")) != std::string::npos)
     {
-      if (agent)
-      {
-        delete agent;
-        agent = 0;
-      }
+      // A restart reuses the allocated agent, after a reset
+      RLLibOpenAiGymAgentRegistry::getInstance().release(agent);
       agent = RLLibOpenAiGymAgentRegistry::getInstance().make(str.substr(cmdIdx + 6));
       return agent ? "__A__" : "__?__";
     }
@@ -7,8 +7,12 @@
 
 #include "SyncTcpServer.h"
 
-int main()
+// e.g., openai_gym MountainCar-v0 CartPole-v0: an agent of each env is ready before the sessions
+int main(int argc, char** argv)
 {
+  for (int i = 1; i < argc; ++i)
+    RLLibOpenAiGymAgentRegistry::getInstance().prewarm(argv[i]);
+
   SyncTcpServer syncServer(2345);
   syncServer.server();
 
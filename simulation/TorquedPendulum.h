@@ -25,15 +25,33 @@
 #include <cmath>
 #include "util/RK4.h"
 
-class TorquedPendulum: public RK4
+// The torque is the input of the dynamics
+struct TorquedPendulumDynamics
 {
-  protected:
-    double m, l, mu, g;
+    double m, l, mu, g, torque;
 
+    TorquedPendulumDynamics(const double& m, const double& l, const double& mu) :
+        m(m), l(l), mu(mu), g(9.8), torque(0)
+    {
+    }
+
+    void operator()(const double& time, const std::array<double, 2>& x,
+        std::array<double, 2>& x_dot) const
+    {
+      x_dot[0] = x[1];
+      x_dot[1] = (-mu * x[1] + m * g * l * sin(x[0]) + torque) / (m * l * l);
+    }
+};
+
+// Integrator is RungeKutta4 (fixed step) or DormandPrince (adaptive)
+template<template<int, typename > class Integrator = RungeKutta4>
+class TorquedPendulum: public Integrator<2, TorquedPendulumDynamics>
+{
   public:
+    typedef Integrator<2, TorquedPendulumDynamics> Base;
 
     TorquedPendulum(const double& m, const double& l, const double& mu, const double& dt) :
-        RK4(2, dt), m(m), l(l), mu(mu), g(9.8)
+        Base(TorquedPendulumDynamics(m, l, mu), dt)
     {
     }
 
@@ -41,13 +59,10 @@ class TorquedPendulum: public RK4
     {
     }
 
-    void f(const double& time, const Action<double>* action, const Vector<double>* x,
-        Vector<double>* x_dot)
+    void step(const Action<double>* action)
     {
-      x_dot->setEntry(0, x->getEntry(1));
-      x_dot->setEntry(1,
-          (-mu * x_dot->getEntry(0) + m * g * l * sin(x->getEntry(0)) + action->getEntry(0))
-              / (m * l * l));
+      Base::f.torque = action->getEntry(0);
+      Base::step();
     }
 
 };
@@ -22,31 +22,35 @@
 
 using namespace RLLib;
 
-class UnderwaterVehicle: public RLProblem<double>
+// The thrust is the input of the dynamics
+struct UnderwaterVehicleDynamics
 {
-  protected:
-    class Dynammic: public RK4
+    double thrust;
+
+    UnderwaterVehicleDynamics() :
+        thrust(0)
     {
+    }
 
-      public:
-        Dynammic(const double& dt) :
-            RK4(1, dt)
-        {
-        }
-
-        void f(const double& time, const Action<double>* action, const Vector<double>* x,
-            Vector<double>* x_dot)
-        {
-          const double u = action->getEntry(0);
-          const double v = x->getEntry(0);
-          const double abs_v = fabs(v);
-          const double c_v = 1.2f + 0.2f * sin(abs_v);
-          const double m_v = 3.0f + 1.5f * sin(abs_v);
-          const double k_v_u = -0.5f * tanh((fabs(c_v * v * abs_v - u) - 30.0f) * 0.1f) + 0.5f;
-          x_dot->setEntry(0, (u * k_v_u - c_v * v * abs_v) / m_v);
-        }
-
-    };
+    void operator()(const double& time, const std::array<double, 1>& x,
+        std::array<double, 1>& x_dot) const
+    {
+      const double u = thrust;
+      const double v = x[0];
+      const double abs_v = fabs(v);
+      const double c_v = 1.2f + 0.2f * sin(abs_v);
+      const double m_v = 3.0f + 1.5f * sin(abs_v);
+      const double k_v_u = -0.5f * tanh((fabs(c_v * v * abs_v - u) - 30.0f) * 0.1f) + 0.5f;
+      x_dot[0] = (u * k_v_u - c_v * v * abs_v) / m_v;
+    }
+};
+
+// Integrator is RungeKutta4 (fixed step) or DormandPrince (adaptive)
+template<template<int, typename > class Integrator = RungeKutta4>
+class UnderwaterVehicle: public RLProblem<double>
+{
+  protected:
+    typedef Integrator<1, UnderwaterVehicleDynamics> Dynamic;
 
   private:
     Range<double>* thrustRange;
@@ -58,13 +62,13 @@ class UnderwaterVehicle: public RLProblem<double>
     double setPoint; // m/s
     int timeSteps;
 
-    Dynammic* dynamic;
+    Dynamic* dynamic;
 
   public:
     UnderwaterVehicle(Random<double>* random) :
         RLProblem<double>(random, 1, 5, 1), thrustRange(new Range<double>(-30, 30)), //
         velocityRange(new Range<double>(-5, 5)), dt(0.03), C(0.01), mu(0.3), setPoint(4), //
-        timeSteps(800), dynamic(new Dynammic(dt))
+        timeSteps(800), dynamic(new Dynamic(UnderwaterVehicleDynamics(), dt))
     {
       discreteActions->push_back(0, thrustRange->min());
       discreteActions->push_back(1, thrustRange->min() / 2.0f);
@@ -86,19 +90,20 @@ class UnderwaterVehicle: public RLProblem<double>
     void initialize()
     {
       dynamic->initialize();
-      dynamic->vec()->setEntry(0, -4.0); // m/s // TODO random
+      dynamic->vec()[0] = -4.0; // m/s // TODO random
     }
 
     void step(const Action<double>* action)
     {
-      for (int i = 0; i < 2; i++)
-        dynamic->step(action);
+      // The thrust is held for two time increments
+      dynamic->derivative().thrust = action->getEntry(0);
+      dynamic->step(2);
     }
 
     void updateTRStep()
     {
-      output->o_tp1->setEntry(0, velocityRange->toUnit(dynamic->vec()->getEntry(0)));
-      output->observation_tp1->setEntry(0, dynamic->vec()->getEntry(0));
+      output->o_tp1->setEntry(0, velocityRange->toUnit(dynamic->vec()[0]));
+      output->observation_tp1->setEntry(0, dynamic->vec()[0]);
       // TODO: only with one variable first
     }
 
@@ -109,7 +114,7 @@ class UnderwaterVehicle: public RLProblem<double>
 
     double r() const
     {
-      return fabs(setPoint - dynamic->vec()->getEntry(0)) < mu ? 0.0f : -C;
+      return fabs(setPoint - dynamic->vec()[0]) < mu ? 0.0f : -C;
     }
 
     double z() const
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CMAESTest.cpp
+ */
+
+#include "CMAESTest.h"
+
+RLLIB_TEST_MAKE(CMAESTest)
+
+double CMAESTest::sphere(const double* x, const int& n)
+{
+  double result = 0.0;
+  for (int i = 0; i < n; i++)
+    result += x[i] * x[i];
+  return result;
+}
+
+// Condition number 10^6
+double CMAESTest::ellipsoid(const double* x, const int& n)
+{
+  double result = 0.0;
+  for (int i = 0; i < n; i++)
+    result += std::pow(1e6, double(i) / double(n - 1)) * x[i] * x[i];
+  return result;
+}
+
+int CMAESTest::minimize(CMAES<double>* cmaes, double (*f)(const double*, const int&),
+    const double& target, const int& maxGenerations)
+{
+  std::vector<double> fitness(cmaes->getLambda());
+  for (int g = 0; g < maxGenerations; g++)
+  {
+    cmaes->samplePopulation();
+    for (int k = 0; k < cmaes->getLambda(); k++)
+      fitness[k] = f(cmaes->candidate(k), cmaes->dimension());
+    cmaes->updateDistribution(&fitness[0]);
+    if (f(cmaes->mean().data(), cmaes->dimension()) < target)
+      return cmaes->getGeneration();
+  }
+  return -1;
+}
+
+void CMAESTest::testEllipsoid()
+{
+  Random<double> random;
+  const int n = 10;
+  std::vector<double> xstart(n, 1.0);
+  CMAES<double> cmaes(&random, n, &xstart[0], 0.5);
+  const int nbGenerations = minimize(&cmaes, &ellipsoid, 1e-10, 5000);
+  cout << "## ellipsoid n=" << n << " generations=" << nbGenerations << " eigen="
+      << cmaes.getNbEigenDecompositions() << " axisRatio=" << cmaes.axisRatio() << endl;
+  Assert::assertPasses(nbGenerations > 0);
+  // The decomposition is not refreshed at every generation
+  Assert::assertPasses(cmaes.getNbEigenDecompositions() < nbGenerations);
+  // The sampling distribution has learned the scaling of the problem
+  Assert::assertPasses(cmaes.axisRatio() > 100.0);
+}
+
+void CMAESTest::testSeparableHighDimension()
+{
+  Random<double> random;
+  const int n = 1000;
+  std::vector<double> xstart(n, 1.0);
+  CMAES<double> cmaes(&random, n, &xstart[0], 0.5, 0, true);
+  Timer timer;
+  timer.start();
+  const int nbGenerations = minimize(&cmaes, &sphere, 1e-6, 20000);
+  timer.stop();
+  cout << "## separable n=" << n << " generations=" << nbGenerations << " time(ms)="
+      << timer.getElapsedTimeInMilliSec() << endl;
+  Assert::assertPasses(nbGenerations > 0);
+  Assert::assertPasses(cmaes.getNbEigenDecompositions() == 0);
+}
+
+void CMAESTest::testLegacyComparison()
+{
+  const int n = 100;
+  const int nbGenerations = 300;
+  std::vector<double> xstart(n, 1.0);
+  std::vector<double> stddev(n, 0.5);
+
+  Random<double> random;
+  CMAES<double> cmaes(&random, n, &xstart[0], 0.5);
+  std::vector<double> fitness(cmaes.getLambda());
+  Timer timer;
+  timer.start();
+  for (int g = 0; g < nbGenerations; g++)
+  {
+    cmaes.samplePopulation();
+    for (int k = 0; k < cmaes.getLambda(); k++)
+      fitness[k] = ellipsoid(cmaes.candidate(k), n);
+    cmaes.updateDistribution(&fitness[0]);
+  }
+  timer.stop();
+  const double time = timer.getElapsedTimeInMilliSec();
+  const double f = ellipsoid(cmaes.mean().data(), n);
+
+  cmaes_t evo = cmaes_t(); // cmaes_init reads evo.version
+  double* arFunvals = cmaes_init(&evo, n, &xstart[0], &stddev[0], 0, cmaes.getLambda(), "non");
+  timer.start();
+  for (int g = 0; g < nbGenerations; g++)
+  {
+    double* const * pop = cmaes_SamplePopulation(&evo);
+    for (int k = 0; k < cmaes.getLambda(); k++)
+      arFunvals[k] = ellipsoid(pop[k], n);
+    cmaes_UpdateDistribution(&evo, arFunvals);
+  }
+  timer.stop();
+  const double legacyTime = timer.getElapsedTimeInMilliSec();
+  const double legacyF = ellipsoid(cmaes_GetPtr(&evo, "xmean"), n);
+  cmaes_exit(&evo);
+
+  cout << "## n=" << n << " generations=" << nbGenerations << " CMAES(ms)=" << time << " f="
+      << f << " eigen=" << cmaes.getNbEigenDecompositions() << " util/cma(ms)=" << legacyTime
+      << " f=" << legacyF << endl;
+  // Same algorithm, hence the same order of progress from f(xstart)
+  const double f0 = ellipsoid(&xstart[0], n);
+  Assert::assertPasses(f < 1e-1 * f0 && legacyF < 1e-1 * f0);
+  Assert::assertPasses(f < 1e1 * legacyF);
+}
+
+void CMAESTest::run()
+{
+  testEllipsoid();
+  testSeparableHighDimension();
+  testLegacyComparison();
+}
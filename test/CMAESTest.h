@@ -0,0 +1,55 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * CMAESTest.h
+ */
+
+#ifndef CMAESTEST_H_
+#define CMAESTEST_H_
+
+#include "Test.h"
+#include "CMAES.h"
+#include "Timer.h"
+#include "util/cma/cmaes_interface.h"
+
+RLLIB_TEST(CMAESTest)
+
+class CMAESTest: public CMAESTestBase
+{
+  public:
+    CMAESTest()
+    {
+    }
+
+    virtual ~CMAESTest()
+    {
+    }
+
+    void run();
+
+  private:
+    static double sphere(const double* x, const int& n);
+    static double ellipsoid(const double* x, const int& n);
+
+    // Generations until f < target, or -1
+    int minimize(CMAES<double>* cmaes, double (*f)(const double*, const int&), const double& target,
+        const int& maxGenerations);
+
+    void testEllipsoid();
+    void testSeparableHighDimension();
+    void testLegacyComparison();
+};
+
+#endif /* CMAESTEST_H_ */
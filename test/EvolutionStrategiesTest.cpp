@@ -0,0 +1,99 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * EvolutionStrategiesTest.cpp
+ */
+
+#include "EvolutionStrategiesTest.h"
+
+RLLIB_TEST_MAKE(EvolutionStrategiesTest)
+
+void EvolutionStrategiesTest::testSharedSeedNoise()
+{
+  std::vector<RLProblem<double>*> problems;
+  problems.push_back(new NonMarkovPoleBalancing<double>(0, 1));
+  LinearPolicyEvolutionStrategies<double> es(problems, 8, 0.1, 0.01, 0.0, 7);
+  const int n = es.dimension();
+  std::vector<double> a(n), b(n), c(n);
+  es.noise(es.noiseStream(3), &a[0]);
+  es.noise(es.noiseStream(3), &b[0]);
+  es.noise(es.noiseStream(4), &c[0]);
+  for (int i = 0; i < n; i++)
+    Assert::assertPasses(a[i] == b[i]);
+  Assert::assertPasses(!std::equal(a.begin(), a.end(), c.begin()));
+  delete problems[0];
+}
+
+void EvolutionStrategiesTest::testWorkerIndependence()
+{
+  // Deterministic problems: the result must not depend on the number of workers
+  std::vector<RLProblem<double>*> problems1, problems4;
+  problems1.push_back(new NonMarkovPoleBalancing<double>(0, 1));
+  for (int k = 0; k < 4; k++)
+    problems4.push_back(new NonMarkovPoleBalancing<double>(0, 1));
+  LinearPolicyEvolutionStrategies<double> es1(problems1, 8, 0.1, 0.01, 0.0, 11, 1, 200);
+  LinearPolicyEvolutionStrategies<double> es4(problems4, 8, 0.1, 0.01, 0.0, 11, 1, 200);
+  for (int g = 0; g < 10; g++)
+  {
+    const double r1 = es1.update();
+    const double r4 = es4.update();
+    Assert::assertPasses(r1 == r4);
+  }
+  Assert::assertEquals(es1.weights(), es4.weights(), 1e-10);
+  Assert::assertPasses(es1.weights()->maxNorm() > 0.0);
+  delete problems1[0];
+  for (int k = 0; k < 4; k++)
+    delete problems4[k];
+}
+
+void EvolutionStrategiesTest::testNonMarkovPoleBalancing()
+{
+  const int nbWorkers = 4;
+  const int maxEpisodeTimeSteps = 1000;
+  std::vector<Random<double>*> randoms;
+  std::vector<RLProblem<double>*> problems;
+  for (int k = 0; k < nbWorkers; k++)
+  {
+    randoms.push_back(new Random<double>(0, k));
+    problems.push_back(new NonMarkovPoleBalancing<double>(randoms[k], 1));
+  }
+  LinearPolicyEvolutionStrategies<double> es(problems, 16, 5.0, 50.0, 0.0, 0, 2,
+      maxEpisodeTimeSteps);
+  const double initial = es.evaluate(es.weights());
+  Timer timer;
+  timer.start();
+  double meanReturn = 0;
+  for (int g = 0; g < 200; g++)
+    meanReturn = es.update();
+  timer.stop();
+  const double final = es.evaluate(es.weights());
+  cout << "## workers=" << nbWorkers << " generations=" << es.getGeneration() << " initial="
+      << initial << " mean=" << meanReturn << " final=" << final << " time(ms)="
+      << timer.getElapsedTimeInMilliSec() << endl;
+  Assert::assertPasses(final > 0.9 * maxEpisodeTimeSteps);
+  Assert::assertPasses(final > initial);
+  for (int k = 0; k < nbWorkers; k++)
+  {
+    delete problems[k];
+    delete randoms[k];
+  }
+}
+
+void EvolutionStrategiesTest::run()
+{
+  testSharedSeedNoise();
+  testWorkerIndependence();
+  testNonMarkovPoleBalancing();
+}
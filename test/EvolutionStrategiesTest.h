@@ -0,0 +1,48 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * EvolutionStrategiesTest.h
+ */
+
+#ifndef EVOLUTIONSTRATEGIESTEST_H_
+#define EVOLUTIONSTRATEGIESTEST_H_
+
+#include "Test.h"
+#include "EvolutionStrategies.h"
+#include "NonMarkovPoleBalancing.h"
+#include "Timer.h"
+
+RLLIB_TEST(EvolutionStrategiesTest)
+
+class EvolutionStrategiesTest: public EvolutionStrategiesTestBase
+{
+  public:
+    EvolutionStrategiesTest()
+    {
+    }
+
+    virtual ~EvolutionStrategiesTest()
+    {
+    }
+
+    void run();
+
+  private:
+    void testSharedSeedNoise();
+    void testWorkerIndependence();
+    void testNonMarkovPoleBalancing();
+};
+
+#endif /* EVOLUTIONSTRATEGIESTEST_H_ */
@@ -320,7 +320,7 @@ void ExtendedProblemsTest::testGreedyGQAcrobot()
 void ExtendedProblemsTest::testTrueSarsaUnderwaterVehicle()
 {
   Random<double>* random = new Random<double>;
-  RLProblem<double>* problem = new UnderwaterVehicle(random);
+  RLProblem<double>* problem = new UnderwaterVehicle<>(random);
   Hashing<double>* hashing = new MurmurHashing<double>(random, 10000);
   Projector<double>* projector = new TileCoderHashing<double>(hashing, problem->dimension(), 10, 10,
       true);
@@ -430,16 +430,16 @@ void ExtendedProblemsTest::testTorquedPendulum()
   double d4 = 2.0;
   double d5 = 50;
 
-  TorquedPendulum torquedPendulum(m, l, mu, dt);
+  TorquedPendulum<> torquedPendulum(m, l, mu, dt);
   Action<double> force(0);
   force.push_back(d4);
-  torquedPendulum.vec()->setEntry(0, 0.0f);
-  torquedPendulum.vec()->setEntry(1, M_PI_2);
+  torquedPendulum.vec()[0] = 0.0f;
+  torquedPendulum.vec()[1] = M_PI_2;
 
   while (torquedPendulum.getTime() < d5)
   {
-    cout << torquedPendulum.getTime() << " " << torquedPendulum.vec()->getEntry(0) << " "
-        << torquedPendulum.vec()->getEntry(1) << endl;
+    cout << torquedPendulum.getTime() << " " << torquedPendulum.vec()[0] << " "
+        << torquedPendulum.vec()[1] << endl;
     torquedPendulum.step(&force);
   }
 }
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * IntegratorTest.cpp
+ */
+
+#include "IntegratorTest.h"
+
+RLLIB_TEST_MAKE(IntegratorTest)
+
+void IntegratorTest::testRungeKutta4AndDormandPrince()
+{
+  // x'' = -x, x(0) = 0, x'(0) = 1; the solution is (sin(t), cos(t))
+  const double dt = 0.05;
+  const int nbSteps = 20000;
+  LegacyOscillator legacy(2, dt);
+  legacy.vec()->setEntry(0, 0.0);
+  legacy.vec()->setEntry(1, 1.0);
+  RungeKutta4<2, Oscillator> rk4(Oscillator(), dt);
+  rk4.vec()[1] = 1.0;
+  DormandPrince<2, Oscillator> dopri(Oscillator(), dt, 1e-9, 1e-9);
+  dopri.vec()[1] = 1.0;
+
+  Timer timer;
+  timer.start();
+  for (int i = 0; i < nbSteps; i++)
+    legacy.step();
+  timer.stop();
+  const double legacyTime = timer.getElapsedTimeInMilliSec();
+  timer.start();
+  for (int i = 0; i < nbSteps; i++)
+    rk4.step();
+  timer.stop();
+  const double rk4Time = timer.getElapsedTimeInMilliSec();
+  timer.start();
+  for (int i = 0; i < nbSteps; i++)
+    dopri.step();
+  timer.stop();
+  const double dopriTime = timer.getElapsedTimeInMilliSec();
+
+  // Same scheme, hence the same rounding up to the order of the operations
+  ASSERT(std::abs(rk4.vec()[0] - legacy.vec()->getEntry(0)) < 1e-9);
+  ASSERT(std::abs(rk4.vec()[1] - legacy.vec()->getEntry(1)) < 1e-9);
+  const double t = rk4.getTime();
+  const double rk4Error = std::max(std::abs(rk4.vec()[0] - sin(t)),
+      std::abs(rk4.vec()[1] - cos(t)));
+  const double dopriError = std::max(std::abs(dopri.vec()[0] - sin(t)),
+      std::abs(dopri.vec()[1] - cos(t)));
+  cout << "## legacy RK4(ms)=" << legacyTime << " RK4(ms)=" << rk4Time << " error=" << rk4Error
+      << " DormandPrince(ms)=" << dopriTime << " error=" << dopriError << " accepted="
+      << dopri.getNbAccepted() << " rejected=" << dopri.getNbRejected() << endl;
+  ASSERT(rk4Error < 1e-4);
+  ASSERT(dopriError < 1e-5);
+  // Every call ends on its sampling instant
+  ASSERT(dopri.getNbAccepted() >= nbSteps);
+}
+
+void IntegratorTest::testTorquedPendulum()
+{
+  // The problems take the integrator as a template parameter
+  Action<double> force(0);
+  force.push_back(0.0);
+  TorquedPendulum<DormandPrince> pendulum(1.0, 1.0, 0.01, 0.01);
+  pendulum.vec()[0] = 0.1;
+  while (pendulum.getTime() < 50.0)
+    pendulum.step(&force);
+  cout << "## TorquedPendulum<DormandPrince> steps=" << pendulum.getTimeSteps() << " accepted="
+      << pendulum.getNbAccepted() << " rejected=" << pendulum.getNbRejected() << endl;
+  ASSERT(Boundedness::checkValue(pendulum.vec()[0]));
+}
+
+void IntegratorTest::testHeldInput()
+{
+  // An input held for two increments is integrated in one call, with internal steps that span
+  // both increments
+  const double dt = 0.05;
+  const int nbSteps = 10000;
+  DormandPrince<2, Oscillator> twice(Oscillator(), dt);
+  twice.vec()[1] = 1.0;
+  DormandPrince<2, Oscillator> held(Oscillator(), dt);
+  held.vec()[1] = 1.0;
+  for (int i = 0; i < nbSteps; i++)
+  {
+    twice.step();
+    twice.step();
+    held.step(2);
+  }
+  const double t = held.getTime();
+  const double heldError = std::max(std::abs(held.vec()[0] - sin(t)),
+      std::abs(held.vec()[1] - cos(t)));
+  cout << "## DormandPrince step() x2 accepted=" << twice.getNbAccepted() << " step(2) accepted="
+      << held.getNbAccepted() << " error=" << heldError << endl;
+  ASSERT(held.getTimeSteps() == twice.getTimeSteps());
+  ASSERT(std::abs(held.getTime() - twice.getTime()) < 1e-9);
+  ASSERT(heldError < 1e-4);
+  ASSERT(held.getNbAccepted() < twice.getNbAccepted());
+
+  // The vehicle holds the thrust for two increments: one call per action
+  Random<double> random;
+  UnderwaterVehicle<DormandPrince> vehicle(&random);
+  vehicle.initialize();
+  Action<double> thrust(0);
+  thrust.push_back(30.0);
+  int nbActions = 0;
+  while (!vehicle.endOfEpisode())
+  {
+    vehicle.step(&thrust);
+    ++nbActions;
+  }
+  cout << "## UnderwaterVehicle<DormandPrince> actions=" << nbActions << endl;
+  ASSERT(nbActions == 401);
+}
+
+void IntegratorTest::run()
+{
+  testRungeKutta4AndDormandPrince();
+  testTorquedPendulum();
+  testHeldInput();
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * IntegratorTest.h
+ */
+
+#ifndef INTEGRATORTEST_H_
+#define INTEGRATORTEST_H_
+
+#include "Test.h"
+#include "Timer.h"
+
+// From the simulation
+#include "TorquedPendulum.h"
+#include "UnderwaterVehicle.h"
+
+#include "util/RK4.h"
+
+RLLIB_TEST(IntegratorTest)
+
+class IntegratorTest: public IntegratorTestBase
+{
+  public:
+    IntegratorTest()
+    {
+    }
+
+    virtual ~IntegratorTest()
+    {
+    }
+
+    void run();
+
+  private:
+    void testRungeKutta4AndDormandPrince();
+    void testTorquedPendulum();
+    void testHeldInput();
+
+    // x'' = -x with the legacy RK4
+    class LegacyOscillator: public RK4
+    {
+      public:
+        LegacyOscillator(const int& m, const double& dt) :
+            RK4(m, dt)
+        {
+        }
+
+        void f(const double& time, const Action<double>* action, const Vector<double>* x,
+            Vector<double>* x_dot)
+        {
+          x_dot->setEntry(0, +x->getEntry(1));
+          x_dot->setEntry(1, -x->getEntry(0));
+        }
+    };
+
+    struct Oscillator
+    {
+        void operator()(const double& time, const std::array<double, 2>& x,
+            std::array<double, 2>& x_dot) const
+        {
+          x_dot[0] = +x[1];
+          x_dot[1] = -x[0];
+        }
+    };
+};
+
+#endif /* INTEGRATORTEST_H_ */
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * MetricsTest.cpp
+ */
+
+
+#include "MetricsTest.h"
+
+RLLIB_TEST_MAKE(MetricsTest)
+
+static void produce(SPSCQueue<int>* queue, const int n)
+{
+  for (int i = 0; i < n; i++)
+  {
+    while (!queue->push(i))
+      std::this_thread::yield();
+  }
+}
+
+void MetricsTest::testRunningStatistics()
+{
+  Random<double> random;
+  std::vector<double> xs;
+  RunningStatistics<double> statistics;
+  for (int i = 0; i < 10000; i++)
+  {
+    xs.push_back(1000.0 + random.nextNormalGaussian());
+    statistics.add(xs.back());
+  }
+  double xbar = 0;
+  for (size_t i = 0; i < xs.size(); i++)
+    xbar += xs[i];
+  xbar /= xs.size();
+  double m2 = 0;
+  for (size_t i = 0; i < xs.size(); i++)
+    m2 += (xs[i] - xbar) * (xs[i] - xbar);
+  Assert::assertPasses(statistics.count() == 10000);
+  Assert::assertPasses(std::fabs(statistics.mean() - xbar) < 1e-9);
+  Assert::assertPasses(std::fabs(statistics.sumOfSquaredDeviations() - m2) < 1e-6 * m2);
+  Assert::assertPasses(std::fabs(statistics.stddev() - 1.0) < 0.05);
+  Assert::assertPasses(statistics.min() == *std::min_element(xs.begin(), xs.end()));
+  Assert::assertPasses(statistics.max() == *std::max_element(xs.begin(), xs.end()));
+  statistics.clear();
+  Assert::assertPasses(statistics.count() == 0 && statistics.variance() == 0);
+}
+
+void MetricsTest::testP2Quantile()
+{
+  // Exact on few observations
+  P2Quantile<double> small;
+  const double values[3] = { 3.0, 1.0, 2.0 };
+  for (int i = 0; i < 3; i++)
+    small.add(values[i]);
+  Assert::assertPasses(small.value() == 2.0);
+
+  Random<double> random;
+  P2Quantile<double> median(0.5), p90(0.9);
+  std::vector<double> xs;
+  for (int i = 0; i < 20000; i++)
+  {
+    const double x = random.nextReal() * 100.0;
+    xs.push_back(x);
+    median.add(x);
+    p90.add(x);
+  }
+  std::sort(xs.begin(), xs.end());
+  cout << "## median=" << median.value() << " (" << xs[10000] << ") p90=" << p90.value() << " ("
+      << xs[18000] << ")" << endl;
+  Assert::assertPasses(std::fabs(median.value() - xs[10000]) < 1.0);
+  Assert::assertPasses(std::fabs(p90.value() - xs[18000]) < 1.0);
+}
+
+void MetricsTest::testSPSCQueue()
+{
+  SPSCQueue<int> queue(1000);
+  Assert::assertPasses(queue.capacity() == 1024 && queue.empty());
+  int e = 0;
+  Assert::assertPasses(!queue.pop(e));
+  for (int i = 0; i < 1024; i++)
+    Assert::assertPasses(queue.push(i));
+  Assert::assertPasses(!queue.push(1024));
+  Assert::assertPasses(queue.pop(e) && e == 0);
+
+  // Every element, in order, through a small queue
+  SPSCQueue<int> channel(16);
+  const int n = 200000;
+  std::thread producer(produce, &channel, n);
+  bool ordered = true;
+  for (int expected = 0; expected < n;)
+  {
+    if (channel.pop(e))
+    {
+      ordered = ordered && (e == expected);
+      ++expected;
+    }
+    else
+      std::this_thread::yield();
+  }
+  producer.join();
+  Assert::assertPasses(ordered && channel.empty());
+}
+
+void MetricsTest::testSinkCSV()
+{
+  // From the bottom of the valley, hence 50 steps episodes
+  RLProblem<double>* problem = new MountainCar<double>;
+  RLAgent<double>* agent = new MetricsConstantAgent(problem);
+  RLRunner<double>* runner = new RLRunner<double>(agent, problem, 50, 20, 1);
+  runner->setVerbose(false);
+  runner->setEnableStatistics(true);
+  MetricsSink<double>* sink = new MetricsSink<double>("visualization/metrics.csv");
+  Assert::assertPasses(sink->isOpen());
+  sink->attach(runner, true);
+  runner->run();
+  sink->close();
+  // 20 episodes of 50 steps
+  Assert::assertPasses(sink->getNbRecords() == 20 * 50 + 20);
+  Assert::assertPasses(sink->getLengths()->count() == 20 && sink->getLengths()->mean() == 50);
+  Assert::assertPasses(sink->getReturns()->max() == -50);
+  Assert::assertPasses(sink->getMedianReturn() == -50);
+
+  std::ifstream in("visualization/metrics.csv");
+  std::string line;
+  std::getline(in, line);
+  Assert::assertPasses(line == "kind,episode,timeStep,end,R,Z,msPerStep");
+  int nbSteps = 0, nbEpisodes = 0;
+  while (std::getline(in, line))
+  {
+    int kind, episode, timeStep, end;
+    double r;
+    Assert::assertPasses(
+        sscanf(line.c_str(), "%d,%d,%d,%d,%lf", &kind, &episode, &timeStep, &end, &r) == 5);
+    if (kind == MetricsRecord::EPISODE)
+    {
+      Assert::assertPasses(episode == nbEpisodes && timeStep == 50 && end == 1 && r == -50);
+      ++nbEpisodes;
+    }
+    else
+    {
+      Assert::assertPasses(episode == nbEpisodes && timeStep == (nbSteps % 50) + 1);
+      Assert::assertPasses(r == -timeStep && end == (timeStep == 50));
+      ++nbSteps;
+    }
+  }
+  Assert::assertPasses(nbSteps == 20 * 50 && nbEpisodes == 20);
+  in.close();
+  std::remove("visualization/metrics.csv");
+  delete sink;
+  delete runner;
+  delete agent;
+  delete problem;
+}
+
+void MetricsTest::testSinkBinary()
+{
+  RLProblem<double>* problem = new MountainCar<double>;
+  RLAgent<double>* agent = new MetricsConstantAgent(problem);
+  RLRunner<double>* runner = new RLRunner<double>(agent, problem, 30, 500, 1);
+  runner->setVerbose(false);
+  // A queue smaller than an episode
+  MetricsSink<double>* sink = new MetricsSink<double>("visualization/metrics.bin",
+      MetricsSink<double>::BINARY, 8);
+  sink->attach(runner, true);
+  runner->run();
+  sink->close();
+  const long nbRecords = 500 * 30 + 500;
+  Assert::assertPasses(sink->getNbRecords() == nbRecords);
+  cout << "## stalls=" << sink->getNbStalls() << endl;
+  // A stalled runner resumes once the writer has brought the queue of 8 back to its high-water
+  // mark of 4, hence at least 4 records per stall; a few spurious wakeups are tolerated
+  Assert::assertPasses(sink->getNbStalls() <= nbRecords / 4 + 16);
+
+  std::ifstream in("visualization/metrics.bin", std::ios::binary);
+  char magic[8];
+  uint32_t header[2];
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(header), sizeof(header));
+  Assert::assertPasses(std::strncmp(magic, "RLLIBMET", 8) == 0);
+  Assert::assertPasses(header[0] == sizeof(MetricsRecord));
+  MetricsRecord record;
+  long n = 0, nbEpisodes = 0;
+  while (in.read(reinterpret_cast<char*>(&record), sizeof(record)))
+  {
+    if (record.kind == MetricsRecord::EPISODE)
+    {
+      Assert::assertPasses(record.episode == nbEpisodes && record.timeStep == 30);
+      ++nbEpisodes;
+    }
+    ++n;
+  }
+  Assert::assertPasses(n == nbRecords && nbEpisodes == 500);
+  in.close();
+  std::remove("visualization/metrics.bin");
+  delete sink;
+  delete runner;
+  delete agent;
+  delete problem;
+}
+
+void MetricsTest::run()
+{
+  testRunningStatistics();
+  testP2Quantile();
+  testSPSCQueue();
+  testSinkCSV();
+  testSinkBinary();
+}
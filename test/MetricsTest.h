@@ -0,0 +1,75 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * MetricsTest.h
+ */
+
+#ifndef METRICSTEST_H_
+#define METRICSTEST_H_
+
+#include "Test.h"
+#include "Metrics.h"
+
+RLLIB_TEST(MetricsTest)
+
+class MetricsTest: public MetricsTestBase
+{
+  public:
+    MetricsTest()
+    {
+    }
+
+    virtual ~MetricsTest()
+    {
+    }
+
+    void run();
+
+  private:
+    void testRunningStatistics();
+    void testP2Quantile();
+    void testSPSCQueue();
+    void testSinkCSV();
+    void testSinkBinary();
+};
+
+// Always the first action
+class MetricsConstantAgent: public RLAgent<double>
+{
+  public:
+    MetricsConstantAgent(RLProblem<double>* problem) :
+        RLAgent<double>(0), problem(problem)
+    {
+    }
+
+    const Action<double>* initialize(const TRStep<double>* step)
+    {
+      return problem->getDiscreteActions()->getEntry(0);
+    }
+
+    const Action<double>* getAtp1(const TRStep<double>* step)
+    {
+      return problem->getDiscreteActions()->getEntry(0);
+    }
+
+    void reset()
+    {
+    }
+
+  private:
+    RLProblem<double>* problem;
+};
+
+#endif /* METRICSTEST_H_ */
@@ -346,6 +346,169 @@ void MountainCarTest::testQMountainCar()
   delete sim;
 }
 
+void MountainCarTest::testReplayQMountainCar()
+{
+  Random<double>* random = new Random<double>;
+  RLProblem<double>* problem = new MountainCar<double>;
+  Hashing<double>* hashing = new MurmurHashing<double>(random, 10000);
+  Projector<double>* tiles = new TileCoderHashing<double>(hashing, problem->dimension(), 10, 10,
+      true);
+  CountingProjector<double>* projector = new CountingProjector<double>(tiles);
+  StateToStateAction<double>* toStateAction = new StateActionTilings<double>(projector,
+      problem->getDiscreteActions());
+  Trace<double>* e = new ATrace<double>(projector->dimension());
+  double alpha = 0.1 / projector->vectorNorm();
+  double gamma = 0.99;
+  Q<double>* q = new Q<double>(alpha, gamma, 0.0, e, problem->getDiscreteActions(),
+      toStateAction);
+  Policy<double>* acting = new Greedy<double>(problem->getDiscreteActions(), q);
+  // Only the active tiles are stored, not the observations
+  const int nbActions = problem->getDiscreteActions()->dimension();
+  ReplayBuffer<double>* buffer = new ReplayBuffer<double>(50000, 0, nbActions,
+      projector->vectorNorm());
+  const size_t memoryUsage = buffer->memoryUsage();
+  OffPolicyControlLearner<double>* control = new ReplayQControl<double>(random, acting,
+      toStateAction, q, buffer, alpha, gamma, 4, 0.6, 0.4);
+
+  RLAgent<double>* agent = new LearnerAgent<double>(control);
+  const int nbEpisodes = 100;
+  RLRunner<double>* sim = new RLRunner<double>(agent, problem, 5000, nbEpisodes, 1);
+  sim->setVerbose(false);
+  MountainCarLengthEvent training;
+  sim->onEpisodeEnd.push_back(&training);
+  sim->run();
+  const double nbSteps = training.lengths.mean() * nbEpisodes;
+  std::cout << "replay size=" << buffer->size() << " memory(bytes)=" << buffer->memoryUsage()
+      << " steps=" << nbSteps << " projections/step="
+      << double(projector->nbProjections) / (nbActions * nbSteps) << std::endl;
+  // One projection of x_tp1 per step, and of x_t at the beginning of the episodes
+  Assert::assertPasses(projector->nbProjections <= nbActions * (nbSteps + 2 * nbEpisodes));
+  Assert::assertPasses(buffer->size() == std::min(50000, int(nbSteps + 0.5)));
+  Assert::assertPasses(buffer->memoryUsage() == memoryUsage);
+
+  // Greedy, without learning
+  RLAgent<double>* greedy = new ControlAgent<double>(control);
+  RLRunner<double>* evaluation = new RLRunner<double>(greedy, problem, 5000, 20, 1);
+  evaluation->setVerbose(false);
+  MountainCarLengthEvent test;
+  evaluation->onEpisodeEnd.push_back(&test);
+  evaluation->run();
+  std::cout << "test episode length mean=" << test.lengths.mean() << " max="
+      << test.lengths.max() << std::endl;
+  Assert::assertPasses(test.lengths.max() < 1000);
+
+  delete random;
+  delete problem;
+  delete hashing;
+  delete tiles;
+  delete projector;
+  delete toStateAction;
+  delete e;
+  delete q;
+  delete acting;
+  delete buffer;
+  delete control;
+  delete agent;
+  delete sim;
+  delete greedy;
+  delete evaluation;
+}
+
+void MountainCarTest::testAnytimeQMountainCar()
+{
+  Random<double>* random = new Random<double>;
+  RLProblem<double>* problem = new MountainCar<double>;
+  Hashing<double>* hashing = new MurmurHashing<double>(random, 10000);
+  Projector<double>* projector = new TileCoderHashing<double>(hashing, problem->dimension(), 10, 10,
+      true);
+  StateToStateAction<double>* toStateAction = new StateActionTilings<double>(projector,
+      problem->getDiscreteActions());
+  Trace<double>* e = new ATrace<double>(projector->dimension());
+  double alpha = 0.15 / projector->vectorNorm();
+  double gamma = 0.99;
+  double lambda = 0.6;
+  Q<double>* q = new Q<double>(alpha, gamma, lambda, e, problem->getDiscreteActions(),
+      toStateAction);
+  Policy<double>* acting = new Greedy<double>(problem->getDiscreteActions(), q);
+  OffPolicyControlLearner<double>* control = new QControl<double>(acting, toStateAction, q);
+
+  // 20 microseconds per step; the learning work that does not fit is carried over
+  AnytimeLearnerAgent<double>* agent = new AnytimeLearnerAgent<double>(control, 0.02, 32);
+  RLRunner<double>* sim = new RLRunner<double>(agent, problem, 5000, 100, 1);
+  sim->setTestEpisodesAfterEachRun(true);
+  sim->run();
+  std::cout << "steps=" << agent->getNbSteps() << " misses=" << agent->getNbDeadlineMisses()
+      << " (" << agent->getDeadlineMissRate() << ") max(ms)=" << agent->getMaxStepTimeInMilliSec()
+      << " avg(ms)=" << agent->getAverageStepTimeInMilliSec() << " learned="
+      << agent->getNbLearned() << " dropped=" << agent->getNbDropped() << std::endl;
+  ASSERT(
+      agent->getNbLearned() + agent->getNbDropped() + agent->getNbPending()
+          == agent->getNbSteps() - agent->getNbEpisodes());
+
+  delete random;
+  delete problem;
+  delete hashing;
+  delete projector;
+  delete toStateAction;
+  delete e;
+  delete q;
+  delete acting;
+  delete control;
+  delete agent;
+  delete sim;
+}
+
+void MountainCarTest::testAnytimeDroppedTransitions()
+{
+  Random<double>* random = new Random<double>;
+  RLProblem<double>* problem = new MountainCar<double>;
+  Hashing<double>* hashing = new MurmurHashing<double>(random, 10000);
+  Projector<double>* projector = new TileCoderHashing<double>(hashing, problem->dimension(), 10, 10,
+      true);
+  StateToStateAction<double>* toStateAction = new StateActionTilings<double>(projector,
+      problem->getDiscreteActions());
+  Trace<double>* e = new ATrace<double>(projector->dimension());
+  Q<double>* q = new Q<double>(0.15 / projector->vectorNorm(), 0.99, 0.6, e,
+      problem->getDiscreteActions(), toStateAction);
+  Policy<double>* acting = new Greedy<double>(problem->getDiscreteActions(), q);
+  OffPolicyControlLearner<double>* learner = new QControl<double>(acting, toStateAction, q);
+  ContinuityCheckingControl<double>* control = new ContinuityCheckingControl<double>(learner,
+      problem->dimension());
+
+  // No budget: nothing is learned, not even at the end of the episodes, and the queue keeps the
+  // last 8 transitions
+  AnytimeLearnerAgent<double>* agent = new AnytimeLearnerAgent<double>(control, 0.0, 8);
+  RLRunner<double>* sim = new RLRunner<double>(agent, problem, 100, 5, 1);
+  sim->setVerbose(false);
+  sim->run();
+  ASSERT(agent->getNbEpisodes() == 5 && agent->getNbLearned() == 0);
+  ASSERT(agent->getNbPending() == 8);
+  ASSERT(agent->getNbDropped() == agent->getNbSteps() - agent->getNbEpisodes() - 8);
+
+  // They are carried over to the next episode, whose first step learns them within its budget
+  agent->setBudget(1e6);
+  sim->step();
+  std::cout << "learned=" << agent->getNbLearned() << " dropped=" << agent->getNbDropped()
+      << " restarts=" << agent->getNbRestarts() << " discontinuities="
+      << control->nbDiscontinuities << std::endl;
+  ASSERT(agent->getNbEpisodes() == 6 && agent->getNbPending() == 0);
+  ASSERT(agent->getNbLearned() == 8 && control->nbDeferred == 8);
+  ASSERT(agent->getNbRestarts() == 1 && control->nbDiscontinuities == 0);
+
+  delete random;
+  delete problem;
+  delete hashing;
+  delete projector;
+  delete toStateAction;
+  delete e;
+  delete q;
+  delete acting;
+  delete learner;
+  delete control;
+  delete agent;
+  delete sim;
+}
+
 void MountainCarTest::testGreedyGQOnPolicyMountainCar()
 {
   Random<double>* random = new Random<double>;
@@ -801,6 +964,9 @@ void MountainCarTest::run()
   testSarsaAdaptiveMountainCar2();
   testExpectedSarsaMountainCar();
   testQMountainCar();
+  testReplayQMountainCar();
+  testAnytimeQMountainCar();
+  testAnytimeDroppedTransitions();
 
   testGreedyGQMountainCar();
   testSoftmaxGQOnMountainCar();
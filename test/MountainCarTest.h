@@ -47,6 +47,9 @@ class MountainCarTest: public MountainCarTestBase
     void testSarsaAdaptiveMountainCar2();
     void testExpectedSarsaMountainCar();
     void testQMountainCar();
+    void testReplayQMountainCar();
+    void testAnytimeQMountainCar();
+    void testAnytimeDroppedTransitions();
     void testGreedyGQOnPolicyMountainCar();
     void testGreedyGQMountainCar();
     void testSoftmaxGQOnMountainCar();
@@ -62,4 +65,161 @@ class MountainCarTest: public MountainCarTestBase
     void testOnPolicyBoltzmannATraceNaturalActorCriticCar();
 };
 
+// Counts the calls to the projector
+template<typename T>
+class CountingProjector: public Projector<T>
+{
+  protected:
+    Projector<T>* projector;
+
+  public:
+    int nbProjections;
+
+    CountingProjector(Projector<T>* projector) :
+        projector(projector), nbProjections(0)
+    {
+    }
+
+    const Vector<T>* project(const Vector<T>* x, const int& h1)
+    {
+      ++nbProjections;
+      return projector->project(x, h1);
+    }
+
+    const Vector<T>* project(const Vector<T>* x)
+    {
+      ++nbProjections;
+      return projector->project(x);
+    }
+
+    T vectorNorm() const
+    {
+      return projector->vectorNorm();
+    }
+
+    int dimension() const
+    {
+      return projector->dimension();
+    }
+};
+
+// Episode lengths, from the returns of -1 per step
+class MountainCarLengthEvent: public RLRunner<double>::Event
+{
+  public:
+    mutable RunningStatistics<double> lengths;
+
+    void update() const
+    {
+      lengths.add(-episodeR);
+    }
+};
+
+// Counts the updates whose x_t is not the x_tp1 of the previous one, since initialize()
+template<typename T>
+class ContinuityCheckingControl: public OffPolicyControlLearner<T>
+{
+  protected:
+    OffPolicyControlLearner<T>* learner;
+    PVector<T>* x_tp1;
+    bool initialized;
+
+  public:
+    int nbInitializations;
+    int nbDiscontinuities;
+    int nbDeferred;
+
+    ContinuityCheckingControl(OffPolicyControlLearner<T>* learner, const int& nbVars) :
+        learner(learner), x_tp1(new PVector<T>(nbVars)), initialized(false), //
+        nbInitializations(0), nbDiscontinuities(0), nbDeferred(0)
+    {
+    }
+
+    virtual ~ContinuityCheckingControl()
+    {
+      delete x_tp1;
+    }
+
+    const Action<T>* initialize(const Vector<T>* x)
+    {
+      initialized = true;
+      ++nbInitializations;
+      return learner->initialize(x);
+    }
+
+    void learn(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1, const T& r_tp1,
+        const T& z_tp1)
+    {
+      if (!initialized)
+      {
+        for (int i = 0; i < x_t->dimension(); i++)
+        {
+          if (x_t->getEntry(i) != this->x_tp1->getEntry(i))
+          {
+            ++nbDiscontinuities;
+            break;
+          }
+        }
+      }
+      initialized = false;
+      if (!x_tp1->empty())
+        this->x_tp1->set(x_tp1);
+      learner->learn(x_t, a_t, x_tp1, r_tp1, z_tp1);
+    }
+
+    void learnDeferred(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1,
+        const T& r_tp1, const T& z_tp1, const T& pi_b_t)
+    {
+      ++nbDeferred;
+      learn(x_t, a_t, x_tp1, r_tp1, z_tp1);
+    }
+
+    const Action<T>* sampleAction(const Vector<T>* x_tp1)
+    {
+      return learner->sampleAction(x_tp1);
+    }
+
+    T behaviorProbability(const Action<T>* a) const
+    {
+      return learner->behaviorProbability(a);
+    }
+
+    void reset()
+    {
+      learner->reset();
+    }
+
+    const Action<T>* proposeAction(const Vector<T>* x)
+    {
+      return learner->proposeAction(x);
+    }
+
+    const Action<T>* step(const Vector<T>* x_t, const Action<T>* a_t, const Vector<T>* x_tp1,
+        const T& r_tp1, const T& z_tp1)
+    {
+      learn(x_t, a_t, x_tp1, r_tp1, z_tp1);
+      return sampleAction(x_tp1);
+    }
+
+    T computeValueFunction(const Vector<T>* x) const
+    {
+      return learner->computeValueFunction(x);
+    }
+
+    const Predictor<T>* predictor() const
+    {
+      return learner->predictor();
+    }
+
+    void persist(const char* f) const
+    {
+      learner->persist(f);
+    }
+
+    void resurrect(const char* f)
+    {
+      learner->resurrect(f);
+    }
+};
+
 #endif /* MOUNTAINCARTEST_H_ */
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * MultiAgentTest.cpp
+ */
+
+
+#include "MultiAgentTest.h"
+
+RLLIB_TEST_MAKE(MultiAgentTest)
+
+void MultiAgentTest::testBind()
+{
+  PVector<double> v(10);
+  for (int i = 0; i < v.dimension(); i++)
+    v[i] = i;
+  std::vector<double> storage(20, -1.0);
+  v.bind(&storage[5]);
+  Assert::assertPasses(!v.isOwner() && v.getValues() == &storage[5]);
+  Assert::assertPasses(storage[4] == -1.0 && storage[5] == 0.0 && storage[14] == 9.0);
+  Assert::assertPasses(storage[15] == -1.0);
+  static_cast<Vector<double>&>(v).addToSelf(1.0);
+  Assert::assertPasses(storage[5] == 1.0 && storage[14] == 10.0);
+  // Copies own their values
+  PVector<double> w(v);
+  Assert::assertPasses(w.isOwner() && w.getValues() != v.getValues() && w[9] == 10.0);
+  // Released vectors own their values again
+  v.release();
+  storage[14] = -1.0;
+  Assert::assertPasses(v.isOwner() && v.getValues() != &storage[5] && v[9] == 10.0);
+}
+
+void MultiAgentTest::testTeam()
+{
+  const int nbAgents = 11;
+  const int nbSteps = 2000;
+  std::vector<MultiAgentTeammate*> team, reference;
+  std::vector<RLAgent<double>*> agents;
+  std::vector<RLProblem<double>*> problems;
+  std::vector<Vector<double>*> weights;
+  MultiAgentPipeline pipeline;
+  TeamProjection<double> projection(pipeline.projector, pipeline.problem->getDiscreteActions(),
+      nbAgents);
+  for (int k = 0; k < nbAgents; k++)
+  {
+    team.push_back(new MultiAgentTeammate(k + 1, projection.at(k)));
+    reference.push_back(new MultiAgentTeammate(k + 1));
+    agents.push_back(team[k]->agent);
+    problems.push_back(team[k]->problem);
+    weights.push_back(team[k]->sarsa->weights());
+  }
+
+  {
+    MultiAgentRunner<double> runner(agents, problems, &projection, 5000, 4);
+    runner.pack(weights);
+    Assert::assertPasses(runner.getNbAgents() == nbAgents && runner.getNbWorkers() == 4);
+    for (int k = 0; k < nbAgents; k++)
+      Assert::assertPasses(runner.getWeights(k) == weights[k]->getValues());
+    Assert::assertPasses(runner.getWeights(1) - runner.getWeights(0) == weights[0]->dimension());
+
+    Timer timer;
+    timer.start();
+    for (int t = 0; t < nbSteps / 10; t++)
+      runner.step(10);
+    timer.stop();
+    const double teamTime = timer.getElapsedTimeInMilliSec();
+
+    // Each agent on its own pipeline gives the same weights
+    timer.start();
+    for (int k = 0; k < nbAgents; k++)
+    {
+      RLRunner<double> single(reference[k]->agent, reference[k]->problem, 5000);
+      single.setVerbose(false);
+      for (int t = 0; t < nbSteps; t++)
+        single.step();
+    }
+    timer.stop();
+    cout << "## " << nbAgents << " agents x " << nbSteps << " steps team(ms)=" << teamTime
+        << " sequential(ms)=" << timer.getElapsedTimeInMilliSec() << endl;
+
+    for (int k = 0; k < nbAgents; k++)
+    {
+      const Vector<double>* expected = reference[k]->sarsa->weights();
+      bool equal = true;
+      for (int i = 0; i < expected->dimension(); i++)
+        equal = equal && (expected->getEntry(i) == runner.getWeights(k)[i]);
+      Assert::assertPasses(equal);
+      Assert::assertPasses(expected->l1Norm() > 0);
+    }
+    // The agents differ by their seeds
+    Assert::assertPasses(weights[0]->l1Norm() != weights[1]->l1Norm());
+  }
+  // The agents keep their weights once the runner is deleted
+  for (int k = 0; k < nbAgents; k++)
+  {
+    const DenseVector<double>* w = RTTI<double>::denseVector(weights[k]);
+    Assert::assertPasses(w->isOwner());
+    Assert::assertPasses(w->l1Norm() == reference[k]->sarsa->weights()->l1Norm());
+  }
+
+  for (int k = 0; k < nbAgents; k++)
+  {
+    delete team[k];
+    delete reference[k];
+  }
+}
+
+void MultiAgentTest::testTeamTiming()
+{
+  const int nbAgents = 22;
+  const int nbSteps = 2000;
+  const int nbWorkers = std::max(1, int(std::thread::hardware_concurrency()));
+  MultiAgentPipeline pipeline;
+  TeamProjection<double> projection(pipeline.projector, pipeline.problem->getDiscreteActions(),
+      nbAgents);
+  std::vector<MultiAgentTeammate*> team, reference;
+  std::vector<RLAgent<double>*> agents;
+  std::vector<RLProblem<double>*> problems;
+  std::vector<Vector<double>*> weights;
+  for (int k = 0; k < nbAgents; k++)
+  {
+    team.push_back(new MultiAgentTeammate(k + 1, projection.at(k)));
+    reference.push_back(new MultiAgentTeammate(k + 1));
+    agents.push_back(team[k]->agent);
+    problems.push_back(team[k]->problem);
+    weights.push_back(team[k]->sarsa->weights());
+  }
+
+  Timer timer;
+  {
+    MultiAgentRunner<double> runner(agents, problems, &projection, 5000, nbWorkers);
+    runner.pack(weights);
+    timer.start();
+    runner.step(nbSteps);
+    timer.stop();
+  }
+  const double teamTime = timer.getElapsedTimeInMilliSec();
+  timer.start();
+  for (int k = 0; k < nbAgents; k++)
+  {
+    RLRunner<double> single(reference[k]->agent, reference[k]->problem, 5000);
+    single.setVerbose(false);
+    for (int t = 0; t < nbSteps; t++)
+      single.step();
+  }
+  timer.stop();
+  cout << "## " << nbAgents << " agents x " << nbSteps << " steps on " << nbWorkers
+      << " workers team(ms)=" << teamTime << " sequential(ms)=" << timer.getElapsedTimeInMilliSec()
+      << endl;
+  for (int k = 0; k < nbAgents; k++)
+    Assert::assertPasses(weights[k]->l1Norm() == reference[k]->sarsa->weights()->l1Norm());
+
+  for (int k = 0; k < nbAgents; k++)
+  {
+    delete team[k];
+    delete reference[k];
+  }
+}
+
+void MultiAgentTest::run()
+{
+  testBind();
+  testTeam();
+  testTeamTiming();
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * MultiAgentTest.h
+ */
+
+#ifndef MULTIAGENTTEST_H_
+#define MULTIAGENTTEST_H_
+
+#include "Test.h"
+#include "MultiAgent.h"
+#include "Timer.h"
+#include "ControlAlgorithm.h"
+
+RLLIB_TEST(MultiAgentTest)
+
+class MultiAgentTest: public MultiAgentTestBase
+{
+  public:
+    MultiAgentTest()
+    {
+    }
+
+    virtual ~MultiAgentTest()
+    {
+    }
+
+    void run();
+
+  private:
+    void testBind();
+    void testTeam();
+    void testTeamTiming();
+};
+
+// The features of the team: one hashing, one projector
+class MultiAgentPipeline
+{
+  public:
+    Random<double> hashingRandom;
+    RLProblem<double>* problem;
+    Hashing<double>* hashing;
+    Projector<double>* projector;
+
+    MultiAgentPipeline() :
+        hashingRandom(0), problem(new MountainCar<double>), //
+        hashing(new MurmurHashing<double>(&hashingRandom, 10000)), //
+        projector(new TileCoderHashing<double>(hashing, problem->dimension(), 10, 10, true))
+    {
+    }
+
+    ~MultiAgentPipeline()
+    {
+      delete projector;
+      delete hashing;
+      delete problem;
+    }
+};
+
+// Sarsa on MountainCar, on the features of the team or on a pipeline of its own
+class MultiAgentTeammate
+{
+  public:
+    Random<double> random;
+    RLProblem<double>* problem;
+    MultiAgentPipeline* pipeline;
+    StateToStateAction<double>* toStateAction;
+    bool ownsToStateAction;
+    Trace<double>* e;
+    Sarsa<double>* sarsa;
+    Policy<double>* acting;
+    OnPolicyControlLearner<double>* control;
+    RLAgent<double>* agent;
+
+    MultiAgentTeammate(const uint64_t& seed, StateToStateAction<double>* team = 0) :
+        random(seed), problem(new MountainCar<double>(&random)), //
+        pipeline(team ? 0 : new MultiAgentPipeline), //
+        toStateAction(
+            team ? team :
+                new StateActionTilings<double>(pipeline->projector,
+                    problem->getDiscreteActions())), ownsToStateAction(!team), //
+        e(new RTrace<double>(toStateAction->dimension())), //
+        sarsa(new Sarsa<double>(0.15 / toStateAction->vectorNorm(), 0.99, 0.3, e)), //
+        acting(new EpsilonGreedy<double>(&random, problem->getDiscreteActions(), sarsa, 0.01)), //
+        control(new SarsaControl<double>(acting, toStateAction, sarsa)), //
+        agent(new LearnerAgent<double>(control))
+    {
+    }
+
+    ~MultiAgentTeammate()
+    {
+      delete agent;
+      delete control;
+      delete acting;
+      delete sarsa;
+      delete e;
+      if (ownsToStateAction)
+        delete toStateAction;
+      if (pipeline)
+        delete pipeline;
+      delete problem;
+    }
+};
+
+#endif /* MULTIAGENTTEST_H_ */
@@ -34,7 +34,7 @@ OnOffPolicyPredictionTest::~OnOffPolicyPredictionTest()
 }
 
 void OnOffPolicyPredictionTest::testTD(FiniteStateGraph* problem, OnPolicyTDFactory* factory,
-    const double& lambda, const int& nbEpisodeMax)
+    const double& lambda, const int& nbEpisodeMax, const Vector<double>* solution)
 {
   Timer timer;
   timer.start();
@@ -45,7 +45,8 @@ void OnOffPolicyPredictionTest::testTD(FiniteStateGraph* problem, OnPolicyTDFact
   problem->initialize();
   OnPolicyTD<double>* td = factory->create(problem->gamma(), lambda, agentState->vectorNorm(),
       agentState->dimension());
-  const Vector<double>* solution = problem->expectedDiscountedSolution();
+  if (!solution)
+    solution = problem->expectedDiscountedSolution();
   while (FiniteStateGraph::distanceToSolution(solution, td->weights()) > factory->precision())
   {
     FiniteStateGraph::StepData stepData = agentState->step();
@@ -283,11 +284,297 @@ void OnOffPolicyPredictionTest::testOffPolicyWithLambda()
 
 }
 
+void OnOffPolicyPredictionTest::testExactSolutionTD()
+{
+  random->reseed(0);
+  onPolicyTDFactoryVector.push_back(new LSTDLambdaTest);
+  onPolicyTDFactoryVector.push_back(new ILSTDLambdaTest);
+  onPolicyTDFactoryVector.push_back(new LinearDynaTest);
+
+  // The least-squares and the model-based solutions converge to the exact fixed point, hence
+  // the random walk is checked against the computed solution rather than the rounded one
+  FSGAgentState agentState(randomWalkProblem);
+  Policy<double>* policy = randomWalkProblem->acting;
+  randomWalkProblem->setPolicy(policy);
+  for (std::vector<OnPolicyTDFactory*>::iterator iter = onPolicyTDFactoryVector.begin();
+      iter != onPolicyTDFactoryVector.end(); ++iter)
+  {
+    OnPolicyTDFactory* factory = *iter;
+    testTD(lineProblem, factory, 0, nbEpisodeMax());
+    for (int i = 0; i < factory->getLambdaVector()->dimension(); i++)
+    {
+      const double lambda = factory->getLambdaVector()->getEntry(i);
+      testTD(lineProblem, factory, lambda, nbEpisodeMax());
+      const PVector<double> solution = agentState.computeSolution(policy,
+          randomWalkProblem->gamma(), lambda);
+      testTD(randomWalkProblem, factory, lambda, nbEpisodeMax(), &solution);
+    }
+  }
+
+  clearTDFactories();
+}
+
+void OnOffPolicyPredictionTest::testOffPolicyHorde()
+{
+  random->reseed(0);
+  RandomWalk* problem = randomWalkProblem;
+  FSGAgentState* agentState = new FSGAgentState(problem);
+  const int nbFeatures = agentState->dimension();
+  const double gamma = problem->gamma();
+  const double lambda = 0.2;
+  const double alpha_v = 0.01 / agentState->vectorNorm();
+  const double alpha_w = 0.5 / agentState->vectorNorm();
+  const double targetLeftProbabilities[] = { 0.2, 0.7 };
+  const double scales[] = { 1.0, -2.0 };
+  enum
+  {
+    nbGroups = 2, nbDemons = 2
+  };
+
+  Policy<double>* behaviorPolicy = RandomWalk::newPolicy(random, problem->getActions(), 0.5);
+  problem->setPolicy(behaviorPolicy);
+  problem->initialize();
+
+  // Every demon of the Horde is mirrored by a separate GTD(lambda) learner
+  double r_tp1 = 0;
+  OffPolicyHorde<double> horde(behaviorPolicy);
+  std::vector<Policy<double>*> targetPolicies;
+  std::vector<Trace<double>*> traces;
+  std::vector<RewardFunction<double>*> rewards;
+  std::vector<OffPolicyTD<double>*> gtds;
+  for (int g = 0; g < nbGroups; g++)
+  {
+    targetPolicies.push_back(
+        RandomWalk::newPolicy(random, problem->getActions(), targetLeftProbabilities[g]));
+    traces.push_back(new AMaxTrace<double>(nbFeatures));
+    GTDLambdaGroup<double>* group = horde.addGroup(targetPolicies.back(), alpha_v, alpha_w, gamma,
+        lambda, traces.back());
+    for (int k = 0; k < nbDemons; k++)
+    {
+      rewards.push_back(new ScaledRewardFunction(&r_tp1, scales[k]));
+      group->addDemon(rewards.back());
+      traces.push_back(new AMaxTrace<double>(nbFeatures));
+      gtds.push_back(new GTDLambda<double>(alpha_v, alpha_w, gamma, lambda, traces.back()));
+    }
+  }
+  ASSERT(horde.nbDemons() == nbGroups * nbDemons);
+
+  Vector<double>* phi_t = new PVector<double>(nbFeatures);
+  Vector<double>* phi_tp1 = new PVector<double>(nbFeatures);
+  int nbEpisode = 0;
+  while (nbEpisode < 10000)
+  {
+    FiniteStateGraph::StepData stepData = agentState->step();
+    phi_tp1->set(agentState->currentFeatureState());
+    if (stepData.v_t()->empty())
+    {
+      horde.initialize();
+      for (size_t i = 0; i < gtds.size(); i++)
+        gtds[i]->initialize();
+    }
+    else
+    {
+      r_tp1 = stepData.r_tp1;
+      horde.update(0, stepData.a_t, phi_t, phi_tp1);
+      const double b_t = behaviorPolicy->pi(stepData.a_t);
+      for (int g = 0; g < nbGroups; g++)
+      {
+        const double rho_t = targetPolicies[g]->pi(stepData.a_t) / b_t;
+        ASSERT(std::abs(horde.getRho(g) - rho_t) < 1e-12);
+        for (int k = 0; k < nbDemons; k++)
+          gtds[g * nbDemons + k]->update(phi_t, phi_tp1, rho_t, scales[k] * r_tp1, 0.0);
+      }
+    }
+    if (stepData.s_tp1->v()->empty())
+      ++nbEpisode;
+    phi_t->set(phi_tp1);
+  }
+
+  PVector<double> weights(nbFeatures);
+  for (int g = 0; g < nbGroups; g++)
+  {
+    const PVector<double> solution = agentState->computeSolution(targetPolicies[g], gamma, lambda);
+    for (int k = 0; k < nbDemons; k++)
+    {
+      PVector<double> scaledSolution(nbFeatures);
+      scaledSolution.addToSelf(scales[k], &solution);
+      const Vector<double>* expected = gtds[g * nbDemons + k]->weights();
+      horde.at(g)->weights(k, &weights);
+      double maxDifference = 0;
+      for (int i = 0; i < nbFeatures; i++)
+        maxDifference = std::max(maxDifference,
+            std::abs(weights.getEntry(i) - expected->getEntry(i)));
+      ASSERT(maxDifference < 1e-10);
+      const double error = FiniteStateGraph::distanceToSolution(&scaledSolution, &weights)
+          / std::abs(scales[k]);
+      std::cout << "## group=" << g << " demon=" << k << " error=" << error << std::endl;
+      ASSERT(error < 0.05);
+    }
+  }
+
+  delete agentState;
+  delete behaviorPolicy;
+  delete phi_t;
+  delete phi_tp1;
+  for (size_t i = 0; i < targetPolicies.size(); i++)
+    delete targetPolicies[i];
+  for (size_t i = 0; i < traces.size(); i++)
+    delete traces[i];
+  for (size_t i = 0; i < rewards.size(); i++)
+    delete rewards[i];
+  for (size_t i = 0; i < gtds.size(); i++)
+    delete gtds[i];
+}
+
 int OnOffPolicyPredictionTest::nbEpisodeMax() const
 {
   return 100000;
 }
 
+// Binary features over disjoint stripes, or the projection of a random point
+static void nextFeatures(Random<double>* random, Projector<double>* projector, const int& nbTilings,
+    SVector<double>* x)
+{
+  if (projector)
+  {
+    PVector<double> input(2);
+    input[0] = random->nextReal();
+    input[1] = random->nextReal();
+    x->set(projector->project(&input));
+    return;
+  }
+  const int nbFeatures = x->dimension();
+  x->clear();
+  for (int i = 0; i < nbTilings; i++)
+    x->setEntry(i * (nbFeatures / nbTilings) + random->nextInt(nbFeatures / nbTilings), 1.0);
+}
+
+// The same stream of features, x_t the previous x_tp1, without then with the cache
+template<class L>
+void OnOffPolicyPredictionTest::testIncremental(const char* name, L* reference, L* incremental,
+    Projector<double>* projector)
+{
+  const int nbFeatures = reference->weights()->dimension();
+  const int nbTilings = 10;
+  SVector<double> x_t(nbFeatures), x_tp1(nbFeatures);
+  std::vector<double> deltas;
+  double elapsed[2];
+  for (int pass = 0; pass < 2; pass++)
+  {
+    L* learner = pass == 0 ? reference : incremental;
+    Random<double> streamRandom(0);
+    Timer timer;
+    timer.start();
+    int k = 0;
+    for (int episode = 0; episode < 20; episode++)
+    {
+      learner->initialize();
+      nextFeatures(&streamRandom, projector, nbTilings, &x_tp1);
+      for (int t = 0; t < 500; t++)
+      {
+        x_t.set(&x_tp1);
+        nextFeatures(&streamRandom, projector, nbTilings, &x_tp1);
+        const double delta = learner->update(&x_t, &x_tp1, streamRandom.nextGaussian(0, 1));
+        if (pass == 0)
+          deltas.push_back(delta);
+        else
+          Assert::assertPasses(std::abs(delta - deltas[k++]) < 1e-9);
+      }
+    }
+    timer.stop();
+    elapsed[pass] = timer.getElapsedTimeInMilliSec();
+  }
+  double difference = 0;
+  for (int i = 0; i < nbFeatures; i++)
+    difference = std::max(difference,
+        std::abs(reference->weights()->getEntry(i) - incremental->weights()->getEntry(i)));
+  cout << "## " << name << " max |w - w_incremental|=" << difference << " time(ms)=" << elapsed[0]
+      << " incremental(ms)=" << elapsed[1] << endl;
+  Assert::assertPasses(difference < 1e-9 && reference->weights()->l1Norm() > 0);
+}
+
+void OnOffPolicyPredictionTest::testIncrementalPrediction()
+{
+  const int nbFeatures = 1 << 16;
+  const double alpha = 0.1 / 10;
+  std::vector<Trace<double>*> traces;
+  for (int i = 0; i < 8; i++)
+    traces.push_back(new RTrace<double>(nbFeatures));
+
+  TDLambda<double> tdLambda(alpha, 0.99, 0.7, traces[0]), tdLambdaC(alpha, 0.99, 0.7, traces[1]);
+  tdLambdaC.setIncremental(true);
+  testIncremental<OnPolicyTD<double> >("TDLambda", &tdLambda, &tdLambdaC);
+
+  Sarsa<double> sarsa(alpha, 0.99, 0.7, traces[2]), sarsaC(alpha, 0.99, 0.7, traces[3]);
+  sarsaC.setIncremental(true);
+  testIncremental<Sarsa<double> >("Sarsa", &sarsa, &sarsaC);
+
+  // On-policy: phi_bar_tp1 is the next phi_t
+  GQ<double> gq(alpha, alpha / 10, 0.99, 0.7, traces[4]), //
+  gqC(alpha, alpha / 10, 0.99, 0.7, traces[5]);
+  gqC.setIncremental(true);
+  testIncremental<OnPolicyTD<double> >("GQ", &gq, &gqC);
+
+  GTDLambda<double> gtd(alpha, alpha / 10, 0.99, 0.7, traces[6]), //
+  gtdC(alpha, alpha / 10, 0.99, 0.7, traces[7]);
+  gtdC.setIncremental(true);
+  testIncremental<OnPolicyTD<double> >("GTDLambda", &gtd, &gtdC);
+
+  for (size_t i = 0; i < traces.size(); i++)
+    delete traces[i];
+}
+
+// A small hashing: the tilings collide, hence from 1 to nbTilings + 1 active features
+void OnOffPolicyPredictionTest::testIncrementalPredictionHashed()
+{
+  const int nbTilings = 10;
+  Random<double> hashingRandom(0);
+  UNH<double> hashing(&hashingRandom, 64);
+  TileCoderHashing<double> projector(&hashing, 2, 10, nbTilings, true);
+  const int nbFeatures = projector.dimension();
+
+  Random<double> random(1);
+  PVector<double> input(2);
+  int nbCollisions = 0;
+  for (int i = 0; i < 1000; i++)
+  {
+    input[0] = random.nextReal();
+    input[1] = random.nextReal();
+    const SparseVector<double>* x = RTTI<double>::constSparseVector(projector.project(&input));
+    Assert::assertPasses(x->nonZeroElements() <= nbTilings + 1);
+    if (x->nonZeroElements() < nbTilings + 1)
+      ++nbCollisions;
+  }
+  cout << "## collisions=" << nbCollisions << "/1000" << endl;
+  Assert::assertPasses(nbCollisions > 0);
+
+  const double alpha = 0.1 / (nbTilings + 1);
+  std::vector<Trace<double>*> traces;
+  for (int i = 0; i < 8; i++)
+    traces.push_back(new RTrace<double>(nbFeatures));
+
+  TDLambda<double> tdLambda(alpha, 0.99, 0.7, traces[0]), tdLambdaC(alpha, 0.99, 0.7, traces[1]);
+  tdLambdaC.setIncremental(true);
+  testIncremental<OnPolicyTD<double> >("hashed TDLambda", &tdLambda, &tdLambdaC, &projector);
+
+  Sarsa<double> sarsa(alpha, 0.99, 0.7, traces[2]), sarsaC(alpha, 0.99, 0.7, traces[3]);
+  sarsaC.setIncremental(true);
+  testIncremental<Sarsa<double> >("hashed Sarsa", &sarsa, &sarsaC, &projector);
+
+  GQ<double> gq(alpha, alpha / 10, 0.99, 0.7, traces[4]), //
+  gqC(alpha, alpha / 10, 0.99, 0.7, traces[5]);
+  gqC.setIncremental(true);
+  testIncremental<OnPolicyTD<double> >("hashed GQ", &gq, &gqC, &projector);
+
+  GTDLambda<double> gtd(alpha, alpha / 10, 0.99, 0.7, traces[6]), //
+  gtdC(alpha, alpha / 10, 0.99, 0.7, traces[7]);
+  gtdC.setIncremental(true);
+  testIncremental<OnPolicyTD<double> >("hashed GTDLambda", &gtd, &gtdC, &projector);
+
+  for (size_t i = 0; i < traces.size(); i++)
+    delete traces[i];
+}
+
 void OnOffPolicyPredictionTest::run()
 {
   testOnLineProblem();
@@ -297,6 +584,10 @@ void OnOffPolicyPredictionTest::run()
   testOffPolicy();
   testOffPolicyWithLambda();
   testOnRandomWalk2Problem();
+  testExactSolutionTD();
+  testOffPolicyHorde();
+  testIncrementalPrediction();
+  testIncrementalPredictionHashed();
 }
 
 RLLIB_TEST_MAKE(OnOffPolicyPredictionTest)
@@ -9,6 +9,8 @@
 #define ONOFFPOLICYPREDICTIONTEST_H_
 
 #include "Test.h"
+#include "Horde.h"
+#include "Timer.h"
 //
 #include "StateGraph.h"
 
@@ -93,7 +95,7 @@ class OnOffPolicyPredictionTest: public OnOffPolicyPredictionTestBase
 
   protected:
     void testTD(FiniteStateGraph* graph, OnPolicyTDFactory* factory, const double& lambda,
-        const int& nbEpisodeMax);
+        const int& nbEpisodeMax, const Vector<double>* solution = 0);
 
     void testOffPolicyGTD(RandomWalk* problem, OffPolicyTDFactory* factory, const double& lambda,
         const int& nbEpisodeMax, const double& targetLeftProbability,
@@ -109,6 +111,12 @@ class OnOffPolicyPredictionTest: public OnOffPolicyPredictionTestBase
     void testOffPolicy();
     void testOffPolicyWithLambda();
     void testOnRandomWalk2Problem();
+    void testExactSolutionTD();
+    void testOffPolicyHorde();
+    template<class L> void testIncremental(const char* name, L* reference, L* incremental,
+        Projector<double>* projector = 0);
+    void testIncrementalPrediction();
+    void testIncrementalPredictionHashed();
     int nbEpisodeMax() const;
 
   public:
@@ -193,6 +201,89 @@ class TDLambdaAlphaBoundTest: public OnPolicyTDFactory
     }
 };
 
+class LSTDLambdaTest: public OnPolicyTDFactory
+{
+  public:
+    OnPolicyTD<double>* create(const double& gamma, const double& lambda, const double& vectorNorm,
+        const int& vectorSize)
+    {
+      Trace<double>* newTrace = new ATrace<double>(vectorSize);
+      OnPolicyTD<double>* newOnPolicyTD = new LSTDLambda<double>(gamma, lambda, newTrace);
+      newTraces.push_back(newTrace);
+      newOnPolicyTDs.push_back(newOnPolicyTD);
+      return newOnPolicyTD;
+    }
+
+    const Vector<double>* getLambdaVector()
+    {
+      Vector<double>* vec = createLambdaVector(2);
+      vec->setEntry(0, 0.5);
+      vec->setEntry(1, 1.0);
+      return vec;
+    }
+
+    double precision()
+    {
+      return 0.01;
+    }
+};
+
+class ILSTDLambdaTest: public OnPolicyTDFactory
+{
+  public:
+    OnPolicyTD<double>* create(const double& gamma, const double& lambda, const double& vectorNorm,
+        const int& vectorSize)
+    {
+      Trace<double>* newTrace = new ATrace<double>(vectorSize);
+      OnPolicyTD<double>* newOnPolicyTD = new ILSTDLambda<double>(1.0 / vectorNorm, gamma, lambda,
+          newTrace, 2);
+      newTraces.push_back(newTrace);
+      newOnPolicyTDs.push_back(newOnPolicyTD);
+      return newOnPolicyTD;
+    }
+
+    const Vector<double>* getLambdaVector()
+    {
+      Vector<double>* vec = createLambdaVector(2);
+      vec->setEntry(0, 0.5);
+      vec->setEntry(1, 1.0);
+      return vec;
+    }
+
+    double precision()
+    {
+      return 0.01;
+    }
+};
+
+class LinearDynaTest: public OnPolicyTDFactory
+{
+  public:
+    OnPolicyTD<double>* create(const double& gamma, const double& lambda, const double& vectorNorm,
+        const int& vectorSize)
+    {
+      Trace<double>* newTrace = new ATrace<double>(vectorSize);
+      OnPolicyTD<double>* newOnPolicyTD = new LinearDyna<double>(0.1 / vectorNorm,
+          0.1 / vectorNorm, gamma, lambda, newTrace, 10);
+      newTraces.push_back(newTrace);
+      newOnPolicyTDs.push_back(newOnPolicyTD);
+      return newOnPolicyTD;
+    }
+
+    const Vector<double>* getLambdaVector()
+    {
+      Vector<double>* vec = createLambdaVector(2);
+      vec->setEntry(0, 0.5);
+      vec->setEntry(1, 1.0);
+      return vec;
+    }
+
+    double precision()
+    {
+      return 0.01;
+    }
+};
+
 class TDLambdaTrueTest: public OnPolicyTDFactory
 {
   public:
@@ -260,6 +351,25 @@ class TDLambdaTrueTest2: public OnPolicyTDFactory
     }
 };
 
+// Cumulant of a demon: the reward of the last step, scaled
+class ScaledRewardFunction: public RewardFunction<double>
+{
+  protected:
+    const double* r_tp1;
+    double scale;
+
+  public:
+    ScaledRewardFunction(const double* r_tp1, const double& scale) :
+        r_tp1(r_tp1), scale(scale)
+    {
+    }
+
+    double reward()
+    {
+      return scale * (*r_tp1);
+    }
+};
+
 class GTDLambdaTest: public OffPolicyTDFactory
 {
   public:
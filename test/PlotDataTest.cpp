@@ -0,0 +1,152 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * PlotDataTest.cpp
+ */
+
+#include "PlotDataTest.h"
+
+#include <stdint.h>
+
+RLLIB_TEST_MAKE(PlotDataTest)
+
+using namespace RLLibViz;
+
+// A slow sine with a spike every 997 points, which the decimation must not lose
+static double signal(const int& i)
+{
+  return std::sin(i * 1e-3) + (i % 997 == 0 ? (i % 2 ? 10.0 : -10.0) : 0.0);
+}
+
+void PlotDataTest::testBoundedColumns()
+{
+  PlotData data(2, 64, 4, 6);
+  const int nbColumns = 50;
+  std::vector<double> xs;
+  std::vector<std::vector<double> > ys;
+  for (int i = 0; i < 100000; i++)
+  {
+    data.add(i, signal(i), i);
+    const int n = i + 1;
+    if (n % 1000 != 0 && n != 10 && n != 50)
+      continue;
+    data.decimate(nbColumns, xs, ys);
+    // At most the min and the max of each column
+    Assert::assertPasses(int(xs.size()) <= 2 * nbColumns);
+    Assert::assertPasses(ys.size() == 2 && ys[0].size() == xs.size() && ys[1].size() == xs.size());
+    // Fewer points than columns: the raw points
+    if (n <= nbColumns)
+      Assert::assertPasses(int(xs.size()) == n && xs.back() == i);
+  }
+  Assert::assertPasses(data.getNbPoints() == 100000);
+}
+
+void PlotDataTest::testMinMaxAcrossLevels()
+{
+  // The coarsest level spans 64 * 4^5 points, hence the whole history below
+  PlotData data(2, 64, 4, 6);
+  std::vector<double> xs;
+  std::vector<std::vector<double> > ys;
+  double yMin = signal(0), yMax = signal(0);
+  int lastLevel = -1;
+  const int checkpoints[] = { 60, 200, 1000, 4000, 16000, 60000 };
+  int i = 0;
+  for (int c = 0; c < 6; c++)
+  {
+    for (; i < checkpoints[c]; i++)
+    {
+      data.add(i, signal(i), -i);
+      yMin = std::min(yMin, signal(i));
+      yMax = std::max(yMax, signal(i));
+    }
+    const int level = data.decimate(40, xs, ys);
+    std::cout << "## points=" << i << " level=" << level << " size=" << xs.size() << std::endl;
+    // Each checkpoint needs a coarser level than the previous one
+    Assert::assertPasses(level > lastLevel);
+    lastLevel = level;
+    Assert::assertPasses(*std::min_element(ys[0].begin(), ys[0].end()) == yMin);
+    Assert::assertPasses(*std::max_element(ys[0].begin(), ys[0].end()) == yMax);
+    Assert::assertPasses(*std::min_element(ys[1].begin(), ys[1].end()) == -(i - 1));
+    Assert::assertPasses(*std::max_element(ys[1].begin(), ys[1].end()) == 0);
+  }
+}
+
+void PlotDataTest::testRingWrapAround()
+{
+  // A single level: the last 16 points, oldest first
+  PlotData ring(1, 16, 2, 1);
+  std::vector<double> xs;
+  std::vector<std::vector<double> > ys;
+  for (int i = 0; i < 40; i++)
+  {
+    const double y = 2.0 * i;
+    ring.add(i, &y);
+  }
+  Assert::assertPasses(ring.decimate(100, xs, ys) == 0);
+  Assert::assertPasses(xs.size() == 16);
+  for (int j = 0; j < 16; j++)
+    Assert::assertPasses(xs[j] == 24 + j && ys[0][j] == 2.0 * (24 + j));
+
+  // Every level wrapped: the coarsest one holds the last 64 points, oldest first, and the latest
+  // points come from the pending buckets below it
+  PlotData levels(1, 16, 2, 3);
+  for (int i = 0; i < 1001; i++)
+  {
+    const double y = i;
+    levels.add(i, &y);
+  }
+  Assert::assertPasses(levels.decimate(100, xs, ys) == 2);
+  for (size_t j = 1; j < xs.size(); j++)
+    Assert::assertPasses(xs[j] >= xs[j - 1]);
+  Assert::assertPasses(xs.back() == 1000 && ys[0].back() == 1000);
+  Assert::assertPasses(xs.front() >= 1000 - 64 && xs.front() < 1000 - 60);
+}
+
+void PlotDataTest::testSpill()
+{
+  const char* f = "visualization/plotDataSpill.bin";
+  PlotData data(2, 16, 2, 2);
+  Assert::assertPasses(data.spill(f));
+  for (int i = 0; i < 1000; i++)
+    data.add(0.5 * i, signal(i), -i);
+  data.closeSpill();
+  // Not spilled
+  data.add(1000, 0.0, 0.0);
+
+  std::ifstream in(f, std::ios::binary);
+  int32_t nbSeries = 0;
+  in.read(reinterpret_cast<char*>(&nbSeries), sizeof(nbSeries));
+  Assert::assertPasses(in.good() && nbSeries == 2);
+  for (int i = 0; i < 1000; i++)
+  {
+    double point[3];
+    in.read(reinterpret_cast<char*>(point), sizeof(point));
+    Assert::assertPasses(in.good());
+    Assert::assertPasses(point[0] == 0.5 * i && point[1] == signal(i) && point[2] == -i);
+  }
+  char extra;
+  in.read(&extra, 1);
+  Assert::assertPasses(in.eof());
+  in.close();
+  std::remove(f);
+}
+
+void PlotDataTest::run()
+{
+  testBoundedColumns();
+  testMinMaxAcrossLevels();
+  testRingWrapAround();
+  testSpill();
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * PlotDataTest.h
+ */
+
+#ifndef PLOTDATATEST_H_
+#define PLOTDATATEST_H_
+
+#include "Test.h"
+
+// From the visualization; PlotData does not depend on Qt
+#include "visualization/RLLibViz/PlotData.h"
+
+RLLIB_TEST(PlotDataTest)
+
+class PlotDataTest: public PlotDataTestBase
+{
+  public:
+    PlotDataTest()
+    {
+    }
+
+    virtual ~PlotDataTest()
+    {
+    }
+
+    void run();
+
+  private:
+    void testBoundedColumns();
+    void testMinMaxAcrossLevels();
+    void testRingWrapAround();
+    void testSpill();
+};
+
+#endif /* PLOTDATATEST_H_ */
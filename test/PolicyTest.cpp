@@ -0,0 +1,336 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * PolicyTest.cpp
+ */
+
+#include "PolicyTest.h"
+
+void PolicyTest::fillDistribution(Random<double>* random, double* distribution, const int& size)
+{
+  double sum = 0;
+  for (int i = 0; i < size; i++)
+  {
+    distribution[i] = random->nextReal();
+    sum += distribution[i];
+  }
+  for (int i = 0; i < size; i++)
+    distribution[i] /= sum;
+}
+
+// The sampling previously used by the stochastic policies
+int PolicyTest::linearSample(const double* distribution, const int& size, const double& rand)
+{
+  double sum = 0;
+  for (int i = 0; i < size; i++)
+  {
+    sum += distribution[i];
+    if (sum >= rand)
+      return i;
+  }
+  return size - 1;
+}
+
+int PolicyTest::linearArgmax(const double* values, const int& size)
+{
+  int best = 0;
+  for (int i = 1; i < size; i++)
+  {
+    if (values[i] > values[best])
+      best = i;
+  }
+  return best;
+}
+
+void PolicyTest::fillFeatures(Random<double>* random, Vector<double>* phi, const int& nbActive)
+{
+  phi->clear();
+  for (int i = 0; i < nbActive; i++)
+    phi->setEntry(random->nextInt(phi->dimension()), 1.0);
+}
+
+double PolicyTest::maxDifference(const Vector<double>* a, const Vector<double>* b)
+{
+  double result = 0;
+  for (int i = 0; i < a->dimension(); i++)
+    result = std::max(result, std::abs(a->getEntry(i) - b->getEntry(i)));
+  return result;
+}
+
+void PolicyTest::testCumulativeTable()
+{
+  Random<double> random;
+  const int sizes[] = { 1, 2, 3, 7, 64, 1000 };
+  for (unsigned int k = 0; k < Arrays::length(sizes); k++)
+  {
+    const int size = sizes[k];
+    double* distribution = new double[size];
+    fillDistribution(&random, distribution, size);
+    CumulativeTable<double> table(size);
+    table.update(distribution);
+    for (int i = 0; i < 10000; i++)
+    {
+      const double rand = random.nextReal();
+      Assert::assertObjectEquals(linearSample(distribution, size, rand), table.sample(rand));
+    }
+    Assert::assertObjectEquals(0, table.sample(0.0));
+    Assert::assertObjectEquals(size - 1, table.sample(1.0 + 1e-3));
+    delete[] distribution;
+  }
+}
+
+void PolicyTest::testAliasTable()
+{
+  Random<double> random;
+  const int size = 13;
+  double distribution[size];
+  fillDistribution(&random, distribution, size);
+  distribution[5] = 0; // never sampled
+  double sum = 0;
+  for (int i = 0; i < size; i++)
+    sum += distribution[i];
+  AliasTable<double> table(size);
+  table.update(distribution);
+
+  int counts[size] = { 0 };
+  const int nbSamples = 1000000;
+  for (int i = 0; i < nbSamples; i++)
+    ++counts[table.sample(&random)];
+
+  for (int i = 0; i < size; i++)
+  {
+    const double frequency = double(counts[i]) / nbSamples;
+    std::cout << "a=" << i << " p=" << distribution[i] / sum << " f=" << frequency << std::endl;
+    Assert::assertObjectEquals(distribution[i] / sum, frequency, 5e-3);
+  }
+  Assert::assertObjectEquals(0, counts[5]);
+
+  // Policy level
+  ActionArray<double> actions(size);
+  PVector<double> pvector(size);
+  for (int i = 0; i < size; i++)
+    pvector[i] = distribution[i] / sum;
+  ConstantPolicy<double> policy(&random, &actions, &pvector);
+  policy.setEnableAliasSampling(true);
+  std::fill(counts, counts + size, 0);
+  for (int i = 0; i < nbSamples; i++)
+    ++counts[policy.sampleAction()->id()];
+  for (int i = 0; i < size; i++)
+    Assert::assertObjectEquals(pvector[i], double(counts[i]) / nbSamples, 5e-3);
+}
+
+void PolicyTest::testArgmax()
+{
+  Random<double> random;
+  for (int size = 1; size < 67; size++)
+  {
+    double* values = new double[size];
+    float* fvalues = new float[size];
+    for (int k = 0; k < 100; k++)
+    {
+      for (int i = 0; i < size; i++)
+      {
+        // Few distinct values to exercise the ties
+        values[i] = double(random.nextInt(10)) - 5.0;
+        fvalues[i] = float(values[i]);
+      }
+      const int expected = linearArgmax(values, size);
+      Assert::assertObjectEquals(expected, ActionValues::argmax(values, size));
+      Assert::assertObjectEquals(expected, ActionValues::argmax(fvalues, size));
+    }
+    delete[] values;
+    delete[] fvalues;
+  }
+}
+
+void PolicyTest::testSamplingBenchmark()
+{
+  Random<double> random;
+  Timer timer;
+  const int nbSamples = 200000;
+  std::cout << "## nbActions linear(ns) cumulative(ns) alias(ns) argmax_linear(ns) argmax(ns)"
+      << std::endl;
+  for (int size = 2; size <= 4096; size *= 2)
+  {
+    double* distribution = new double[size];
+    fillDistribution(&random, distribution, size);
+    CumulativeTable<double> cumulativeTable(size);
+    cumulativeTable.update(distribution);
+    AliasTable<double> aliasTable(size);
+    aliasTable.update(distribution);
+    int checksum = 0;
+
+    timer.start();
+    for (int i = 0; i < nbSamples; i++)
+      checksum += linearSample(distribution, size, random.nextReal());
+    timer.stop();
+    const double linearTime = timer.getElapsedTimeInMicroSec() * 1000.0 / nbSamples;
+
+    timer.start();
+    for (int i = 0; i < nbSamples; i++)
+      checksum += cumulativeTable.sample(&random);
+    timer.stop();
+    const double cumulativeTime = timer.getElapsedTimeInMicroSec() * 1000.0 / nbSamples;
+
+    timer.start();
+    for (int i = 0; i < nbSamples; i++)
+      checksum += aliasTable.sample(&random);
+    timer.stop();
+    const double aliasTime = timer.getElapsedTimeInMicroSec() * 1000.0 / nbSamples;
+
+    const int nbArgmax = std::max(nbSamples / size, 100);
+    timer.start();
+    for (int i = 0; i < nbArgmax; i++)
+    {
+      distribution[i % size] += 1e-12; // defeats loop invariant code motion
+      checksum += linearArgmax(distribution, size);
+    }
+    timer.stop();
+    const double linearArgmaxTime = timer.getElapsedTimeInMicroSec() * 1000.0 / nbArgmax;
+
+    timer.start();
+    for (int i = 0; i < nbArgmax; i++)
+    {
+      distribution[i % size] += 1e-12;
+      checksum += ActionValues::argmax(distribution, size);
+    }
+    timer.stop();
+    const double argmaxTime = timer.getElapsedTimeInMicroSec() * 1000.0 / nbArgmax;
+
+    std::cout << size << " " << linearTime << " " << cumulativeTime << " " << aliasTime << " "
+        << linearArgmaxTime << " " << argmaxTime << " (" << checksum << ")" << std::endl;
+    delete[] distribution;
+  }
+}
+
+// The fused kernels must match the updates done through computeGradLog()
+void PolicyTest::testActorKernels()
+{
+  Random<double> random;
+  const int nbFeatures = 50;
+  const double lambda = 0.9;
+
+  ActionArray<double> continuousActions(1);
+  continuousActions.push_back(0, 0.0);
+  NormalDistribution<double> normal(&random, &continuousActions, 0.0, 1.0, nbFeatures);
+  Representations<double> continuousPhis(nbFeatures, &continuousActions);
+  PVector<double> uMean(nbFeatures), uStddev(nbFeatures), uMeanRef(nbFeatures),
+      uStddevRef(nbFeatures);
+  Vectors<double> u;
+  u.push_back(&uMean);
+  u.push_back(&uStddev);
+  ATrace<double> eMean(nbFeatures), eStddev(nbFeatures), eMeanRef(nbFeatures),
+      eStddevRef(nbFeatures);
+  Traces<double> e;
+  e.push_back(&eMean);
+  e.push_back(&eStddev);
+
+  ActionArray<double> discreteActions(3);
+  BoltzmannDistribution<double> boltzmann(&random, &discreteActions, nbFeatures);
+  Representations<double> discretePhis(nbFeatures, &discreteActions);
+  PVector<double> uBoltzmann(nbFeatures), uBoltzmannRef(nbFeatures);
+  Vectors<double> v;
+  v.push_back(&uBoltzmann);
+
+  for (int t = 0; t < 200; t++)
+  {
+    const double factor = random.nextReal() - 0.5;
+
+    const Action<double>* a = continuousActions.getEntry(0);
+    fillFeatures(&random, continuousPhis.at(a), 5);
+    normal.update(&continuousPhis);
+    continuousActions.update(0, 0, random.nextNormalGaussian());
+    normal.addGradLog(&continuousPhis, a, factor, &u);
+    normal.updateTraces(&continuousPhis, a, lambda, &e);
+    const Vectors<double>* gradLog = normal.computeGradLog(&continuousPhis, a);
+    uMeanRef.addToSelf(factor, gradLog->getEntry(0));
+    uStddevRef.addToSelf(factor, gradLog->getEntry(1));
+    eMeanRef.update(lambda, gradLog->getEntry(0));
+    eStddevRef.update(lambda, gradLog->getEntry(1));
+
+    for (int i = 0; i < discreteActions.dimension(); i++)
+      fillFeatures(&random, discretePhis.at(discreteActions.getEntry(i)), 5);
+    boltzmann.update(&discretePhis);
+    const Action<double>* b = discreteActions.getEntry(random.nextInt(discreteActions.dimension()));
+    boltzmann.addGradLog(&discretePhis, b, factor, &v);
+    uBoltzmannRef.addToSelf(factor, boltzmann.computeGradLog(&discretePhis, b)->getEntry(0));
+  }
+
+  ASSERT(maxDifference(&uMean, &uMeanRef) < 1e-10);
+  ASSERT(maxDifference(&uStddev, &uStddevRef) < 1e-10);
+  ASSERT(maxDifference(eMean.vect(), eMeanRef.vect()) < 1e-10);
+  ASSERT(maxDifference(eStddev.vect(), eStddevRef.vect()) < 1e-10);
+  ASSERT(maxDifference(&uBoltzmann, &uBoltzmannRef) < 1e-10);
+}
+
+// The lazy natural gradient step must match u += alpha_u * w applied at every step
+void PolicyTest::testNaturalActorLazyUpdate()
+{
+  Random<double> random;
+  const int nbFeatures = 200;
+  const double alpha_u = 0.001;
+  const double alpha_v = 0.01;
+
+  ActionArray<double> actions(1);
+  actions.push_back(0, 0.0);
+  const Action<double>* a = actions.getEntry(0);
+  NormalDistribution<double> policy(&random, &actions, 0.0, 1.0, nbFeatures);
+  NormalDistribution<double> policyRef(&random, &actions, 0.0, 1.0, nbFeatures);
+  ActorNatural<double> actor(alpha_u, alpha_v, &policy);
+  actor.initialize();
+  Representations<double> phis(nbFeatures, &actions);
+  Vectors<double>* u = policy.parameters();
+  Vectors<double>* uRef = policyRef.parameters();
+  SVector<double> wMean(nbFeatures), wStddev(nbFeatures);
+  Vectors<double> w;
+  w.push_back(&wMean);
+  w.push_back(&wStddev);
+
+  for (int t = 0; t < 1000; t++)
+  {
+    fillFeatures(&random, phis.at(a), 4);
+    actor.updatePolicy(&phis);
+    policyRef.update(&phis);
+    policyRef.sampleAction();
+    const double delta = random.nextReal() - 0.5;
+    actor.update(&phis, a, delta);
+
+    const Vectors<double>* gradLog = policyRef.computeGradLog(&phis, a);
+    double advantageValue = 0;
+    for (int i = 0; i < w.dimension(); i++)
+      advantageValue += gradLog->getEntry(i)->dot(w.getEntry(i));
+    for (int i = 0; i < w.dimension(); i++)
+    {
+      w.getEntry(i)->addToSelf(alpha_v * (delta - advantageValue), gradLog->getEntry(i));
+      uRef->getEntry(i)->addToSelf(alpha_u, w.getEntry(i));
+    }
+  }
+
+  actor.flush();
+  for (int i = 0; i < u->dimension(); i++)
+    ASSERT(maxDifference(u->getEntry(i), uRef->getEntry(i)) < 1e-8);
+}
+
+void PolicyTest::run()
+{
+  testCumulativeTable();
+  testAliasTable();
+  testArgmax();
+  testSamplingBenchmark();
+  testActorKernels();
+  testNaturalActorLazyUpdate();
+}
+
+RLLIB_TEST_MAKE(PolicyTest)
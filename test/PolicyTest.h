@@ -0,0 +1,56 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * PolicyTest.h
+ */
+
+#ifndef POLICYTEST_H_
+#define POLICYTEST_H_
+
+#include "Test.h"
+#include "Policy.h"
+#include "Timer.h"
+
+RLLIB_TEST(PolicyTest)
+
+class PolicyTest: public PolicyTestBase
+{
+  public:
+    PolicyTest()
+    {
+    }
+
+    virtual ~PolicyTest()
+    {
+    }
+
+    void run();
+
+  private:
+    void fillDistribution(Random<double>* random, double* distribution, const int& size);
+    int linearSample(const double* distribution, const int& size, const double& rand);
+    int linearArgmax(const double* values, const int& size);
+    void fillFeatures(Random<double>* random, Vector<double>* phi, const int& nbActive);
+    double maxDifference(const Vector<double>* a, const Vector<double>* b);
+
+    void testCumulativeTable();
+    void testAliasTable();
+    void testArgmax();
+    void testSamplingBenchmark();
+    void testActorKernels();
+    void testNaturalActorLazyUpdate();
+};
+
+#endif /* POLICYTEST_H_ */
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * QuantizationTest.cpp
+ */
+
+#include "QuantizationTest.h"
+
+RLLIB_TEST_MAKE(QuantizationTest)
+
+void QuantizationTest::testQuantizedVector()
+{
+  Random<double> random(0);
+  PVector<double> v(1000);
+  for (int i = 0; i < v.dimension(); i++)
+    v[i] = (i < 64) ? 0.0 : random.nextGaussian(0.0, i < 500 ? 1.0 : 100.0);
+  QuantizedVector<double, int8_t> q8(&v);
+  QuantizedVector<double, int16_t> q16(&v, 50); // 64
+  Assert::assertPasses(q8.dimension() == 1000 && q8.getEntry(10) == 0.0);
+  Assert::assertPasses(q8.bytes() == 1000 + 16 * sizeof(double));
+  Assert::assertPasses(q16.bytes() == 2000 + 16 * sizeof(double));
+  // Half a step of the block at most
+  for (int i = 0; i < v.dimension(); i++)
+  {
+    double maxAbs = 0;
+    for (int j = (i / 64) * 64; j < std::min(1000, (i / 64 + 1) * 64); j++)
+      maxAbs = std::max(maxAbs, std::abs(v[j]));
+    Assert::assertPasses(std::abs(v[i] - q8.getEntry(i)) <= 0.5 * maxAbs / 127.0 + 1e-12);
+    Assert::assertPasses(std::abs(v[i] - q16.getEntry(i)) <= 0.5 * maxAbs / 32767.0 + 1e-12);
+  }
+  Assert::assertPasses(q16.getMaxError() < q8.getMaxError());
+
+  SVector<double> x(1000);
+  PVector<double> dense(1000);
+  for (int k = 0; k < 20; k++)
+  {
+    const int i = random.nextInt(1000);
+    x.setEntry(i, 1.0 + k);
+    dense[i] = 1.0 + k;
+  }
+  PVector<double> dequantized(1000);
+  q8.dequantize(&dequantized);
+  Assert::assertPasses(std::abs(q8.dot(&x) - dequantized.dot(&x)) < 1e-9);
+  Assert::assertPasses(std::abs(q8.dot(&x) - q8.dot(&dense)) < 1e-9);
+  Assert::assertPasses(std::abs(q16.dot(&x) - v.dot(&x)) < std::abs(q8.dot(&x) - v.dot(&x)) + 1e-9);
+
+  // Round trip, in vectors of another size and block size
+  const char* f = "visualization/quantizedVector.bin";
+  PVector<double> other(10);
+  QuantizedVector<double, int8_t> r8(&other, 4);
+  q8.persist(f);
+  r8.resurrect(f);
+  QuantizedVector<double, int16_t> r16(&other, 4);
+  q16.persist(f);
+  r16.resurrect(f);
+  std::remove(f);
+  Assert::assertPasses(r8.dimension() == 1000 && r16.dimension() == 1000);
+  Assert::assertPasses(r8.bytes() == q8.bytes() && r16.bytes() == q16.bytes());
+  Assert::assertPasses(r8.getMaxError() == q8.getMaxError());
+  Assert::assertPasses(r16.getMaxError() == q16.getMaxError());
+  for (int i = 0; i < v.dimension(); i++)
+    Assert::assertPasses(r8.getEntry(i) == q8.getEntry(i) && r16.getEntry(i) == q16.getEntry(i));
+}
+
+template<class P>
+double QuantizationTest::evaluate(Control<double>* control, const int& nbEpisodes)
+{
+  Random<double> random(7);
+  RLProblem<double>* problem = new P(&random);
+  RLAgent<double>* agent = new ControlAgent<double>(control);
+  RLRunner<double>* sim = new RLRunner<double>(agent, problem, 1000, nbEpisodes, 1);
+  sim->setVerbose(false);
+  QuantizationReturnEvent event;
+  sim->onEpisodeEnd.push_back(&event);
+  sim->run();
+  delete sim;
+  delete agent;
+  delete problem;
+  return event.returns.mean();
+}
+
+template<class P>
+void QuantizationTest::testQuantizedControl(const char* name, const int& gridResolution)
+{
+  Random<double> random(0);
+  RLProblem<double>* problem = new P(&random);
+  Hashing<double>* hashing = new MurmurHashing<double>(&random, 100000);
+  Projector<double>* projector = new TileCoderHashing<double>(hashing, problem->dimension(),
+      gridResolution, 10, true);
+  StateToStateAction<double>* toStateAction = new StateActionTilings<double>(projector,
+      problem->getDiscreteActions());
+  Trace<double>* e = new RTrace<double>(projector->dimension());
+  Sarsa<double>* sarsa = new Sarsa<double>(0.15 / projector->vectorNorm(), 0.99, 0.3, e);
+  Policy<double>* acting = new EpsilonGreedy<double>(&random, problem->getDiscreteActions(),
+      sarsa, 0.01);
+  OnPolicyControlLearner<double>* control = new SarsaControl<double>(acting, toStateAction,
+      sarsa);
+  RLAgent<double>* agent = new LearnerAgent<double>(control);
+  RLRunner<double>* sim = new RLRunner<double>(agent, problem, 5000, 50, 1);
+  sim->setVerbose(false);
+  sim->run();
+
+  // Deployed: greedy, without learning
+  QuantizedPredictor<double, int8_t> q8(sarsa);
+  QuantizedPredictor<double, int16_t> q16(sarsa);
+  GreedyControl<double> reference(problem->getDiscreteActions(), toStateAction, sarsa);
+  GreedyControl<double> control8(problem->getDiscreteActions(), toStateAction, &q8);
+  GreedyControl<double> control16(problem->getDiscreteActions(), toStateAction, &q16);
+  Assert::assertPasses(control8.predictor() == &q8);
+
+  QuantizationAgreementAgent agreement8(&reference, &control8);
+  QuantizationAgreementAgent agreement16(&reference, &control16);
+  for (int k = 0; k < 2; k++)
+  {
+    Random<double> evaluationRandom(7);
+    RLProblem<double>* evaluationProblem = new P(&evaluationRandom);
+    RLRunner<double> evaluation(k == 0 ? &agreement8 : &agreement16, evaluationProblem, 1000, 10,
+        1);
+    evaluation.setVerbose(false);
+    evaluation.run();
+    delete evaluationProblem;
+  }
+  const double rate8 = double(agreement8.nbAgreements) / agreement8.nbSteps;
+  const double rate16 = double(agreement16.nbAgreements) / agreement16.nbSteps;
+  const double bytes = sarsa->weights()->dimension() * sizeof(double);
+  cout << "## " << name << " agreement int8=" << rate8 << " int16=" << rate16 << " bytes double="
+      << bytes << " int8=" << q8.getQuantized()->bytes() << " int16="
+      << q16.getQuantized()->bytes() << endl;
+  cout << "## " << name << " return double=" << evaluate<P>(&reference, 10) << " int8="
+      << evaluate<P>(&control8, 10) << " int16=" << evaluate<P>(&control16, 10) << endl;
+  Assert::assertPasses(rate8 > 0.9 && rate16 > 0.99);
+  Assert::assertPasses(q8.getQuantized()->bytes() < bytes / 7);
+
+  // The dequantized weights, for whoever asks
+  const Vector<double>* w = q16.weights();
+  Assert::assertPasses(w->dimension() == sarsa->weights()->dimension());
+  Assert::assertPasses(std::abs(w->l1Norm() - sarsa->weights()->l1Norm()) < 1e-3 * w->l1Norm());
+
+  // Deployed from a file of the int8 weights and their scales, through the control
+  const char* f = "visualization/quantizedControl.bin";
+  control8.persist(f);
+  std::ifstream file(f, std::ifstream::binary | std::ifstream::ate);
+  const double fileBytes = double(file.tellg());
+  file.close();
+  Sarsa<double>* untrained = new Sarsa<double>(0.1, 0.99, 0.3, e);
+  QuantizedPredictor<double, int8_t> restored(untrained);
+  GreedyControl<double> restoredControl(problem->getDiscreteActions(), toStateAction, &restored);
+  restored.weights(); // A dequantized copy to refresh
+  restoredControl.resurrect(f);
+  std::remove(f);
+  Assert::assertPasses(fileBytes < bytes / 7);
+  for (int i = 0; i < q8.weights()->dimension(); i++)
+  {
+    Assert::assertPasses(restored.getQuantized()->getEntry(i) == q8.getQuantized()->getEntry(i));
+    Assert::assertPasses(restored.weights()->getEntry(i) == q8.weights()->getEntry(i));
+  }
+  delete untrained;
+
+  delete sim;
+  delete agent;
+  delete control;
+  delete acting;
+  delete sarsa;
+  delete e;
+  delete toStateAction;
+  delete projector;
+  delete hashing;
+  delete problem;
+}
+
+void QuantizationTest::run()
+{
+  testQuantizedVector();
+  testQuantizedControl<MountainCar<double> >("MountainCar", 10);
+  testQuantizedControl<Acrobot>("Acrobot", 6);
+}
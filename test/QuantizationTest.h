@@ -0,0 +1,94 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * QuantizationTest.h
+ */
+
+#ifndef QUANTIZATIONTEST_H_
+#define QUANTIZATIONTEST_H_
+
+#include "Test.h"
+#include "Quantization.h"
+#include "Acrobot.h"
+
+RLLIB_TEST(QuantizationTest)
+
+class QuantizationTest: public QuantizationTestBase
+{
+  public:
+    QuantizationTest()
+    {
+    }
+
+    virtual ~QuantizationTest()
+    {
+    }
+
+    void run();
+
+  private:
+    void testQuantizedVector();
+    template<class P> void testQuantizedControl(const char* name, const int& gridResolution);
+    template<class P> double evaluate(Control<double>* control, const int& nbEpisodes);
+};
+
+// Acts with the reference control, and counts the steps where the candidate agrees
+class QuantizationAgreementAgent: public RLAgent<double>
+{
+  protected:
+    Control<double>* candidate;
+
+  public:
+    long nbSteps;
+    long nbAgreements;
+
+    QuantizationAgreementAgent(Control<double>* reference, Control<double>* candidate) :
+        RLAgent<double>(reference), candidate(candidate), nbSteps(0), nbAgreements(0)
+    {
+    }
+
+    const Action<double>* initialize(const TRStep<double>* step)
+    {
+      return getAtp1(step);
+    }
+
+    const Action<double>* getAtp1(const TRStep<double>* step)
+    {
+      const Action<double>* a = control->proposeAction(step->o_tp1);
+      const Action<double>* b = candidate->proposeAction(step->o_tp1);
+      ++nbSteps;
+      if (a->id() == b->id())
+        ++nbAgreements;
+      return a;
+    }
+
+    void reset()
+    {
+    }
+};
+
+// Returns of the episodes
+class QuantizationReturnEvent: public RLRunner<double>::Event
+{
+  public:
+    mutable RunningStatistics<double> returns;
+
+    void update() const
+    {
+      returns.add(episodeR);
+    }
+};
+
+#endif /* QUANTIZATIONTEST_H_ */
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * RandomTest.cpp
+ */
+
+#include "RandomTest.h"
+
+void RandomTest::testPhiloxKnownAnswers()
+{
+  // Reference vectors of Philox4x32-10 (Random123)
+  const uint32_t counters[][4] = { { 0, 0, 0, 0 }, //
+      { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, //
+      { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 } };
+  const uint32_t keys[][2] = { { 0, 0 }, { 0xffffffff, 0xffffffff }, { 0xa4093822, 0x299f31d0 } };
+  const uint32_t expected[][4] = { { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 }, //
+      { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd }, //
+      { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } };
+  for (unsigned int i = 0; i < Arrays::length(counters); i++)
+  {
+    uint32_t out[4];
+    Philox::generate(counters[i], keys[i], out);
+    for (int j = 0; j < 4; j++)
+      Assert::assertObjectEquals(expected[i][j], out[j]);
+  }
+  // The first block of the stream 0 with seed 0 is the first reference vector
+  Philox philox;
+  for (int j = 0; j < 4; j++)
+    Assert::assertObjectEquals(expected[0][j], philox.rand_u32());
+}
+
+void RandomTest::testStreams()
+{
+  const int nbDraws = 1001;
+  Philox a(42, 7), b(42, 7), c(42, 8), d(43, 7);
+  uint32_t bulk[nbDraws];
+  b.rand_u32(); // bulk generation after a partially consumed block
+  b.rand_u32(bulk + 1, nbDraws - 1);
+  int nbSameC = 0, nbSameD = 0;
+  for (int i = 0; i < nbDraws; i++)
+  {
+    const uint32_t x = a.rand_u32();
+    if (i > 0)
+      Assert::assertObjectEquals(x, bulk[i]);
+    nbSameC += (x == c.rand_u32());
+    nbSameD += (x == d.rand_u32());
+  }
+  Assert::assertPasses(nbSameC < 3 && nbSameD < 3);
+
+  // Restarting a stream reproduces it
+  Random<double> random(1, 3);
+  std::vector<double> draws;
+  for (int i = 0; i < 10; i++)
+    draws.push_back(random.nextReal());
+  random.setStream(4);
+  Assert::assertPasses(random.nextReal() != draws[0]);
+  random.setStream(3);
+  for (int i = 0; i < 10; i++)
+    Assert::assertObjectEquals(draws[i], random.nextReal());
+}
+
+void RandomTest::testUniforms()
+{
+  Random<double> random;
+  Random<float> randomf;
+  const int nbDraws = 100000;
+  double* values = new double[nbDraws];
+  float* valuesf = new float[nbDraws];
+  random.nextReals(values, nbDraws);
+  randomf.nextReals(valuesf, nbDraws);
+  double sum = 0, sumf = 0;
+  int counts[7] = { 0 };
+  for (int i = 0; i < nbDraws; i++)
+  {
+    Assert::assertPasses(values[i] >= 0.0 && values[i] < 1.0);
+    Assert::assertPasses(valuesf[i] >= 0.0f && valuesf[i] < 1.0f);
+    sum += values[i];
+    sumf += valuesf[i];
+    const int k = random.nextInt(7);
+    Assert::assertPasses(k >= 0 && k < 7);
+    ++counts[k];
+  }
+  std::cout << "mean=" << sum / nbDraws << " meanf=" << sumf / nbDraws << std::endl;
+  Assert::assertObjectEquals(0.5, sum / nbDraws, 5e-3);
+  Assert::assertObjectEquals(0.5, sumf / nbDraws, 5e-3);
+  for (int k = 0; k < 7; k++)
+    Assert::assertObjectEquals(1.0 / 7.0, double(counts[k]) / nbDraws, 5e-3);
+  delete[] values;
+  delete[] valuesf;
+}
+
+void RandomTest::testGaussians()
+{
+  Random<double> random;
+  const int nbDraws = 200001; // odd on purpose
+  double* values = new double[nbDraws];
+  Timer timer;
+  timer.start();
+  random.nextNormalGaussians(values, nbDraws);
+  timer.stop();
+  const double bulkTime = timer.getElapsedTimeInMilliSec();
+  double sum = 0, sum2 = 0;
+  for (int i = 0; i < nbDraws; i++)
+  {
+    Assert::assertPasses(Boundedness::checkValue(values[i]));
+    sum += values[i];
+    sum2 += values[i] * values[i];
+  }
+  const double mean = sum / nbDraws;
+  const double variance = sum2 / nbDraws - mean * mean;
+  timer.start();
+  for (int i = 0; i < nbDraws; i++)
+    values[i] = random.nextNormalGaussian();
+  timer.stop();
+  std::cout << "mean=" << mean << " variance=" << variance << " bulk(ms)=" << bulkTime
+      << " polar(ms)=" << timer.getElapsedTimeInMilliSec() << std::endl;
+  Assert::assertObjectEquals(0.0, mean, 1e-2);
+  Assert::assertObjectEquals(1.0, variance, 1e-2);
+  delete[] values;
+}
+
+void RandomTest::testPerInstanceGaussianCache()
+{
+  // Interleaving two generators must not change the deviates of either
+  Random<double> a(5), b(6), a2(5), b2(6);
+  std::vector<double> expectedA, expectedB;
+  for (int i = 0; i < 10; i++)
+    expectedA.push_back(a2.nextGaussian(0, 1));
+  for (int i = 0; i < 10; i++)
+    expectedB.push_back(b2.nextGaussian(0, 1));
+  for (int i = 0; i < 10; i++)
+  {
+    Assert::assertObjectEquals(expectedA[i], a.nextGaussian(0, 1));
+    Assert::assertObjectEquals(expectedB[i], b.nextGaussian(0, 1));
+  }
+}
+
+void RandomTest::run()
+{
+  testPhiloxKnownAnswers();
+  testStreams();
+  testUniforms();
+  testGaussians();
+  testPerInstanceGaussianCache();
+}
+
+RLLIB_TEST_MAKE(RandomTest)
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * RandomTest.h
+ */
+
+#ifndef RANDOMTEST_H_
+#define RANDOMTEST_H_
+
+#include "Test.h"
+#include "Mathema.h"
+#include "Timer.h"
+
+RLLIB_TEST(RandomTest)
+
+class RandomTest: public RandomTestBase
+{
+  public:
+    RandomTest()
+    {
+    }
+
+    virtual ~RandomTest()
+    {
+    }
+
+    void run();
+
+  private:
+    void testPhiloxKnownAnswers();
+    void testStreams();
+    void testUniforms();
+    void testGaussians();
+    void testPerInstanceGaussianCache();
+};
+
+#endif /* RANDOMTEST_H_ */
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ReplayTest.cpp
+ */
+
+#include "ReplayTest.h"
+
+void ReplayTest::testSumTree()
+{
+  Random<double> random;
+  const int capacity = 11;
+  SumTree<double> tree(capacity);
+  double total = 0;
+  for (int i = 0; i < capacity; i++)
+  {
+    tree.update(i, double(i));
+    total += i;
+  }
+  Assert::assertObjectEquals(total, tree.total(), 1e-10);
+  Assert::assertObjectEquals(0.0, tree.min());
+  Assert::assertObjectEquals(1, tree.find(0.0)); // leaf 0 has no mass
+  Assert::assertObjectEquals(capacity - 1, tree.find(total - 1e-9));
+
+  int counts[capacity] = { 0 };
+  const int nbSamples = 500000;
+  for (int i = 0; i < nbSamples; i++)
+    ++counts[tree.sample(&random)];
+  Assert::assertObjectEquals(0, counts[0]);
+  for (int i = 0; i < capacity; i++)
+    Assert::assertObjectEquals(double(i) / total, double(counts[i]) / nbSamples, 5e-3);
+
+  tree.update(3, 0.5);
+  Assert::assertObjectEquals(total - 3 + 0.5, tree.total(), 1e-10);
+  Assert::assertObjectEquals(10.0, tree.max());
+}
+
+void ReplayTest::testReplayBuffer()
+{
+  ActionArray<double> actions(3);
+  ReplayBuffer<double> buffer(4, 2, actions.dimension(), 3);
+  PVector<double> x_t(2), x_tp1(2), absorbingState(0);
+  SVector<double> phi(10);
+  Representations<double> phis(10, &actions);
+
+  for (int i = 0; i < 6; i++)
+  {
+    x_t[0] = i;
+    x_t[1] = -i;
+    x_tp1[0] = i + 1;
+    x_tp1[1] = -(i + 1);
+    const bool terminal = (i == 5);
+    const int slot = buffer.push(&x_t, actions.getEntry(i % 3), terminal ? &absorbingState : &x_tp1,
+        double(i) / 2);
+    Assert::assertObjectEquals(i % 4, slot);
+    phi.clear();
+    phi.setEntry(i, 1.0);
+    phi.setEntry(9, 1.0);
+    buffer.setFeatures_t(slot, &phi);
+    for (int a = 0; a < actions.dimension(); a++)
+    {
+      phis.at(a)->clear();
+      phis.at(a)->setEntry(a, 1.0);
+    }
+    buffer.setFeatures_tp1(slot, &phis);
+  }
+  Assert::assertObjectEquals(4, buffer.size());
+
+  // Slot 1 holds the transition 5 (ring buffer), slot 2 the transition 2
+  PVector<double> o(2);
+  buffer.observation_t(1, &o);
+  Assert::assertObjectEquals(5.0, o[0]);
+  Assert::assertObjectEquals(-5.0, o[1]);
+  Assert::assertPasses(buffer.terminal(1));
+  Assert::assertObjectEquals(2, buffer.action(1));
+  Assert::assertObjectEquals(2.5, buffer.reward(1));
+  buffer.observation_tp1(2, &o);
+  Assert::assertObjectEquals(3.0, o[0]);
+  Assert::assertPasses(!buffer.terminal(2));
+
+  const int32_t* features = buffer.features_t(2);
+  Assert::assertObjectEquals(2, features[0]);
+  Assert::assertPasses(
+      (features[1] == 2 && features[2] == 9) || (features[1] == 9 && features[2] == 2));
+  for (int a = 0; a < actions.dimension(); a++)
+  {
+    Assert::assertObjectEquals(1, buffer.features_tp1(2, a)[0]);
+    Assert::assertObjectEquals(a, buffer.features_tp1(2, a)[1]);
+  }
+  std::cout << "memory(bytes)=" << buffer.memoryUsage() << std::endl;
+}
+
+void ReplayTest::run()
+{
+  testSumTree();
+  testReplayBuffer();
+}
+
+RLLIB_TEST_MAKE(ReplayTest)
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ReplayTest.h
+ */
+
+#ifndef REPLAYTEST_H_
+#define REPLAYTEST_H_
+
+#include "Test.h"
+#include "Replay.h"
+
+RLLIB_TEST(ReplayTest)
+
+class ReplayTest: public ReplayTestBase
+{
+  public:
+    ReplayTest()
+    {
+    }
+
+    virtual ~ReplayTest()
+    {
+    }
+
+    void run();
+
+  private:
+    void testSumTree();
+    void testReplayBuffer();
+};
+
+#endif /* REPLAYTEST_H_ */
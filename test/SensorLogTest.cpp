@@ -0,0 +1,169 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SensorLogTest.cpp
+ */
+
+#include "SensorLogTest.h"
+
+#define TEXT_FILE "./databases/0.txt"
+#define LOG_FILE "./databases/0.rlog"
+#define LARGE_TEXT_FILE "./databases/large.txt"
+#define LARGE_LOG_FILE "./databases/large.rlog"
+
+RLLIB_TEST_MAKE(SensorLogTest)
+
+std::vector<std::vector<double> > SensorLogTest::readText(const char* f)
+{
+  std::vector<std::vector<double> > rows;
+  std::ifstream ifs(f);
+  std::string str;
+  while (std::getline(ifs, str))
+  {
+    std::istringstream iss(str);
+    std::vector<double> tokens
+    { std::istream_iterator<double> { iss }, std::istream_iterator<double> { } };
+    if (!tokens.empty())
+      rows.push_back(tokens);
+  }
+  return rows;
+}
+
+void SensorLogTest::testConvert()
+{
+  const std::vector<std::vector<double> > rows = readText(TEXT_FILE);
+  // Small blocks, such that the last one is partial
+  Assert::assertPasses(SensorLogs::convert(TEXT_FILE, LOG_FILE, 64));
+  SensorLogReader log(LOG_FILE);
+  Assert::assertPasses(log.isOpen());
+  Assert::assertPasses(log.getNbRows() == rows.size());
+  Assert::assertPasses(log.getNbColumns() == int(rows[0].size()));
+  Assert::assertPasses(log.getNbBlocks() == (rows.size() + 63) / 64);
+  std::vector<double> row(log.getNbColumns());
+  for (size_t i = 0; i < rows.size(); i++)
+  {
+    log.row(i, &row[0]);
+    for (int c = 0; c < log.getNbColumns(); c++)
+    {
+      Assert::assertPasses(row[c] == double(float(rows[i][c])));
+      Assert::assertPasses(log.value(i, c) == float(rows[i][c]));
+    }
+  }
+  // Columns are contiguous within a block
+  const float* column = log.column(1, 10);
+  for (int i = 0; i < 64; i++)
+    Assert::assertPasses(column[i] == float(rows[64 + i][10]));
+
+  SensorLogReader missing("./databases/missing.rlog");
+  Assert::assertPasses(!missing.isOpen());
+  SensorLogReader notLog(TEXT_FILE);
+  Assert::assertPasses(!notLog.isOpen());
+}
+
+void SensorLogTest::testReplay()
+{
+  const std::vector<std::vector<double> > rows = readText(TEXT_FILE);
+  const int last = int(rows[0].size()) - 1;
+  // Same episodes as HordeProblem: the first row starts an episode, a marker 2 ends it
+  int expectedEpisodes = 0, expectedSteps = 0;
+  double expectedR = 0, expectedO = 0;
+  for (size_t i = 0; i < rows.size(); i++)
+  {
+    ++expectedEpisodes;
+    expectedO += float(rows[i][0]);
+    while (++i < rows.size())
+    {
+      ++expectedSteps;
+      expectedR += float(rows[i][10]);
+      expectedO += float(rows[i][0]);
+      if (rows[i][last] == 2)
+        break;
+    }
+  }
+
+  SensorLogReader log(LOG_FILE);
+  SensorLogProblem<double> problem(0, &log, 10, 10, last);
+  SensorLogCountingAgent agent(&problem);
+  SensorLogReplay<double> replay(&agent, &problem, 128);
+  replay.run();
+  cout << "## episodes=" << replay.getNbEpisodes() << " steps=" << replay.getNbSteps() << " R="
+      << agent.sumR << endl;
+  Assert::assertPasses(problem.endOfLog());
+  Assert::assertPasses(agent.nbInitialize == expectedEpisodes);
+  Assert::assertPasses(replay.getNbEpisodes() == expectedEpisodes);
+  Assert::assertPasses(agent.nbEndOfEpisodes == expectedEpisodes);
+  Assert::assertPasses(agent.nbSteps == expectedSteps);
+  Assert::assertPasses(int(replay.getNbSteps()) == expectedSteps);
+  Assert::assertPasses(std::fabs(agent.sumR - expectedR) < 1e-6);
+  Assert::assertPasses(std::fabs(agent.sumO - expectedO) < 1e-6);
+
+  // The problem rewinds, and runs with RLRunner as well
+  SensorLogCountingAgent agent2(&problem);
+  RLRunner<double> runner(&agent2, &problem, -1, expectedEpisodes, 1);
+  runner.setVerbose(false);
+  runner.run();
+  Assert::assertPasses(agent2.nbSteps == expectedSteps);
+  Assert::assertPasses(std::fabs(agent2.sumR - expectedR) < 1e-6);
+
+  // A bounded number of episodes
+  problem.setCursor(0);
+  SensorLogCountingAgent agent3(&problem);
+  SensorLogReplay<double> replay3(&agent3, &problem);
+  replay3.run(5);
+  Assert::assertPasses(agent3.nbInitialize == 5 && agent3.nbEndOfEpisodes == 5);
+  Assert::assertPasses(!problem.endOfLog());
+}
+
+void SensorLogTest::testReplayThroughput()
+{
+  const int nbRows = 200000;
+  const int nbColumns = 14;
+  const int episodeLength = 1000;
+  {
+    Random<double> random;
+    std::ofstream ofs(LARGE_TEXT_FILE);
+    for (int i = 0; i < nbRows; i++)
+    {
+      for (int c = 0; c < nbColumns - 1; c++)
+        ofs << random.nextReal() << " ";
+      ofs << ((i % episodeLength == episodeLength - 1) ? 2 : 1) << std::endl;
+    }
+  }
+  Timer timer;
+  timer.start();
+  Assert::assertPasses(SensorLogs::convert(LARGE_TEXT_FILE, LARGE_LOG_FILE));
+  timer.stop();
+  const double convertTime = timer.getElapsedTimeInMilliSec();
+
+  SensorLogReader log(LARGE_LOG_FILE);
+  SensorLogProblem<double> problem(0, &log, 10, 10, nbColumns - 1);
+  SensorLogCountingAgent agent(&problem);
+  SensorLogReplay<double> replay(&agent, &problem);
+  replay.run();
+  cout << "## rows=" << nbRows << " convert(ms)=" << convertTime << " replay(ms)="
+      << replay.getReplayTimeInMilliseconds() << " steps=" << replay.getNbSteps() << endl;
+  Assert::assertPasses(replay.getNbEpisodes() == nbRows / episodeLength);
+  Assert::assertPasses(int(replay.getNbSteps()) == nbRows - nbRows / episodeLength);
+  std::remove(LARGE_TEXT_FILE);
+  std::remove(LARGE_LOG_FILE);
+}
+
+void SensorLogTest::run()
+{
+  testConvert();
+  testReplay();
+  testReplayThroughput();
+  std::remove(LOG_FILE);
+}
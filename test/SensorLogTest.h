@@ -0,0 +1,88 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SensorLogTest.h
+ */
+
+#ifndef SENSORLOGTEST_H_
+#define SENSORLOGTEST_H_
+
+#include "Test.h"
+#include "SensorLog.h"
+
+RLLIB_TEST(SensorLogTest)
+
+class SensorLogTest: public SensorLogTestBase
+{
+  public:
+    SensorLogTest()
+    {
+    }
+
+    virtual ~SensorLogTest()
+    {
+    }
+
+    void run();
+
+  private:
+    static std::vector<std::vector<double> > readText(const char* f);
+    void testConvert();
+    void testReplay();
+    void testReplayThroughput();
+};
+
+// Counts what it receives from the log
+class SensorLogCountingAgent: public RLAgent<double>
+{
+  public:
+    int nbInitialize;
+    int nbSteps;
+    int nbEndOfEpisodes;
+    double sumR;
+    double sumO;
+
+    SensorLogCountingAgent(RLProblem<double>* problem) :
+        RLAgent<double>(0), nbInitialize(0), nbSteps(0), nbEndOfEpisodes(0), sumR(0), sumO(0), //
+        problem(problem)
+    {
+    }
+
+    const Action<double>* initialize(const TRStep<double>* step)
+    {
+      ++nbInitialize;
+      sumO += step->observation_tp1->getEntry(0);
+      return problem->getDiscreteActions()->getEntry(0);
+    }
+
+    const Action<double>* getAtp1(const TRStep<double>* step)
+    {
+      ++nbSteps;
+      sumR += step->r_tp1;
+      sumO += step->observation_tp1->getEntry(0);
+      if (step->endOfEpisode)
+        ++nbEndOfEpisodes;
+      return problem->getDiscreteActions()->getEntry(0);
+    }
+
+    void reset()
+    {
+    }
+
+  private:
+    RLProblem<double>* problem;
+};
+
+#endif /* SENSORLOGTEST_H_ */
@@ -0,0 +1,275 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SnapshotTest.cpp
+ */
+
+
+#include "SnapshotTest.h"
+
+RLLIB_TEST_MAKE(SnapshotTest)
+
+static void fill(Vector<double>* x, const double& value)
+{
+  x->set(value);
+}
+
+void SnapshotTest::testPublishAcquire()
+{
+  PVector<double> u(10), v(20);
+  SnapshotChannel<double> channel;
+  channel.add(&u);
+  channel.add(&v);
+  Assert::assertPasses(channel.acquire() == 0);
+
+  for (int k = 1; k <= 5; k++)
+  {
+    fill(&u, double(k));
+    fill(&v, double(-k));
+    Assert::assertPasses(channel.publish());
+    const ParametersSnapshot<double>* snapshot = channel.acquire();
+    Assert::assertPasses(snapshot != 0 && snapshot->version == uint64_t(k));
+    Assert::assertPasses(snapshot->dimension() == 2);
+    Assert::assertPasses(snapshot->at(0)->dimension() == 10 && snapshot->at(1)->dimension() == 20);
+    // Copies: the learner keeps writing
+    fill(&u, 0.0);
+    Assert::assertPasses(snapshot->at(0)->getEntry(3) == double(k));
+    Assert::assertPasses(snapshot->at(1)->getEntry(7) == double(-k));
+    channel.release(snapshot);
+  }
+  Assert::assertPasses(channel.getVersion() == 5 && channel.getNbSkipped() == 0);
+}
+
+void SnapshotTest::testPublishSkipsHeldBuffers()
+{
+  PVector<double> u(4);
+  SnapshotChannel<double> channel(2);
+  channel.add(&u);
+  fill(&u, 1.0);
+  Assert::assertPasses(channel.publish());
+  const ParametersSnapshot<double>* first = channel.acquire();
+  fill(&u, 2.0);
+  // The other buffer is free
+  Assert::assertPasses(channel.publish());
+  const ParametersSnapshot<double>* second = channel.acquire();
+  Assert::assertPasses(first != second && second->version == 2);
+  // Both are held: the learner goes on without a snapshot
+  fill(&u, 3.0);
+  Assert::assertPasses(!channel.publish());
+  Assert::assertPasses(channel.getNbSkipped() == 1);
+  Assert::assertPasses(first->at(0)->getEntry(0) == 1.0 && second->at(0)->getEntry(0) == 2.0);
+  channel.release(first);
+  Assert::assertPasses(channel.publish());
+  channel.release(second);
+  const ParametersSnapshot<double>* third = channel.acquire();
+  Assert::assertPasses(third == first && third->version == 3 && third->at(0)->getEntry(0) == 3.0);
+  channel.release(third);
+}
+
+// Every snapshot holds a single generation: each entry of every vector equals its version
+class SnapshotReader
+{
+  public:
+    SnapshotChannel<double>* channel;
+    std::atomic<bool>* done;
+    int nbTorn;
+    int nbSnapshots;
+    uint64_t lastVersion;
+    bool ordered;
+
+    SnapshotReader(SnapshotChannel<double>* channel, std::atomic<bool>* done) :
+        channel(channel), done(done), nbTorn(0), nbSnapshots(0), lastVersion(0), ordered(true)
+    {
+    }
+
+    void run()
+    {
+      while (!done->load())
+      {
+        const ParametersSnapshot<double>* snapshot = channel->acquire();
+        if (!snapshot)
+          continue;
+        const double expected = double(snapshot->version);
+        for (int i = 0; i < snapshot->dimension(); i++)
+        {
+          const Vector<double>* vector = snapshot->at(i);
+          for (int j = 0; j < vector->dimension(); j++)
+          {
+            if (vector->getEntry(j) != expected)
+            {
+              ++nbTorn;
+              break;
+            }
+          }
+        }
+        if (snapshot->version < lastVersion)
+          ordered = false;
+        lastVersion = snapshot->version;
+        ++nbSnapshots;
+        channel->release(snapshot);
+      }
+    }
+};
+
+void SnapshotTest::testConcurrentReaders()
+{
+  PVector<double> u(5000), v(3000);
+  SnapshotChannel<double> channel(4);
+  channel.add(&u);
+  channel.add(&v);
+  std::atomic<bool> done(false);
+  std::vector<SnapshotReader*> readers;
+  std::vector<std::thread*> readerThreads;
+  for (int k = 0; k < 3; k++)
+  {
+    readers.push_back(new SnapshotReader(&channel, &done));
+    readerThreads.push_back(new std::thread(&SnapshotReader::run, readers[k]));
+  }
+
+  int nbPublished = 0;
+  for (int k = 0; k < 2000; k++)
+  {
+    // The version the next publish() will take
+    const double next = double(channel.getVersion() + 1);
+    fill(&u, next);
+    fill(&v, next);
+    if (channel.publish())
+      ++nbPublished;
+  }
+  done = true;
+  for (int k = 0; k < 3; k++)
+  {
+    readerThreads[k]->join();
+    delete readerThreads[k];
+  }
+
+  Assert::assertPasses(nbPublished + channel.getNbSkipped() == 2000);
+  Assert::assertPasses(channel.getVersion() == uint64_t(nbPublished));
+  for (int k = 0; k < 3; k++)
+  {
+    cout << "## reader=" << k << " snapshots=" << readers[k]->nbSnapshots << endl;
+    Assert::assertPasses(readers[k]->nbTorn == 0);
+    Assert::assertPasses(readers[k]->ordered);
+    delete readers[k];
+  }
+}
+
+void SnapshotTest::testSnapshotControl()
+{
+  // Learner and evaluator have their own hashing with the same seed, hence the same features
+  Random<double> learnerRandom(0), evaluatorRandom(0);
+  ActionArray<double> actions(3);
+  MurmurHashing<double> learnerHashing(&learnerRandom, 10000);
+  MurmurHashing<double> evaluatorHashing(&evaluatorRandom, 10000);
+  TileCoderHashing<double> learnerProjector(&learnerHashing, 2, 10, 10, true);
+  TileCoderHashing<double> evaluatorProjector(&evaluatorHashing, 2, 10, 10, true);
+  StateActionTilings<double> learnerToStateAction(&learnerProjector, &actions);
+  StateActionTilings<double> evaluatorToStateAction(&evaluatorProjector, &actions);
+  BoltzmannDistribution<double> learnerPolicy(&learnerRandom, &actions,
+      learnerProjector.dimension());
+  BoltzmannDistribution<double> evaluatorPolicy(&evaluatorRandom, &actions,
+      evaluatorProjector.dimension());
+  PVector<double> critic(learnerProjector.dimension());
+
+  SnapshotChannel<double> channel;
+  channel.add(learnerPolicy.parameters());
+  channel.add(&critic);
+  SnapshotControl<double> control(&channel, &evaluatorPolicy, &evaluatorToStateAction,
+      &evaluatorProjector);
+  Assert::assertPasses(!control.refresh());
+
+  Random<double> random;
+  Vector<double>* u = learnerPolicy.parameters()->getEntry(0);
+  for (int i = 0; i < u->dimension(); i++)
+    u->setEntry(i, random.nextNormalGaussian());
+  for (int i = 0; i < critic.dimension(); i++)
+    critic[i] = random.nextNormalGaussian();
+  channel.publish();
+  Assert::assertPasses(control.refresh() && control.getVersion() == 1);
+  Assert::assertPasses(!control.refresh());
+  // The learner moves on; the evaluator keeps the published parameters
+  u->clear();
+  const PVector<double> published(critic);
+  critic.clear();
+
+  PVector<double> x(2);
+  for (int k = 0; k < 100; k++)
+  {
+    x[0] = random.nextReal();
+    x[1] = random.nextReal();
+    Assert::assertPasses(
+        control.computeValueFunction(&x) == published.dot(learnerProjector.project(&x)));
+    const Action<double>* a = control.proposeAction(&x);
+    Assert::assertPasses(a != 0 && a->id() < 3);
+  }
+}
+
+// The RLLibViz mountain car learner, publishing on every step it is due
+void SnapshotTest::testPublishingOverhead()
+{
+  Random<double> random;
+  MountainCar<double> problem(&random);
+  MurmurHashing<double> hashing(&random, 1000000);
+  TileCoderHashing<double> projector(&hashing, problem.dimension(), 10, 10, true);
+  StateActionTilings<double> toStateAction(&projector, problem.getDiscreteActions());
+  ATrace<double> critice(projector.dimension());
+  GTDLambda<double> critic(0.05 / projector.vectorNorm(), 0.0001 / projector.vectorNorm(), 0.99,
+      0.0, &critice);
+  BoltzmannDistribution<double> target(&random, problem.getDiscreteActions(),
+      projector.dimension());
+  ATrace<double> actore(projector.dimension());
+  Traces<double> actoreTraces;
+  actoreTraces.push_back(&actore);
+  ActorLambdaOffPolicy<double> actor(1.0 / projector.vectorNorm(), 0.99, 0.0, &target,
+      &actoreTraces);
+  RandomPolicy<double> behavior(&random, problem.getDiscreteActions());
+  OffPAC<double> control(&behavior, &critic, &actor, &toStateAction, &projector);
+  LearnerAgent<double> agent(&control);
+  RLRunner<double> runner(&agent, &problem, 5000);
+  runner.setVerbose(false);
+
+  const double maxOverhead = 0.05;
+  SnapshotChannel<double> channel(3, 0.01, maxOverhead);
+  channel.add(target.parameters());
+  channel.add(control.predictor()->weights());
+
+  int nbPublished = 0;
+  Timer timer;
+  timer.start();
+  while (timer.getElapsedTimeInSec() < 0.5)
+  {
+    for (int k = 0; k < 100; k++)
+    {
+      runner.step();
+      if (channel.publishIfDue())
+        ++nbPublished;
+    }
+  }
+  timer.stop();
+  const double overhead = channel.getPublishingTime() / timer.getElapsedTimeInSec();
+  cout << "## published=" << nbPublished << " overhead=" << overhead << endl;
+  Assert::assertPasses(nbPublished > 1 && channel.getVersion() == uint64_t(nbPublished));
+  // One copy may land right at the end; the learner is otherwise slowed by at most maxOverhead
+  Assert::assertPasses(overhead < 2.0 * maxOverhead);
+}
+
+void SnapshotTest::run()
+{
+  testPublishAcquire();
+  testPublishSkipsHeldBuffers();
+  testConcurrentReaders();
+  testSnapshotControl();
+  testPublishingOverhead();
+}
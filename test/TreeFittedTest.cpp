@@ -8,6 +8,8 @@
 #include "TreeFittedTest.h"
 #include "Mathema.h"
 #include "util/TreeFitted/ExtraTreeEnsemble.h"
+#include "FittedQIteration.h"
+#include "MountainCar.h"
 
 RLLIB_TEST_MAKE(TreeFittedTest)
 
@@ -296,11 +298,41 @@ void TreeFittedTest::testRegularizedLinearRegression()
   std::cout << std::endl;
 }
 
+void TreeFittedTest::testFittedQIterationMountainCar()
+{
+  // The trees are grown with rand()
+  srand(0);
+  RLLib::Random<double>* random = new RLLib::Random<double>;
+  // Random initial states spread the batch over the whole state space
+  RLLib::RLProblem<double>* behaviourProblem = new MountainCar<double>(random);
+  RLLib::RLProblem<double>* problem = new MountainCar<double>;
+  RLLib::FittedQIteration<double>* fqi = new RLLib::FittedQIteration<double>(random,
+      problem->getDiscreteActions(), problem->dimension(), 0.98, 20, 3, 5);
+
+  fqi->collect(behaviourProblem, 100, 100);
+  fqi->iterate(80, true);
+  std::cout << "samples=" << fqi->getNbSamples() << " iterations=" << fqi->getNbIterations()
+      << " time(ms)=" << fqi->getTotalIterationTime() << std::endl;
+
+  RLLib::RLAgent<double>* agent = new RLLib::ControlAgent<double>(fqi);
+  RLLib::RLRunner<double>* sim = new RLLib::RLRunner<double>(agent, problem, 1000, 1, 1);
+  sim->setEnableStatistics(true);
+  sim->run();
+
+  delete random;
+  delete behaviourProblem;
+  delete problem;
+  delete fqi;
+  delete agent;
+  delete sim;
+}
+
 void TreeFittedTest::run()
 {
   testRosenbrock();
   testRastrigin();
   testCigar();
   testRegularizedLinearRegression();
+  testFittedQIterationMountainCar();
 }
 
@@ -26,6 +26,7 @@ class TreeFittedTest: public TreeFittedTestBase
     void testRastrigin();
     void testCigar();
     void testRegularizedLinearRegression();
+    void testFittedQIterationMountainCar();
 };
 
 #endif /* TEST_TREEFITTEDTEST_H_ */
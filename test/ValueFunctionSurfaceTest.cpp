@@ -0,0 +1,236 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ValueFunctionSurfaceTest.cpp
+ */
+
+#include "ValueFunctionSurfaceTest.h"
+
+RLLIB_TEST_MAKE(ValueFunctionSurfaceTest)
+
+// One hashing and tile coder per worker; the same seed gives the same features
+class SurfaceWorker
+{
+  public:
+    Random<double> random;
+    Hashing<double>* hashing;
+    Projector<double>* projector;
+    LinearValueEvaluator<double>* evaluator;
+
+    SurfaceWorker(const Vector<double>* weights) :
+        random(0), hashing(new MurmurHashing<double>(&random, 10000)), //
+        projector(new TileCoderHashing<double>(hashing, 2, 10, 10, true)), //
+        evaluator(new LinearValueEvaluator<double>(projector, weights))
+    {
+    }
+
+    ~SurfaceWorker()
+    {
+      delete evaluator;
+      delete projector;
+      delete hashing;
+    }
+};
+
+void ValueFunctionSurfaceTest::testParallelGrid()
+{
+  Random<double> random;
+  PVector<double> weights(10001);
+  for (int i = 0; i < weights.dimension(); i++)
+    weights[i] = random.nextNormalGaussian();
+  Range<double> positionRange(-1.2, 0.6);
+  Range<double> velocityRange(-0.07, 0.07);
+
+  // At least two workers, for the split of the rows
+  const int nbWorkers = std::max(2, ValueFunctionSurface<double>::nbHardwareWorkers());
+  std::vector<SurfaceWorker*> workers;
+  std::vector<ValueEvaluator<double>*> serialEvaluators, parallelEvaluators;
+  for (int k = 0; k < nbWorkers; k++)
+  {
+    workers.push_back(new SurfaceWorker(&weights));
+    parallelEvaluators.push_back(workers[k]->evaluator);
+  }
+  serialEvaluators.push_back(workers[0]->evaluator);
+
+  ValueFunctionSurface<double> serial(serialEvaluators, 2, 200, 200);
+  ValueFunctionSurface<double> parallel(parallelEvaluators, 2, 200, 200);
+  Timer timer;
+  timer.start();
+  serial.evaluateGrid(&positionRange, &velocityRange, true);
+  timer.stop();
+  const double serialTime = timer.getElapsedTimeInMilliSec();
+  timer.start();
+  parallel.evaluateGrid(&positionRange, &velocityRange, true);
+  timer.stop();
+  cout << "## 200x200 serial(ms)=" << serialTime << " parallel(ms)="
+      << timer.getElapsedTimeInMilliSec() << " workers=" << nbWorkers << endl;
+
+  // Same values as the cell by cell evaluation of ModelBase
+  PVector<double> x(2);
+  for (int i = 0; i < serial.rows(); i++)
+  {
+    for (int j = 0; j < serial.cols(); j++)
+    {
+      Assert::assertPasses(serial.at(i, j) == parallel.at(i, j));
+      if ((i * serial.cols() + j) % 97 == 0)
+      {
+        x[0] = positionRange.toUnit(
+            positionRange.length() * i / serial.rows() + positionRange.min());
+        x[1] = velocityRange.toUnit(
+            velocityRange.length() * j / serial.cols() + velocityRange.min());
+        Assert::assertPasses(serial.at(i, j) == weights.dot(workers[1]->projector->project(&x)));
+      }
+    }
+  }
+  for (int k = 0; k < nbWorkers; k++)
+    delete workers[k];
+}
+
+void ValueFunctionSurfaceTest::testObservations()
+{
+  Random<double> random;
+  PVector<double> weights(10001);
+  for (int i = 0; i < weights.dimension(); i++)
+    weights[i] = random.nextReal();
+  std::vector<SurfaceWorker*> workers;
+  std::vector<ValueEvaluator<double>*> evaluators;
+  for (int k = 0; k < 3; k++)
+  {
+    workers.push_back(new SurfaceWorker(&weights));
+    evaluators.push_back(workers[k]->evaluator);
+  }
+  std::vector<const Vector<double>*> observations;
+  for (int i = 0; i < 1001; i++)
+  {
+    PVector<double>* x = new PVector<double>(2);
+    x->at(0) = random.nextReal();
+    x->at(1) = random.nextReal();
+    observations.push_back(x);
+  }
+  std::vector<double> out(observations.size());
+  ValueFunctionSurface<double> surface(evaluators, 2);
+  surface.evaluate(observations, &out[0]);
+  for (size_t i = 0; i < observations.size(); i++)
+  {
+    Assert::assertPasses(out[i] == weights.dot(workers[0]->projector->project(observations[i])));
+    delete observations[i];
+  }
+  for (int k = 0; k < 3; k++)
+    delete workers[k];
+}
+
+void ValueFunctionSurfaceTest::testPersist()
+{
+  PVector<double> weights(10001);
+  for (int i = 0; i < weights.dimension(); i++)
+    weights[i] = 1.0;
+  SurfaceWorker worker(&weights);
+  std::vector<ValueEvaluator<double>*> evaluators(1, worker.evaluator);
+  ValueFunctionSurface<double> surface(evaluators, 2, 10, 20);
+  Range<double> range(0, 1);
+  surface.evaluateGrid(&range, &range);
+  surface.persist("visualization/valueFunctionSurface.bin", true);
+
+  std::ifstream in("visualization/valueFunctionSurface.bin", std::ios::binary);
+  int32_t header[2];
+  in.read(reinterpret_cast<char*>(header), sizeof(header));
+  Assert::assertPasses(header[0] == 10 && header[1] == 20);
+  std::vector<double> values(10 * 20);
+  in.read(reinterpret_cast<char*>(&values[0]), values.size() * sizeof(double));
+  Assert::assertPasses(in.good());
+  for (int i = 0; i < 10 * 20; i++)
+  {
+    Assert::assertPasses(values[i] == surface.data()[i]);
+    // At most 10 tilings and the bias unit, less on hashing collisions
+    Assert::assertPasses(values[i] > 1.0 && values[i] <= 11.0);
+  }
+  in.close();
+  std::remove("visualization/valueFunctionSurface.bin");
+}
+
+// The runner's grid, with the agent serially or with one evaluator per worker
+void ValueFunctionSurfaceTest::testRunnerValueFunction()
+{
+  // The same seed as the hashing of the workers
+  Random<double> random, hashingRandom(0);
+  MountainCar<double> problem(&random);
+  MurmurHashing<double> hashing(&hashingRandom, 10000);
+  TileCoderHashing<double> projector(&hashing, problem.dimension(), 10, 10, true);
+  StateActionTilings<double> toStateAction(&projector, problem.getDiscreteActions());
+  ATrace<double> critice(projector.dimension());
+  GTDLambda<double> critic(0.1, 0.001, 0.99, 0.0, &critice);
+  BoltzmannDistribution<double> target(&random, problem.getDiscreteActions(),
+      projector.dimension());
+  ATrace<double> actore(projector.dimension());
+  Traces<double> actoreTraces;
+  actoreTraces.push_back(&actore);
+  ActorLambdaOffPolicy<double> actor(0.1, 0.99, 0.0, &target, &actoreTraces);
+  RandomPolicy<double> behavior(&random, problem.getDiscreteActions());
+  OffPAC<double> control(&behavior, &critic, &actor, &toStateAction, &projector);
+  LearnerAgent<double> agent(&control);
+  RLRunner<double> runner(&agent, &problem, 5000);
+
+  Vector<double>* weights = control.predictor()->weights();
+  Random<double> weightsRandom;
+  for (int i = 0; i < weights->dimension(); i++)
+    weights->setEntry(i, weightsRandom.nextNormalGaussian());
+
+  std::vector<SurfaceWorker*> workers;
+  std::vector<ValueEvaluator<double>*> evaluators;
+  for (int k = 0; k < std::max(2, ValueFunctionSurface<double>::nbHardwareWorkers()); k++)
+  {
+    workers.push_back(new SurfaceWorker(weights));
+    evaluators.push_back(workers[k]->evaluator);
+  }
+  // 0, 0.1, ..., 9.9 in both variables by default, up to 10 when inclusive
+  for (int inclusive = 0; inclusive < 2; inclusive++)
+  {
+    const int nbPoints = inclusive ? 101 : 100;
+    runner.setInclusiveValueFunction(inclusive);
+    runner.computeValueFunction("visualization/valueFunctionSerial.txt");
+    runner.computeValueFunction(evaluators, "visualization/valueFunctionParallel.txt");
+
+    std::ifstream serial("visualization/valueFunctionSerial.txt");
+    std::ifstream parallel("visualization/valueFunctionParallel.txt");
+    std::string serialLine, parallelLine;
+    int nbLines = 0;
+    while (std::getline(serial, serialLine))
+    {
+      Assert::assertPasses(std::getline(parallel, parallelLine) && serialLine == parallelLine);
+      std::istringstream values(serialLine);
+      int nbValues = 0;
+      double value;
+      while (values >> value)
+        ++nbValues;
+      Assert::assertPasses(nbValues == nbPoints);
+      ++nbLines;
+    }
+    Assert::assertPasses(nbLines == nbPoints && !std::getline(parallel, parallelLine));
+    serial.close();
+    parallel.close();
+    std::remove("visualization/valueFunctionSerial.txt");
+    std::remove("visualization/valueFunctionParallel.txt");
+  }
+  for (size_t k = 0; k < workers.size(); k++)
+    delete workers[k];
+}
+
+void ValueFunctionSurfaceTest::run()
+{
+  testParallelGrid();
+  testObservations();
+  testPersist();
+  testRunnerValueFunction();
+}
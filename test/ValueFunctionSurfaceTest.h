@@ -0,0 +1,48 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ValueFunctionSurfaceTest.h
+ */
+
+#ifndef VALUEFUNCTIONSURFACETEST_H_
+#define VALUEFUNCTIONSURFACETEST_H_
+
+#include "Test.h"
+#include "ValueFunctionSurface.h"
+#include "Timer.h"
+
+RLLIB_TEST(ValueFunctionSurfaceTest)
+
+class ValueFunctionSurfaceTest: public ValueFunctionSurfaceTestBase
+{
+  public:
+    ValueFunctionSurfaceTest()
+    {
+    }
+
+    virtual ~ValueFunctionSurfaceTest()
+    {
+    }
+
+    void run();
+
+  private:
+    void testParallelGrid();
+    void testObservations();
+    void testPersist();
+    void testRunnerValueFunction();
+};
+
+#endif /* VALUEFUNCTIONSURFACETEST_H_ */
@@ -0,0 +1,262 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * VirtualMemoryTest.cpp
+ */
+
+#include "VirtualMemoryTest.h"
+
+RLLIB_TEST_MAKE(VirtualMemoryTest)
+
+void VirtualMemoryTest::testPagedStorage()
+{
+  const size_t page = ResidentMemory::pageSize();
+  const int capacity = 1 << 24; // 128 MB
+  PVector<double> v(capacity, PagedStorage<double>::getInstance());
+  Assert::assertPasses(v.isOwner() && v.getStorage() == PagedStorage<double>::getInstance());
+  Assert::assertPasses(ResidentMemory::of(&v) == 0);
+  Assert::assertPasses(v[0] == 0.0 && v[capacity - 1] == 0.0);
+  Assert::assertPasses(ResidentMemory::of(&v) <= 2 * page);
+
+  const int stride = capacity / 100;
+  for (int i = 0; i < capacity; i += stride)
+    v[i] = 1.0;
+  const size_t written = ResidentMemory::written(&v);
+  cout << "## paged written(bytes)=" << written << " of " << capacity * sizeof(double) << endl;
+  Assert::assertPasses(written == 101 * page);
+  Assert::assertPasses(v.sum() == 101.0);
+
+  v.clear();
+  Assert::assertPasses(ResidentMemory::of(&v) == 0 && v.sum() == 0.0);
+  v[7] = 2.0;
+  Assert::assertPasses(v[7] == 2.0 && v.l1Norm() == 2.0);
+
+  // Below a page, on the heap
+  PVector<double> w(10, PagedStorage<double>::getInstance());
+  w[9] = 1.0;
+  w.clear();
+  Assert::assertPasses(w.sum() == 0.0);
+  // Copies are in the default storage
+  PVector<double> u(v);
+  Assert::assertPasses(u.getStorage() == Storage<double>::getDefault() && u[7] == 2.0);
+}
+
+void VirtualMemoryTest::testPagedMountainCar3D()
+{
+  // The weights of the learners constructed from now on are paged
+  Storage<double>::setDefault(PagedStorage<double>::getInstance());
+  Random<double> random;
+  RLProblem<double>* problem = new MountainCar3D<double>(&random);
+  Hashing<double>* hashing = new MurmurHashing<double>(&random, 1 << 24);
+  Projector<double>* projector = new TileCoderHashing<double>(hashing, problem->dimension(), 10,
+      10, true);
+  StateToStateAction<double>* toStateAction = new StateActionTilings<double>(projector,
+      problem->getDiscreteActions());
+  Trace<double>* e = new RTrace<double>(projector->dimension());
+  Sarsa<double>* sarsa = new Sarsa<double>(0.1 / projector->vectorNorm(), 0.99, 0.3, e);
+  Policy<double>* acting = new EpsilonGreedy<double>(&random, problem->getDiscreteActions(),
+      sarsa, 0.1);
+  OnPolicyControlLearner<double>* control = new SarsaControl<double>(acting, toStateAction,
+      sarsa);
+  RLAgent<double>* agent = new LearnerAgent<double>(control);
+  RLRunner<double>* sim = new RLRunner<double>(agent, problem, 5000);
+  sim->setVerbose(false);
+  Storage<double>::setDefault(0);
+
+  const DenseVector<double>* q = RTTI<double>::denseVector(sarsa->weights());
+  Assert::assertPasses(q->getStorage() == PagedStorage<double>::getInstance());
+  const size_t bytes = q->dimension() * sizeof(double);
+  for (int t = 0; t < 2000; t++)
+    sim->step();
+  const size_t written = ResidentMemory::written(q);
+  cout << "## MountainCar3D weights written(bytes)=" << written << " mapped(bytes)="
+      << ResidentMemory::of(q) << " of " << bytes << " process resident(bytes)="
+      << ResidentMemory::process() << endl;
+  Assert::assertPasses(written > 0 && written < bytes / 2);
+  // reset() releases the pages
+  control->reset();
+  Assert::assertPasses(ResidentMemory::of(q) == 0 && q->l1Norm() == 0.0);
+
+  delete sim;
+  delete agent;
+  delete control;
+  delete acting;
+  delete sarsa;
+  delete e;
+  delete toStateAction;
+  delete projector;
+  delete hashing;
+  delete problem;
+}
+
+// Random access sparse updates, as a learner on a hashed memory
+double VirtualMemoryTest::sparseUpdates(Storage<double>* weightsStorage,
+    Storage<int>* indexesStorage, double& elapsed)
+{
+  const int capacity = 1 << 24;
+  PVector<double> q(capacity, weightsStorage);
+  SVector<double> x(capacity, 1000, indexesStorage);
+  Random<double> random(0);
+  double v = 0;
+  // Faults the pages in before the clock
+  static_cast<Vector<double>&>(q).set(0.0);
+  Timer timer;
+  timer.start();
+  for (int t = 0; t < 2000; t++)
+  {
+    x.clear();
+    for (int i = 0; i < 1000; i++)
+      x.setEntry(random.nextInt(capacity), 1.0);
+    v += q.dot(&x);
+    q.addToSelf(0.01, &x);
+  }
+  timer.stop();
+  elapsed = timer.getElapsedTimeInMilliSec();
+  cout << "## process huge pages(bytes)=" << ResidentMemory::hugePages() << endl;
+  return v + q.sum();
+}
+
+void VirtualMemoryTest::testHugePages()
+{
+  HugePageStorage<double>* weightsStorage = HugePageStorage<double>::getInstance();
+  HugePageStorage<int>* indexesStorage = HugePageStorage<int>::getInstance();
+  {
+    PVector<double> v(1 << 20, weightsStorage);
+    Assert::assertPasses(uintptr_t(v.getValues()) % HugePageStorage<double>::hugePageSize() == 0);
+    Assert::assertPasses(v.sum() == 0.0);
+    v[(1 << 20) - 1] = 1.0;
+    v.clear();
+    Assert::assertPasses(v.l1Norm() == 0.0);
+    SVector<double> x(1 << 20, 10, indexesStorage);
+    Assert::assertPasses(x.getStorage() == indexesStorage && x.getEntry(7) == 0.0);
+  }
+
+  double smallPagesTime, hugePagesTime;
+  const double smallPages = sparseUpdates(0, 0, smallPagesTime);
+  const double hugePages = sparseUpdates(weightsStorage, indexesStorage, hugePagesTime);
+  cout << "## sparse updates small pages(ms)=" << smallPagesTime << " huge pages(ms)="
+      << hugePagesTime << endl;
+  Assert::assertPasses(smallPages == hugePages);
+}
+
+void VirtualMemoryTest::testMappedPVector()
+{
+  const char* f = "visualization/mapped_weights.bin";
+  const char* g = "visualization/mapped_weights_copy.bin";
+  std::remove(f);
+  const int capacity = 1 << 20;
+  {
+    MappedPVector<double> v(f, capacity);
+    Assert::assertPasses(v.dimension() == capacity && v.getFile()->isShared());
+    Assert::assertPasses(v.l1Norm() == 0.0);
+    for (int i = 0; i < capacity; i += 1000)
+      v[i] = i;
+    v.persist(f); // msync
+  }
+  // The file is in the format of persist(), and the values are there at once
+  PVector<double> w;
+  w.resurrect(f);
+  MappedPVector<double> v(f);
+  Assert::assertPasses(w.dimension() == capacity && v.dimension() == capacity);
+  Assert::assertPasses(v[1000] == 1000.0 && w[1000] == 1000.0 && v.sum() == w.sum());
+
+  // Private: the writes are copies
+  {
+    MappedPVector<double> p(f, capacity, false);
+    p[1000] = -1.0;
+    Assert::assertPasses(p[1000] == -1.0 && v[1000] == 1000.0);
+    p.clear();
+    Assert::assertPasses(p.l1Norm() == 0.0 && v[2000] == 2000.0);
+    // Dropping the copies reads the file again
+    p.resurrect(f);
+    Assert::assertPasses(p[2000] == 2000.0);
+    p[2000] = 1.0;
+    p.persist(g);
+  }
+  // Resurrecting maps the other file
+  v.resurrect(g);
+  Assert::assertPasses(v.getFile()->isFile(g) && v[2000] == 1.0 && v[3000] == 3000.0);
+  v[3000] = 0.5;
+  v.flush();
+  w.resurrect(g);
+  Assert::assertPasses(w[3000] == 0.5);
+  // Shared: the pages are deallocated from the file
+  v.clear();
+  Assert::assertPasses(v.l1Norm() == 0.0);
+  w.resurrect(g);
+  Assert::assertPasses(w.l1Norm() == 0.0);
+
+  std::remove(f);
+  std::remove(g);
+}
+
+void VirtualMemoryTest::testMappedLearner()
+{
+  const char* f = "visualization/mapped_sarsa.bin";
+  std::remove(f);
+  double l1Norm;
+  for (int run = 0; run < 2; run++)
+  {
+    Random<double> random;
+    RLProblem<double>* problem = new MountainCar<double>;
+    Hashing<double>* hashing = new MurmurHashing<double>(&random, 100000);
+    Projector<double>* projector = new TileCoderHashing<double>(hashing, problem->dimension(), 10,
+        10, true);
+    StateToStateAction<double>* toStateAction = new StateActionTilings<double>(projector,
+        problem->getDiscreteActions());
+    Trace<double>* e = new RTrace<double>(projector->dimension());
+    Sarsa<double>* sarsa = new Sarsa<double>(0.1 / projector->vectorNorm(), 0.99, 0.3, e);
+    // The weights are those of the file, from a checkpoint when there is one
+    MappedFile<double> file(f, projector->dimension());
+    RTTI<double>::denseVector(sarsa->weights())->bind(file.getValues(), false);
+    if (run == 0)
+    {
+      Policy<double>* acting = new EpsilonGreedy<double>(&random, problem->getDiscreteActions(),
+          sarsa, 0.0);
+      OnPolicyControlLearner<double>* control = new SarsaControl<double>(acting, toStateAction,
+          sarsa);
+      RLAgent<double>* agent = new LearnerAgent<double>(control);
+      RLRunner<double>* sim = new RLRunner<double>(agent, problem, 5000);
+      sim->setVerbose(false);
+      for (int t = 0; t < 5000; t++)
+        sim->step();
+      file.flush();
+      l1Norm = sarsa->weights()->l1Norm();
+      Assert::assertPasses(l1Norm > 0);
+      delete sim;
+      delete agent;
+      delete control;
+      delete acting;
+    }
+    else
+      Assert::assertPasses(sarsa->weights()->l1Norm() == l1Norm);
+    delete sarsa;
+    delete e;
+    delete toStateAction;
+    delete projector;
+    delete hashing;
+    delete problem;
+  }
+  std::remove(f);
+}
+
+void VirtualMemoryTest::run()
+{
+  testPagedStorage();
+  testPagedMountainCar3D();
+  testHugePages();
+  testMappedPVector();
+  testMappedLearner();
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2015 Saminda Abeyruwan (saminda@cs.miami.edu)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * VirtualMemoryTest.h
+ */
+
+#ifndef VIRTUALMEMORYTEST_H_
+#define VIRTUALMEMORYTEST_H_
+
+#include "Test.h"
+#include "VirtualMemory.h"
+#include "Timer.h"
+
+RLLIB_TEST(VirtualMemoryTest)
+
+class VirtualMemoryTest: public VirtualMemoryTestBase
+{
+  public:
+    VirtualMemoryTest()
+    {
+    }
+
+    virtual ~VirtualMemoryTest()
+    {
+    }
+
+    void run();
+
+  private:
+    void testPagedStorage();
+    void testPagedMountainCar3D();
+    void testHugePages();
+    void testMappedPVector();
+    void testMappedLearner();
+    double sparseUpdates(Storage<double>* weightsStorage, Storage<int>* indexesStorage,
+        double& elapsed);
+};
+
+#endif /* VIRTUALMEMORYTEST_H_ */
@@ -22,6 +22,8 @@
 #ifndef RK4_H_
 #define RK4_H_
 
+#include <array>
+#include <cmath>
 #include <algorithm>
 #include "Vector.h"
 #include "Action.h"
@@ -129,4 +131,213 @@ class RK4
         Vector<double>* x_dot) =0;
 };
 
+/**
+ * Compile-time sized integrators. The state is a std::array<double, N> and the derivative is a
+ * functor, called as f(time, x, x_dot), that the compiler inlines in the stages. There is no
+ * allocation and no virtual call per step. The functor carries the inputs of the dynamics (e.g.,
+ * the action), which stay constant during a step.
+ */
+template<int N, typename Derivative>
+class RungeKutta4
+{
+  public:
+    typedef std::array<double, N> State;
+
+  protected:
+    Derivative f;
+    double timeIncrement;
+    double time;
+    int timeSteps;
+    State state;
+
+  public:
+    RungeKutta4(const Derivative& f, const double& timeIncrement) :
+        f(f), timeIncrement(timeIncrement)
+    {
+      state.fill(0.0);
+      initialize();
+    }
+
+    void initialize()
+    {
+      time = 0;
+      timeSteps = 0;
+    }
+
+    State& vec()
+    {
+      return state;
+    }
+
+    const State& vec() const
+    {
+      return state;
+    }
+
+    Derivative& derivative()
+    {
+      return f;
+    }
+
+    double getTime() const
+    {
+      return time;
+    }
+
+    int getTimeSteps() const
+    {
+      return timeSteps;
+    }
+
+    void step()
+    {
+      const double h = timeIncrement;
+      State k1, k2, k3, k4, u;
+      f(time, state, k1);
+      for (int i = 0; i < N; i++)
+        u[i] = state[i] + h / 2.0 * k1[i];
+      f(time + h / 2.0, u, k2);
+      for (int i = 0; i < N; i++)
+        u[i] = state[i] + h / 2.0 * k2[i];
+      f(time + h / 2.0, u, k3);
+      for (int i = 0; i < N; i++)
+        u[i] = state[i] + h * k3[i];
+      f(time + h, u, k4);
+      for (int i = 0; i < N; i++)
+        state[i] += h / 6.0 * (k1[i] + 2.0 * (k2[i] + k3[i]) + k4[i]);
+      time += h;
+      ++timeSteps;
+    }
+
+    // Integrates nbIncrements time increments with the same inputs
+    void step(const int& nbIncrements)
+    {
+      for (int i = 0; i < nbIncrements; i++)
+        step();
+    }
+};
+
+/**
+ * Dormand-Prince 5(4) embedded Runge-Kutta. A call to step() integrates over timeIncrement with
+ * as many internal steps as the tolerances require, i.e., it only subdivides timeIncrement: the
+ * inputs of the dynamics (e.g., the action) change at the sampling instants, so no internal step
+ * crosses one. When the inputs stay constant over several increments (e.g., an action held for
+ * two of them), step(nbIncrements) integrates the whole interval in one call, whose internal steps
+ * may span increments. The internal step size is kept across calls, such that smooth dynamics take
+ * a single internal step per call and fast transients are refined with smaller ones.
+ */
+template<int N, typename Derivative>
+class DormandPrince: public RungeKutta4<N, Derivative>
+{
+  public:
+    typedef RungeKutta4<N, Derivative> Base;
+    typedef typename Base::State State;
+
+  protected:
+    double absoluteTolerance;
+    double relativeTolerance;
+    double minimumStep;
+    double h;
+    int nbAccepted;
+    int nbRejected;
+
+  public:
+    DormandPrince(const Derivative& f, const double& timeIncrement,
+        const double& absoluteTolerance = 1e-6, const double& relativeTolerance = 1e-6) :
+        RungeKutta4<N, Derivative>(f, timeIncrement), absoluteTolerance(absoluteTolerance), //
+        relativeTolerance(relativeTolerance), minimumStep(timeIncrement * 1e-6), h(timeIncrement), //
+        nbAccepted(0), nbRejected(0)
+    {
+    }
+
+    int getNbAccepted() const
+    {
+      return nbAccepted;
+    }
+
+    int getNbRejected() const
+    {
+      return nbRejected;
+    }
+
+    void step()
+    {
+      step(1);
+    }
+
+    void step(const int& nbIncrements)
+    {
+      static const double a21 = 1.0 / 5.0;
+      static const double a31 = 3.0 / 40.0, a32 = 9.0 / 40.0;
+      static const double a41 = 44.0 / 45.0, a42 = -56.0 / 15.0, a43 = 32.0 / 9.0;
+      static const double a51 = 19372.0 / 6561.0, a52 = -25360.0 / 2187.0, a53 = 64448.0 / 6561.0,
+          a54 = -212.0 / 729.0;
+      static const double a61 = 9017.0 / 3168.0, a62 = -355.0 / 33.0, a63 = 46732.0 / 5247.0,
+          a64 = 49.0 / 176.0, a65 = -5103.0 / 18656.0;
+      static const double b1 = 35.0 / 384.0, b3 = 500.0 / 1113.0, b4 = 125.0 / 192.0, b5 =
+          -2187.0 / 6784.0, b6 = 11.0 / 84.0;
+      // Difference between the 5th and the 4th order solutions
+      static const double e1 = 71.0 / 57600.0, e3 = -71.0 / 16695.0, e4 = 71.0 / 1920.0, e5 =
+          -17253.0 / 339200.0, e6 = 22.0 / 525.0, e7 = -1.0 / 40.0;
+
+      State& y = Base::state;
+      State k1, k2, k3, k4, k5, k6, k7, u;
+      const double end = Base::time + nbIncrements * Base::timeIncrement;
+      double t = Base::time;
+      Base::f(t, y, k1);
+      while (end - t > minimumStep)
+      {
+        const double hs = std::min(h, end - t);
+        for (int i = 0; i < N; i++)
+          u[i] = y[i] + hs * a21 * k1[i];
+        Base::f(t + hs / 5.0, u, k2);
+        for (int i = 0; i < N; i++)
+          u[i] = y[i] + hs * (a31 * k1[i] + a32 * k2[i]);
+        Base::f(t + hs * 3.0 / 10.0, u, k3);
+        for (int i = 0; i < N; i++)
+          u[i] = y[i] + hs * (a41 * k1[i] + a42 * k2[i] + a43 * k3[i]);
+        Base::f(t + hs * 4.0 / 5.0, u, k4);
+        for (int i = 0; i < N; i++)
+          u[i] = y[i] + hs * (a51 * k1[i] + a52 * k2[i] + a53 * k3[i] + a54 * k4[i]);
+        Base::f(t + hs * 8.0 / 9.0, u, k5);
+        for (int i = 0; i < N; i++)
+          u[i] = y[i] + hs * (a61 * k1[i] + a62 * k2[i] + a63 * k3[i] + a64 * k4[i] + a65 * k5[i]);
+        Base::f(t + hs, u, k6);
+        for (int i = 0; i < N; i++)
+          u[i] = y[i] + hs * (b1 * k1[i] + b3 * k3[i] + b4 * k4[i] + b5 * k5[i] + b6 * k6[i]);
+        Base::f(t + hs, u, k7);
+
+        double error = 0;
+        for (int i = 0; i < N; i++)
+        {
+          const double e = hs
+              * (e1 * k1[i] + e3 * k3[i] + e4 * k4[i] + e5 * k5[i] + e6 * k6[i] + e7 * k7[i]);
+          const double scale = absoluteTolerance
+              + relativeTolerance * std::max(std::abs(y[i]), std::abs(u[i]));
+          error += (e / scale) * (e / scale);
+        }
+        error = std::sqrt(error / N);
+
+        const double factor = error > 0 ?
+            std::min(5.0, std::max(0.2, 0.9 * std::pow(error, -0.2))) : 5.0;
+        if (error <= 1.0 || hs <= minimumStep)
+        {
+          y = u;
+          k1 = k7; // First same as last
+          t += hs;
+          ++nbAccepted;
+          // A step shortened to reach the end of the interval does not shrink the next ones
+          h = (hs < h && factor >= 1.0) ? std::max(h, hs * factor) : hs * factor;
+        }
+        else
+        {
+          ++nbRejected;
+          h = hs * factor;
+        }
+      }
+      Base::time = end;
+      Base::timeSteps += nbIncrements;
+    }
+};
+
 #endif /* RK4_H_ */
@@ -130,6 +130,10 @@ void ExtraTree::Train(Dataset* data, bool overwrite, bool normalize)
     rtLeaf::mPlotCutsG.insert(pair<int, string> (i, string(initg)));
   }
 #endif
+  if (root != NULL)
+  {
+    delete root;
+  }
   root = BuildExtraTree(data);
 #ifdef SPLIT_ANALYSIS
   ofstream out_plot("plot.txt");
@@ -22,6 +22,7 @@
 #define THREADS 8 //threads >= 1
 
 #include <vector>
+#include <functional>
 #include <iostream>
 #include <unistd.h>
 
@@ -154,6 +155,53 @@ void ExtraTreeEnsemble::Evaluate(Tuple* input, float& output)
   output = mSum / (float) mNumTrees;
 }
 
+void ExtraTreeEnsemble::Evaluate(const vector<Tuple*>& inputs, float* outputs,
+    unsigned int num_threads)
+{
+  unsigned int size = inputs.size();
+  if (num_threads <= 1 || size < 2 * num_threads)
+  {
+    workerEvaluateBatch(&inputs, outputs, 0, size);
+    return;
+  }
+  vector<thread*> workerThread;
+  unsigned int block = (size + num_threads - 1) / num_threads;
+  for (unsigned int begin = block; begin < size; begin += block)
+  {
+    workerThread.push_back(
+        new thread(bind(&ExtraTreeEnsemble::workerEvaluateBatch, this, &inputs, outputs, begin,
+            min(begin + block, size))));
+  }
+  workerEvaluateBatch(&inputs, outputs, 0, min(block, size));
+  for (unsigned int i = 0; i < workerThread.size(); i++)
+  {
+    workerThread[i]->join();
+    delete workerThread[i];
+  }
+}
+
+void ExtraTreeEnsemble::workerEvaluateBatch(const vector<Tuple*>* inputs, float* outputs,
+    unsigned int begin, unsigned int end)
+{
+  float out;
+  for (unsigned int i = begin; i < end; i++)
+  {
+    outputs[i] = 0.0;
+  }
+  for (unsigned int t = 0; t < mEnsemble.size(); t++)
+  {
+    for (unsigned int i = begin; i < end; i++)
+    {
+      mEnsemble[t]->Evaluate(inputs->at(i), out);
+      outputs[i] += out;
+    }
+  }
+  for (unsigned int i = begin; i < end; i++)
+  {
+    outputs[i] /= (float) mNumTrees;
+  }
+}
+
 void ExtraTreeEnsemble::workerEvaluateSingleOutput(unsigned int index, Tuple* input)
 {
   float out;
@@ -87,6 +87,17 @@ class ExtraTreeEnsemble: public Regressor
      */
     virtual void Evaluate(Tuple* input, float& output);
 
+    /**
+     * Evaluates a batch of inputs. Unlike the single input evaluations, this method does not
+     * use any shared accumulator, hence the inputs are split in contiguous blocks among
+     * num_threads threads. Each thread walks every tree over its whole block, which keeps the
+     * nodes of a tree in cache.
+     * @param  inputs The input data on which the model is evaluated
+     * @param  outputs The average output of the trees for each input
+     * @param  num_threads The number of threads (1 evaluates on the calling thread)
+     */
+    void Evaluate(const vector<Tuple*>& inputs, float* outputs, unsigned int num_threads = 1);
+
     /**
      *
      */
@@ -144,6 +155,16 @@ class ExtraTreeEnsemble: public Regressor
      * @param  input The tuple
      */
     void workerEvaluateTuple(unsigned int index, Tuple* input);
+
+    /**
+     * Single thread of the batch evaluate function
+     * @param  inputs The input data
+     * @param  outputs The average outputs
+     * @param  begin The first input of the block
+     * @param  end One past the last input of the block
+     */
+    void workerEvaluateBatch(const vector<Tuple*>* inputs, float* outputs, unsigned int begin,
+        unsigned int end);
 };
 
 }
@@ -8,13 +8,26 @@
 
 using namespace RLLibViz;
 
-ModelBase::ModelBase()
+ModelBase::ModelBase() :
+    controlValueEvaluator(new ControlValueEvaluator<double>)
 {
   valueFunction2D.resize(100, 100);
+  std::vector<ValueEvaluator<double>*> evaluators(1, controlValueEvaluator);
+  controlValueFunctionSurface = new ValueFunctionSurface<double>(evaluators, 2,
+      valueFunction2D.rows(), valueFunction2D.cols());
 }
 
 ModelBase::~ModelBase()
 {
+  delete controlValueFunctionSurface;
+  delete controlValueEvaluator;
+}
+
+ValueFunctionSurface<double>* ModelBase::getValueFunctionSurface(
+    const RLLib::Control<double>* control, const int& index)
+{
+  controlValueEvaluator->setControl(control);
+  return controlValueFunctionSurface;
 }
 
 void ModelBase::updateValueFunction(Window* window, const RLLib::Control<double>* control,
@@ -24,22 +37,10 @@ void ModelBase::updateValueFunction(Window* window, const RLLib::Control<double>
   // Value function
   if (isEndingOfEpisode && output->o_tp1->dimension() == 2 /*FixMe*/)
   {
-    RLLib::PVector<double> stateVariable(2);
-    const Range<double>* positionRange = ranges->at(0);
-    const Range<double>* velocityRange = ranges->at(1);
-
-    for (int position = 0; position < valueFunction2D.rows(); position++)
-    {
-      for (int velocity = 0; velocity < valueFunction2D.cols(); velocity++)
-      {
-        stateVariable[0] = positionRange->toUnit(
-            positionRange->length() * position / valueFunction2D.cols() + positionRange->min());
-        stateVariable[1] = velocityRange->toUnit(
-            velocityRange->length() * velocity / valueFunction2D.rows() + velocityRange->min());
-        double v = control->computeValueFunction(&stateVariable);
-        valueFunction2D(position, velocity) = v;
-      }
-    }
+    ValueFunctionSurface<double>* surface = getValueFunctionSurface(control, index);
+    surface->evaluateGrid(ranges->at(0), ranges->at(1), true);
+    valueFunction2D = Map<const Matrix<double, Dynamic, Dynamic, RowMajor> >(surface->data(),
+        surface->rows(), surface->cols());
     emit signal_add(window->valueFunctionVector[index], valueFunction2D);
     emit signal_draw(window->valueFunctionVector[index]);
   }
@@ -22,6 +22,8 @@
 #include "StateToStateAction.h"
 #include "RL.h"
 #include "FourierBasis.h"
+#include "ValueFunctionSurface.h"
+#include "Snapshot.h"
 //
 #include "Eigen/Dense"
 
@@ -41,6 +43,9 @@ class ModelBase: public QObject
     MatrixXd valueFunction2D;
     typedef std::map<int, RLRunner<double>*> Simulators;
     Simulators simulators;
+    // By default, the value function is evaluated serially with the control
+    ControlValueEvaluator<double>* controlValueEvaluator;
+    ValueFunctionSurface<double>* controlValueFunctionSurface;
 
   public:
     explicit ModelBase();
@@ -60,6 +65,10 @@ class ModelBase: public QObject
     virtual void updateValueFunction(Window* window, const RLLib::Control<double>* control,
         const TRStep<double>* output, const RLLib::Ranges<double>* ranges, const bool& isEndingOfEpisode,
         const int& index);
+    // Models with thread-safe evaluators (e.g., per worker projectors over a weight snapshot)
+    // return their own surface
+    virtual ValueFunctionSurface<double>* getValueFunctionSurface(
+        const RLLib::Control<double>* control, const int& index);
 
 };
 
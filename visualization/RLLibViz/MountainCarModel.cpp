@@ -13,6 +13,8 @@ MountainCarModel::MountainCarModel()
 {
   // RLLib:
   random = new Random<double>;
+  // Same seed, hence the same hashes as the learner
+  evaluationRandom = new Random<double>;
   behaviourEnvironment = new MountainCar<double>;
   evaluationEnvironment = new MountainCar<double>;
   hashing = new MurmurHashing<double>(random, 1000000);
@@ -41,8 +43,33 @@ MountainCarModel::MountainCarModel()
   behavior = new RandomPolicy<double>(random, behaviourEnvironment->getDiscreteActions());
   control = new OffPAC<double>(behavior, critic, actor, toStateAction, projector);
 
+  snapshots = new SnapshotChannel<double>;
+  snapshots->add(target->parameters());
+  snapshots->add(control->predictor()->weights());
+
+  evaluationHashing = new MurmurHashing<double>(evaluationRandom, 1000000);
+  evaluationProjector = new TileCoderHashing<double>(evaluationHashing,
+      evaluationEnvironment->dimension(), 10, 10, true);
+  evaluationToStateAction = new StateActionTilings<double>(evaluationProjector,
+      evaluationEnvironment->getDiscreteActions());
+  evaluationTarget = new BoltzmannDistribution<double>(evaluationRandom,
+      evaluationEnvironment->getDiscreteActions(), evaluationProjector->dimension());
+  evaluationControl = new SnapshotControl<double>(snapshots, evaluationTarget,
+      evaluationToStateAction, evaluationProjector);
+  for (int k = 0; k < ValueFunctionSurface<double>::nbHardwareWorkers(); k++)
+  {
+    surfaceRandoms.push_back(new Random<double>);
+    surfaceHashings.push_back(new MurmurHashing<double>(surfaceRandoms[k], 1000000));
+    surfaceProjectors.push_back(new TileCoderHashing<double>(surfaceHashings[k],
+        evaluationEnvironment->dimension(), 10, 10, true));
+    surfaceEvaluators.push_back(new LinearValueEvaluator<double>(surfaceProjectors[k],
+        evaluationControl->weights()));
+  }
+  evaluationValueFunctionSurface = new ValueFunctionSurface<double>(surfaceEvaluators, 2,
+      valueFunction2D.rows(), valueFunction2D.cols());
+
   learningAgent = new LearnerAgent<double>(control);
-  evaluationAgent = new ControlAgent<double>(control);
+  evaluationAgent = new ControlAgent<double>(evaluationControl);
 
   learningRunner = new RLRunner<double>(learningAgent, behaviourEnvironment, 5000);
   evaluationRunner = new RLRunner<double>(evaluationAgent, evaluationEnvironment, 5000);
@@ -51,7 +78,6 @@ MountainCarModel::MountainCarModel()
 
   simulators.insert(std::make_pair(simulators.size(), learningRunner));
   simulators.insert(std::make_pair(simulators.size(), evaluationRunner));
-
 }
 
 MountainCarModel::~MountainCarModel()
@@ -74,33 +100,71 @@ MountainCarModel::~MountainCarModel()
   delete evaluationAgent;
   delete learningRunner;
   delete evaluationRunner;
+  delete evaluationControl;
+  delete evaluationTarget;
+  delete evaluationToStateAction;
+  delete evaluationProjector;
+  delete evaluationHashing;
+  delete evaluationRandom;
+  delete snapshots;
+  delete evaluationValueFunctionSurface;
+  for (size_t k = 0; k < surfaceEvaluators.size(); k++)
+  {
+    delete surfaceEvaluators[k];
+    delete surfaceProjectors[k];
+    delete surfaceHashings[k];
+    delete surfaceRandoms[k];
+  }
+}
+
+ValueFunctionSurface<double>* MountainCarModel::getValueFunctionSurface(
+    const RLLib::Control<double>* control, const int& index)
+{
+  // The snapshot only changes in refresh(), on this thread
+  if (control == evaluationControl)
+    return evaluationValueFunctionSurface;
+  return ModelBase::getValueFunctionSurface(control, index);
 }
 
 void MountainCarModel::doLearning(Window* window)
 {
-  for (Simulators::iterator i = simulators.begin(); i != simulators.end(); ++i)
-    i->second->step();
+  learningRunner->step();
+  // Never waits for the evaluation thread, and copies at most every 100 ms
+  snapshots->publishIfDue();
 
-  for (Simulators::iterator i = simulators.begin(); i != simulators.end(); ++i)
+  if (learningRunner->isEndingOfEpisode())
   {
-    if (i->second->isEndingOfEpisode())
-    {
-      emit signal_add(window->plotVector[i->first], Vec(i->second->timeStep, 0),
-          Vec(i->second->episodeR, 0));
-      emit signal_draw(window->plotVector[i->first]);
-    }
-
-    emit signal_add(window->problemVector[i->first],
-        Vec(i->second->getRLProblem()->getTRStep()->observation_tp1->getEntry(0),
-            i->second->getRLProblem()->getTRStep()->observation_tp1->getEntry(1)),
-        Vec(0.0, 0.0, 0.0, 1.0));
-    emit signal_draw(window->problemVector[i->first]);
+    emit signal_add(window->plotVector[0], Vec(learningRunner->timeStep, 0),
+        Vec(learningRunner->episodeR, 0));
+    emit signal_draw(window->plotVector[0]);
   }
 
-  updateValueFunction(window, control, evaluationEnvironment->getTRStep(),
-      evaluationEnvironment->getObservationRanges(), evaluationRunner->isEndingOfEpisode(), 1);
+  emit signal_add(window->problemVector[0],
+      Vec(behaviourEnvironment->getTRStep()->observation_tp1->getEntry(0),
+          behaviourEnvironment->getTRStep()->observation_tp1->getEntry(1)),
+      Vec(0.0, 0.0, 0.0, 1.0));
+  emit signal_draw(window->problemVector[0]);
 }
 
 void MountainCarModel::doEvaluation(Window* window)
-{ // FixMe: Sam
+{
+  // The first actions, before any snapshot, are those of the initial policy
+  evaluationControl->refresh();
+  evaluationRunner->step();
+
+  if (evaluationRunner->isEndingOfEpisode())
+  {
+    emit signal_add(window->plotVector[1], Vec(evaluationRunner->timeStep, 0),
+        Vec(evaluationRunner->episodeR, 0));
+    emit signal_draw(window->plotVector[1]);
+  }
+
+  emit signal_add(window->problemVector[1],
+      Vec(evaluationEnvironment->getTRStep()->observation_tp1->getEntry(0),
+          evaluationEnvironment->getTRStep()->observation_tp1->getEntry(1)),
+      Vec(0.0, 0.0, 0.0, 1.0));
+  emit signal_draw(window->problemVector[1]);
+
+  updateValueFunction(window, evaluationControl, evaluationEnvironment->getTRStep(),
+      evaluationEnvironment->getObservationRanges(), evaluationRunner->isEndingOfEpisode(), 1);
 }
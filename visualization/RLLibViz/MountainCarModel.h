@@ -54,6 +54,21 @@ class MountainCarModel: public ModelBase
     RLRunner<double>* learningRunner;
     RLRunner<double>* evaluationRunner;
 
+    // The evaluation thread acts with a snapshot of the learner, with its own projectors
+    SnapshotChannel<double>* snapshots;
+    Random<double>* evaluationRandom;
+    Hashing<double>* evaluationHashing;
+    Projector<double>* evaluationProjector;
+    StateToStateAction<double>* evaluationToStateAction;
+    PolicyDistribution<double>* evaluationTarget;
+    SnapshotControl<double>* evaluationControl;
+    // V of the evaluation control, with a hashing and a projector of the same seed per worker
+    std::vector<Random<double>*> surfaceRandoms;
+    std::vector<Hashing<double>*> surfaceHashings;
+    std::vector<Projector<double>*> surfaceProjectors;
+    std::vector<ValueEvaluator<double>*> surfaceEvaluators;
+    ValueFunctionSurface<double>* evaluationValueFunctionSurface;
+
   public:
     MountainCarModel();
     virtual ~MountainCarModel();
@@ -61,6 +76,8 @@ class MountainCarModel: public ModelBase
   protected:
     void doLearning(Window* window);
     void doEvaluation(Window* window);
+    ValueFunctionSurface<double>* getValueFunctionSurface(const RLLib::Control<double>* control,
+        const int& index);
 };
 
 }  // namespace RLLibViz
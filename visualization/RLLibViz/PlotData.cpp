@@ -0,0 +1,250 @@
+/*
+ * PlotData.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: sam
+ */
+
+#include "PlotData.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdint.h>
+
+using namespace RLLibViz;
+
+PlotData::Level::Level(const int& capacity, const int& nbSeries) :
+    capacity(capacity), nbSeries(nbSeries), head(0), size(0), nbPushed(0), xMin(capacity), //
+    xMax(capacity), y(2 * nbSeries * capacity), pendingCount(0), pendingXMin(0), pendingXMax(0), //
+    pendingY(2 * nbSeries)
+{
+}
+
+void PlotData::Level::push(const double& x0, const double& x1, const double* yMinMax)
+{
+  // The oldest bucket is overwritten once full
+  const int i = (head + size) % capacity;
+  xMin[i] = x0;
+  xMax[i] = x1;
+  std::copy(yMinMax, yMinMax + 2 * nbSeries, y.begin() + 2 * nbSeries * i);
+  if (size < capacity)
+    ++size;
+  else
+    head = (head + 1) % capacity;
+  ++nbPushed;
+}
+
+int PlotData::Level::index(const int& i) const
+{
+  return (head + i) % capacity;
+}
+
+PlotData::PlotData(const int& nbSeries, const int& capacity, const int& factor,
+    const int& nbLevels) :
+    nbSeries(nbSeries), capacity(capacity), factor(factor), nbPoints(0), bucket(2 * nbSeries), //
+    spillFile(0)
+{
+  for (int k = 0; k < nbLevels; k++)
+    levels.push_back(new Level(capacity, nbSeries));
+}
+
+PlotData::~PlotData()
+{
+  closeSpill();
+  for (size_t k = 0; k < levels.size(); k++)
+    delete levels[k];
+}
+
+void PlotData::add(const double& x, const double* ys)
+{
+  if (spillFile)
+  {
+    spillFile->write(reinterpret_cast<const char*>(&x), sizeof(double));
+    spillFile->write(reinterpret_cast<const char*>(ys), nbSeries * sizeof(double));
+  }
+  std::copy(ys, ys + nbSeries, bucket.begin());
+  std::copy(ys, ys + nbSeries, bucket.begin() + nbSeries);
+  push(0, x, x, &bucket[0]);
+  ++nbPoints;
+}
+
+void PlotData::add(const double& x, const double& y0, const double& y1)
+{
+  const double ys[2] = { y0, y1 };
+  add(x, ys);
+}
+
+void PlotData::clear()
+{
+  for (size_t k = 0; k < levels.size(); k++)
+  {
+    Level* level = levels[k];
+    level->head = level->size = level->pendingCount = 0;
+    level->nbPushed = 0;
+  }
+  nbPoints = 0;
+}
+
+void PlotData::push(const int& k, const double& x0, const double& x1, const double* yMinMax)
+{
+  Level* level = levels[k];
+  level->push(x0, x1, yMinMax);
+  if (k + 1 == int(levels.size()))
+    return;
+  // Merge into the pending bucket of the next level
+  if (level->pendingCount == 0)
+  {
+    level->pendingXMin = x0;
+    std::copy(yMinMax, yMinMax + 2 * nbSeries, level->pendingY.begin());
+  }
+  else
+  {
+    for (int s = 0; s < nbSeries; s++)
+    {
+      level->pendingY[s] = std::min(level->pendingY[s], yMinMax[s]);
+      level->pendingY[nbSeries + s] = std::max(level->pendingY[nbSeries + s],
+          yMinMax[nbSeries + s]);
+    }
+  }
+  level->pendingXMax = x1;
+  if (++level->pendingCount == factor)
+  {
+    level->pendingCount = 0;
+    push(k + 1, level->pendingXMin, level->pendingXMax, &level->pendingY[0]);
+  }
+}
+
+int PlotData::decimate(const int& nbColumns, std::vector<double>& xs,
+    std::vector<std::vector<double> >& ys) const
+{
+  xs.clear();
+  ys.resize(nbSeries);
+  for (int s = 0; s < nbSeries; s++)
+    ys[s].clear();
+  if (nbPoints == 0 || nbColumns <= 0)
+    return 0;
+
+  // The finest level that has never dropped a bucket, or else the coarsest
+  int k = 0;
+  while (k + 1 < int(levels.size()) && levels[k]->nbPushed > levels[k]->capacity)
+    ++k;
+  const Level* level = levels[k];
+  // The latest points, not yet merged into this level, are pending in the levels below
+  std::vector<const Level*> pending;
+  for (int j = k - 1; j >= 0; j--)
+  {
+    if (levels[j]->pendingCount)
+      pending.push_back(levels[j]);
+  }
+  const int nbBuckets = level->size + int(pending.size());
+
+  std::vector<double> column(2 * nbSeries);
+  int nbMerged = 0;
+  double x0 = 0, x1 = 0;
+  for (int i = 0; i < nbBuckets; i++)
+  {
+    double b0, b1;
+    const double* b;
+    if (i < level->size)
+    {
+      const int j = level->index(i);
+      b0 = level->xMin[j];
+      b1 = level->xMax[j];
+      b = &level->y[2 * nbSeries * j];
+    }
+    else
+    {
+      const Level* below = pending[i - level->size];
+      b0 = below->pendingXMin;
+      b1 = below->pendingXMax;
+      b = &below->pendingY[0];
+    }
+    if (nbBuckets <= nbColumns)
+    {
+      append(xs, ys, b0, b1, b);
+      continue;
+    }
+    // Column c merges the buckets [c n / nbColumns, (c + 1) n / nbColumns)
+    if (nbMerged == 0)
+    {
+      x0 = b0;
+      std::copy(b, b + 2 * nbSeries, column.begin());
+    }
+    else
+    {
+      for (int s = 0; s < nbSeries; s++)
+      {
+        column[s] = std::min(column[s], b[s]);
+        column[nbSeries + s] = std::max(column[nbSeries + s], b[nbSeries + s]);
+      }
+    }
+    x1 = b1;
+    ++nbMerged;
+    const int c = int((long(i) * nbColumns) / nbBuckets);
+    const int next = int((long(i + 1) * nbColumns) / nbBuckets);
+    if (next != c || i + 1 == nbBuckets)
+    {
+      append(xs, ys, x0, x1, &column[0]);
+      nbMerged = 0;
+    }
+  }
+  return k;
+}
+
+void PlotData::append(std::vector<double>& xs, std::vector<std::vector<double> >& ys,
+    const double& x0, const double& x1, const double* yMinMax) const
+{
+  // A raw point, or the vertical min/max stroke at the middle of the column
+  const double x = 0.5 * (x0 + x1);
+  bool single = (x0 == x1);
+  for (int s = 0; s < nbSeries && single; s++)
+    single = (yMinMax[s] == yMinMax[nbSeries + s]);
+  xs.push_back(x);
+  for (int s = 0; s < nbSeries; s++)
+    ys[s].push_back(yMinMax[s]);
+  if (single)
+    return;
+  xs.push_back(x);
+  for (int s = 0; s < nbSeries; s++)
+    ys[s].push_back(yMinMax[nbSeries + s]);
+}
+
+bool PlotData::spill(const char* f)
+{
+  closeSpill();
+  spillFile = new std::ofstream(f, std::ios::binary);
+  if (!spillFile->is_open())
+  {
+    std::cerr << "ERROR! (spill) file=" << f << std::endl;
+    delete spillFile;
+    spillFile = 0;
+    return false;
+  }
+  const int32_t header = nbSeries;
+  spillFile->write(reinterpret_cast<const char*>(&header), sizeof(header));
+  return true;
+}
+
+void PlotData::closeSpill()
+{
+  if (!spillFile)
+    return;
+  spillFile->close();
+  delete spillFile;
+  spillFile = 0;
+}
+
+long PlotData::getNbPoints() const
+{
+  return nbPoints;
+}
+
+int PlotData::getNbSeries() const
+{
+  return nbSeries;
+}
+
+int PlotData::getNbLevels() const
+{
+  return int(levels.size());
+}
@@ -0,0 +1,89 @@
+/*
+ * PlotData.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: sam
+ */
+
+#ifndef PLOTDATA_H_
+#define PLOTDATA_H_
+
+#include <vector>
+#include <fstream>
+
+namespace RLLibViz
+{
+
+/**
+ * The points of a plot, x and one y per series, in bounded memory. Level 0 is a ring buffer of
+ * the last capacity points; a bucket of level k + 1 holds the x range and the y min/max of factor
+ * consecutive buckets of level k. Each level is a ring buffer of capacity buckets, hence the
+ * history at the coarsest level spans capacity * factor^(nbLevels - 1) points.
+ *
+ * decimate() hands over at most 2 points per column and per series, the min and the max, from
+ * the finest level that still holds the whole history. The full resolution stream is optionally
+ * spilled to a binary file: int32 nbSeries, then x and the ys as doubles, per point.
+ */
+class PlotData
+{
+  protected:
+    class Level
+    {
+      public:
+        int capacity;
+        int nbSeries;
+        int head;
+        int size;
+        long nbPushed;
+        // Per bucket; y: nbSeries min then nbSeries max
+        std::vector<double> xMin;
+        std::vector<double> xMax;
+        std::vector<double> y;
+        // Bucket of the level above, being filled from this level
+        int pendingCount;
+        double pendingXMin;
+        double pendingXMax;
+        std::vector<double> pendingY;
+
+        Level(const int& capacity, const int& nbSeries);
+        void push(const double& x0, const double& x1, const double* yMinMax);
+        int index(const int& i) const;
+    };
+
+    int nbSeries;
+    int capacity;
+    int factor;
+    std::vector<Level*> levels;
+    long nbPoints;
+    std::vector<double> bucket;
+    std::ofstream* spillFile;
+
+  public:
+    PlotData(const int& nbSeries, const int& capacity = 4096, const int& factor = 4,
+        const int& nbLevels = 10);
+    virtual ~PlotData();
+
+    void add(const double& x, const double* ys);
+    void add(const double& x, const double& y0, const double& y1);
+    void clear();
+
+    // xs is shared by the series; returns the level the points come from
+    int decimate(const int& nbColumns, std::vector<double>& xs,
+        std::vector<std::vector<double> >& ys) const;
+
+    bool spill(const char* f);
+    void closeSpill();
+
+    long getNbPoints() const;
+    int getNbSeries() const;
+    int getNbLevels() const;
+
+  protected:
+    void push(const int& k, const double& x0, const double& x1, const double* yMinMax);
+    void append(std::vector<double>& xs, std::vector<std::vector<double> >& ys, const double& x0,
+        const double& x1, const double* yMinMax) const;
+};
+
+}  // namespace RLLibViz
+
+#endif /* PLOTDATA_H_ */
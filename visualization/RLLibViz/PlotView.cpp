@@ -7,30 +7,23 @@
 
 #include "PlotView.h"
 
+#include <algorithm>
+
 using namespace RLLibViz;
 
 PlotView::PlotView(const QString& title, QWidget* parent) :
-    ViewBase(parent), y2MinAvg(0), y2MaxAvg(0)
+    ViewBase(parent), plotData(new PlotData(2)), nbEpisodes(0)
 {
   grid = new QHBoxLayout(this);
   plot = new QCustomPlot(this);
   plot->setGeometry(0, 0, sizeHint().width(), sizeHint().height());
   grid->addWidget(plot);
 
-  xR1.resize(sizeHint().width());
-  for (int i = 0; i < xR1.size(); i++)
-    xR1[i] = i - (xR1.size() - 1);
-
   globalColors.push_back(Qt::darkRed);
   globalColors.push_back(Qt::darkGreen);
 
   for (int i = 0; i < 2; i++)
-  {
     yR2.push_back(QVector<double>());
-    yR2[i].resize(sizeHint().width());
-    for (int j = 0; j < sizeHint().width(); j++)
-      yR2[i][j] = 0.0f;
-  }
 
   // create graph and assign data to it:
   for (int i = 0; i < 2; i++)
@@ -52,28 +45,32 @@ PlotView::~PlotView()
 {
   delete grid;
   delete plot;
+  delete plotData;
 }
 
 void PlotView::initialize()
 {
 }
 
+bool PlotView::spill(const QString& fileName)
+{
+  return plotData->spill(fileName.toStdString().c_str());
+}
+
 void PlotView::draw(QWidget* that)
 {
   if (this != that)
     return;
 
+  // At most a min and a max per pixel column, whatever the length of the session
+  plotData->decimate(std::max(1, plot->axisRect()->width()), xs, ys);
+  xR1.resize(int(xs.size()));
+  std::copy(xs.begin(), xs.end(), xR1.begin());
   for (int i = 0; i < 2; i++)
   {
+    yR2[i].resize(int(ys[i].size()));
+    std::copy(ys[i].begin(), ys[i].end(), yR2[i].begin());
     plot->graph(i)->setData(xR1, yR2[i]);
-    plot->graph(i)->rescaleAxes();
-    plot->xAxis->setRange(xR1[0], xR1[xR1.size() - 1]);
-    plot->xAxis2->setRange(xR1[0], xR1[xR1.size() - 1]);
-    plot->yAxis->setRange(yR2[0][0], yR2[0][yR2[0].size() - 1]);
-
-    y2MinAvg += 0.01 * (yR2[1][0] - y2MinAvg);
-    y2MaxAvg += 0.01 * (yR2[1][yR2[1].size() - 1] - y2MaxAvg);
-    plot->yAxis2->setRange(std::ceil(y2MinAvg), std::ceil(y2MaxAvg));
   }
 
   plot->rescaleAxes();
@@ -85,18 +82,7 @@ void PlotView::add(QWidget* that, const Vec& graphOneP, const Vec& graphTwoP)
   if (this != that)
     return;
 
-  // O(N)
-  for (size_t i = 0; i < yR2.size(); i++)
-  {
-    for (int j = 1; j < yR2[i].size(); j++)
-      yR2[i][j - 1] = yR2[i][j];
-  }
-
-  yR2[0][yR2[0].size() - 1] = graphOneP.x;
-  yR2[1][yR2[1].size() - 1] = graphTwoP.x;
-  for (int i = 1; i < xR1.size(); i++)
-    xR1[i - 1] = xR1[i];
-  ++xR1[xR1.size() - 1];
+  plotData->add(++nbEpisodes, graphOneP.x, graphTwoP.x);
 }
 
 void PlotView::add(QWidget* that, const MatrixXd& mat)
@@ -16,6 +16,7 @@
 #include <QString>
 #include "ViewBase.h"
 #include "Mat.h"
+#include "PlotData.h"
 #include "plot/qcustomplot.h"
 
 namespace RLLibViz
@@ -27,18 +28,21 @@ class PlotView: public ViewBase
   private:
     QHBoxLayout* grid;
     QCustomPlot* plot;
+    // Every point since the start, decimated to the width of the plot on draw
+    PlotData* plotData;
+    double nbEpisodes;
+    std::vector<double> xs;
+    std::vector<std::vector<double> > ys;
     QVector<double> xR1;
     std::vector<QVector<double> > yR2;
-    Vec graphOne;
-    Vec graphTwo;
     std::vector<Qt::GlobalColor> globalColors;
-    double y2MinAvg;
-    double y2MaxAvg;
 
   public:
     PlotView(const QString& title, QWidget *parent = 0);
     virtual ~PlotView();
     void initialize();
+    // Full resolution stream of the points, as doubles (episode, steps, rewards)
+    bool spill(const QString& fileName);
 
   public slots:
     void add(QWidget* that, const Vec& p1, const Vec& p2);
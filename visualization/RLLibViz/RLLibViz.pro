@@ -23,6 +23,7 @@ SOURCES += main.cpp\
     MountainCarModel.cpp \
     MountainCarView.cpp \
     PlotView.cpp \
+    PlotData.cpp \
     ValueFunctionView.cpp \
     ModelBase.cpp \
     ViewBase.cpp \
@@ -53,6 +54,7 @@ HEADERS  += \
     MountainCarView.h \
     NULLView.h \
     PlotView.h \
+    PlotData.h \
     ValueFunctionView.h \
     ModelBase.h \
     ViewBase.h \